@@ -0,0 +1,11 @@
+#!/bin/sh -e
+
+BASEDIR=$(realpath "$(dirname "$0")")
+ROOTDIR=$(realpath "$BASEDIR/..")
+
+if [ "$#" -ne 0 ] && [ "$#" -ne 3 ]; then
+    echo "Usage: $0 [<width> <height> <threads>]"
+    exit 1
+fi
+
+"$ROOTDIR/build/tests/channels_benchmark" "$@"
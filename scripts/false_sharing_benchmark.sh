@@ -0,0 +1,34 @@
+#!/bin/sh -e
+
+BASEDIR=$(realpath "$(dirname "$0")")
+ROOTDIR=$(realpath "$BASEDIR/..")
+BENCHMARK="$ROOTDIR/build/tests/false_sharing_benchmark"
+
+if [ "$#" -ne 0 ] && [ "$#" -ne 3 ]; then
+    echo "Usage: $0 [<width> <height> <threads>]"
+    exit 1
+fi
+
+"$BENCHMARK" "$@"
+
+# HITM events (loads of lines modified by another core) need `perf c2c`
+if ! command -v perf > /dev/null; then
+    echo "perf not found, skipping the HITM report"
+    exit 0
+fi
+
+WIDTH=${1:-1000}
+HEIGHT=${2:-1000}
+THREADS=${3:-4}
+DATA=$(mktemp)
+trap 'rm -f "$DATA"' EXIT
+
+for MODE in pixel column; do
+    for OWN_LINES in 0 1; do
+        echo "HITM of $MODE mode with own lines = $OWN_LINES:"
+        perf c2c record -o "$DATA" -- \
+            "$BENCHMARK" "$WIDTH" "$HEIGHT" "$THREADS" "$MODE" "$OWN_LINES" \
+            > /dev/null
+        perf c2c report -i "$DATA" --stats --stdio | grep -i "hitm" || true
+    done
+done
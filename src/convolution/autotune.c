@@ -0,0 +1,337 @@
+#include "autotune.h"
+#include "../utils/thread_pool.h"
+#include "dispatch.h"
+#include "parallel_dispatch.h"
+
+#include <errno.h>
+#include <math.h>
+#include <sys/stat.h>
+
+#define CPUINFO_PATH "/proc/cpuinfo"
+#define PROFILE_LINE_LEN 512
+#define PROFILE_FIELDS 9
+#define PROFILE_DIR_ACCESS_RIGHTS 0755
+
+static const char *const autotune_modes[] = {"row", "column", "pixel", "block"};
+
+/**
+ * A candidate shape of the blocks, with `0` x `0` for the blocks of the mode.
+ */
+static const struct {
+	const char *mode;
+	int block_width;
+	int block_height;
+} candidates[] = {
+	{"row", 0, 0},	  {"column", 0, 0},	  {"pixel", 0, 0},
+	{"block", 0, 0},  {"block", 64, 64},  {"block", 256, 32},
+};
+
+// Reads the model name of the CPU, or "unknown"
+static void read_cpu_model(char *model, size_t size) {
+	snprintf(model, size, "unknown");
+
+	FILE *file = fopen(CPUINFO_PATH, "r");
+	if (file == NULL) {
+		return;
+	}
+
+	char line[PROFILE_LINE_LEN];
+	while (fgets(line, sizeof(line), file) != NULL) {
+		char *value = strchr(line, ':');
+
+		if (strncmp(line, "model name", strlen("model name")) == 0 && value) {
+			value += strspn(value + 1, " \t") + 1;
+			value[strcspn(value, "\n")] = '\0';
+			snprintf(model, size, "%s", value);
+			break;
+		}
+	}
+	fclose(file);
+
+	// Tabs separate the fields of the profile
+	for (char *c = model; *c != '\0'; c++) {
+		if (*c == '\t') {
+			*c = ' ';
+		}
+	}
+}
+
+void make_autotune_key(const struct filter *filter, int width, int height,
+					   int max_threads, struct autotune_key *key) {
+	read_cpu_model(key->cpu_model, sizeof(key->cpu_model));
+
+	enum filter_engine engine = choose_engine(filter, (size_t)width, (size_t)height);
+	snprintf(key->kernel_class, sizeof(key->kernel_class), "%s-%dx%d",
+			 filter_engine_name(engine), filter->size, filter->size);
+
+	size_t pixels = (size_t)width * (size_t)height;
+	key->size_bucket = 0;
+	while (pixels > 1) {
+		pixels >>= 1;
+		key->size_bucket++;
+	}
+
+	key->max_threads = max_threads;
+}
+
+int autotune_default_profile(char *path, size_t size) {
+	const char *cache = getenv("XDG_CACHE_HOME");
+	const char *home = getenv("HOME");
+	int length;
+
+	if (cache != NULL && cache[0] != '\0') {
+		length = snprintf(path, size, "%s/" AUTOTUNE_PROFILE_NAME, cache);
+	} else if (home != NULL && home[0] != '\0') {
+		length = snprintf(path, size, "%s/.cache/" AUTOTUNE_PROFILE_NAME, home);
+	} else {
+		return -1;
+	}
+
+	return length >= 0 && (size_t)length < size ? 0 : -1;
+}
+
+// Splits a line of the profile into its tab-separated fields
+static int split_fields(char *line, char **fields, int max_fields) {
+	line[strcspn(line, "\n")] = '\0';
+
+	int count = 0;
+	while (count < max_fields) {
+		fields[count++] = line;
+
+		char *tab = strchr(line, '\t');
+		if (tab == NULL) {
+			break;
+		}
+		*tab = '\0';
+		line = tab + 1;
+	}
+
+	return count;
+}
+
+bool load_autotune_config(const char *path, const struct autotune_key *key,
+						  struct autotune_config *config) {
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		return false;
+	}
+
+	bool found = false;
+	char line[PROFILE_LINE_LEN];
+
+	while (fgets(line, sizeof(line), file) != NULL) {
+		char *fields[PROFILE_FIELDS];
+
+		if (line[0] == '#' ||
+			split_fields(line, fields, PROFILE_FIELDS) != PROFILE_FIELDS ||
+			strcmp(fields[0], key->cpu_model) != 0 ||
+			strcmp(fields[1], key->kernel_class) != 0 ||
+			atoi(fields[2]) != key->size_bucket ||
+			atoi(fields[3]) != key->max_threads) {
+			continue;
+		}
+
+		for (size_t i = 0; i < sizeof(autotune_modes) / sizeof(autotune_modes[0]);
+			 i++) {
+			if (strcmp(fields[4], autotune_modes[i]) == 0) {
+				*config = (struct autotune_config){
+					.mode = autotune_modes[i],
+					.num_threads = atoi(fields[5]),
+					.block_width = atoi(fields[6]),
+					.block_height = atoi(fields[7]),
+					.seconds = atof(fields[8]),
+				};
+				found = config->num_threads > 0 && config->block_width >= 0 &&
+						config->block_height >= 0;
+			}
+		}
+	}
+	fclose(file);
+
+	return found;
+}
+
+// Creates the missing directories of a path, like `mkdir -p` of its parent
+static int make_parent_dirs(const char *path) {
+	char dir[PROFILE_LINE_LEN];
+	if (snprintf(dir, sizeof(dir), "%s", path) >= (int)sizeof(dir)) {
+		return -1;
+	}
+
+	for (char *slash = strchr(dir + 1, '/'); slash != NULL;
+		 slash = strchr(slash + 1, '/')) {
+		*slash = '\0';
+		if (mkdir(dir, PROFILE_DIR_ACCESS_RIGHTS) != 0 && errno != EEXIST) {
+			return -1;
+		}
+		*slash = '/';
+	}
+
+	return 0;
+}
+
+int save_autotune_config(const char *path, const struct autotune_key *key,
+						 const struct autotune_config *config) {
+	if (make_parent_dirs(path) != 0) {
+		return -1;
+	}
+
+	FILE *file = fopen(path, "a");
+	if (file == NULL) {
+		return -1;
+	}
+
+	if (ftell(file) == 0) {
+		fprintf(file, "# cpu model\tkernel class\tsize bucket\tmax threads\tmode\t"
+					  "threads\tblock width\tblock height\tseconds\n");
+	}
+	fprintf(file, "%s\t%s\t%d\t%d\t%s\t%d\t%d\t%d\t%.6f\n", key->cpu_model,
+			key->kernel_class, key->size_bucket, key->max_threads, config->mode,
+			config->num_threads, config->block_width, config->block_height,
+			config->seconds);
+
+	return fclose(file) == 0 ? 0 : -1;
+}
+
+// Computes the blocks a configuration splits an image into, as the modes do
+static void candidate_block_size(const struct autotune_config *config, int width,
+								 int height, int *block_width, int *block_height) {
+	*block_width = width;
+	*block_height = height;
+
+	if (strcmp(config->mode, "row") == 0) {
+		*block_height = 1;
+	} else if (strcmp(config->mode, "column") == 0) {
+		*block_width = 1;
+	} else if (strcmp(config->mode, "pixel") == 0) {
+		*block_width = 1;
+		*block_height = 1;
+	} else if (config->block_width > 0) {
+		*block_width = min(config->block_width, width);
+		*block_height = min(config->block_height, height);
+	} else {
+		*block_width = (width + config->num_threads - 1) / config->num_threads;
+		*block_height = (height + config->num_threads - 1) / config->num_threads;
+	}
+}
+
+// Times the fastest of `AUTOTUNE_RUNS` runs of a configuration
+static double time_candidate(const struct autotune_config *config,
+							 struct image_rgb *input, struct image_rgb *output,
+							 int width, int height, const struct filter *filter) {
+	int block_width, block_height;
+	candidate_block_size(config, width, height, &block_width, &block_height);
+
+	double best = INFINITY;
+	for (int run = 0; run < AUTOTUNE_RUNS; run++) {
+		double start_time = get_time_in_seconds();
+
+		if (parallel_block_sized(input, output, width, height, *filter,
+								 config->num_threads, block_width,
+								 block_height) != 0) {
+			return -1;
+		}
+		best = min(best, get_time_in_seconds() - start_time);
+	}
+
+	return best;
+}
+
+// Times the candidates with a number of threads, keeping the fastest in `best`
+static int time_candidates(int num_threads, struct image_rgb *input,
+						   struct image_rgb *output, int width, int height,
+						   const struct filter *filter,
+						   struct autotune_config *best) {
+	for (size_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); i++) {
+		struct autotune_config candidate = {
+			.mode = candidates[i].mode,
+			.num_threads = num_threads,
+			.block_width = candidates[i].block_width,
+			.block_height = candidates[i].block_height,
+		};
+
+		candidate.seconds =
+			time_candidate(&candidate, input, output, width, height, filter);
+		if (candidate.seconds < 0) {
+			return -1;
+		}
+		if (candidate.seconds < best->seconds) {
+			*best = candidate;
+		}
+	}
+
+	return 0;
+}
+
+int benchmark_autotune_candidates(const struct filter *filter, int width,
+								  int height, int max_threads,
+								  struct autotune_config *config) {
+	// Rows are left out rather than columns, so the lines of the rows stay the same
+	max_threads = max(max_threads, 1);
+	int tuned_height = min(height, max(1, AUTOTUNE_MAX_PIXELS / max(width, 1)));
+	struct image_rgb input = initialize_image_rgb(width, tuned_height);
+	struct image_rgb output = initialize_image_rgb(width, tuned_height);
+
+	if (input.red == NULL || output.red == NULL ||
+		thread_pool_reserve(max_threads - 1) != 0) {
+		error("Memory allocation error for the autotuner images.\n");
+		free_image_rgb(&input);
+		free_image_rgb(&output);
+		return -1;
+	}
+
+	// A fixed pseudo-random image, the same for all candidates
+	unsigned int state = 1;
+	for (size_t y = 0; y < (size_t)tuned_height; y++) {
+		for (size_t i = y * input.stride; i < y * input.stride + width; i++) {
+			state = state * 1103515245u + 12345u;
+			input.red[i] = (unsigned char)(state >> 16);
+			input.green[i] = (unsigned char)(state >> 20);
+			input.blue[i] = (unsigned char)(state >> 24);
+		}
+	}
+
+	*config = (struct autotune_config){.mode = NULL, .seconds = INFINITY};
+
+	int status = 0;
+	int threads = 1;
+	while (status == 0) {
+		status = time_candidates(threads, &input, &output, width, tuned_height,
+								 filter, config);
+		if (threads == max_threads) {
+			break;
+		}
+		threads = min(threads * 2, max_threads);
+	}
+
+	free_image_rgb(&input);
+	free_image_rgb(&output);
+
+	return config->mode != NULL ? status : -1;
+}
+
+int autotune(const char *profile_path, const struct filter *filter, int width,
+			 int height, int max_threads, struct autotune_config *config,
+			 bool *cached) {
+	struct autotune_key key;
+	make_autotune_key(filter, width, height, max_threads, &key);
+
+	*cached =
+		profile_path != NULL && load_autotune_config(profile_path, &key, config);
+	if (*cached) {
+		return 0;
+	}
+
+	if (benchmark_autotune_candidates(filter, width, height, max_threads, config) !=
+		0) {
+		return -1;
+	}
+
+	// The configuration is still used if it cannot be stored
+	if (profile_path != NULL &&
+		save_autotune_config(profile_path, &key, config) != 0) {
+		error("Could not save the autotuner profile '%s'.\n", profile_path);
+	}
+
+	return 0;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "filter_application.h"
+
+#define AUTOTUNE_MAX_PIXELS (1 << 21) // Largest synthetic image candidates run on
+#define AUTOTUNE_RUNS 3				  // Runs of each candidate, the fastest counts
+#define AUTOTUNE_FIELD_LEN 128		  // Longest CPU model or kernel class kept
+#define AUTOTUNE_PROFILE_NAME "image-convolution/autotune.profile"
+
+/**
+ * Identifies the images and filters that share a tuned configuration on a machine.
+ *
+ * @param cpu_model Model name of the CPU, from `/proc/cpuinfo`.
+ * @param kernel_class Engine applying the filter to the whole image and size of the
+ * kernel, e.g. `fixed-5x5`.
+ * @param size_bucket Binary logarithm of the number of pixels, rounded down.
+ * @param max_threads Most threads a configuration may use.
+ */
+struct autotune_key {
+	char cpu_model[AUTOTUNE_FIELD_LEN];
+	char kernel_class[AUTOTUNE_FIELD_LEN];
+	int size_bucket;
+	int max_threads;
+};
+
+/**
+ * A configuration of the parallel modes.
+ *
+ * @param mode Name of the mode: "row", "column", "block" or "pixel".
+ * @param num_threads Number of threads.
+ * @param block_width Width of the blocks of "block" mode, `0` for those of
+ * `parallel_block()`.
+ * @param block_height Height of the blocks of "block" mode, `0` for those of
+ * `parallel_block()`.
+ * @param seconds Fastest time of the configuration on the synthetic image.
+ */
+struct autotune_config {
+	const char *mode;
+	int num_threads;
+	int block_width;
+	int block_height;
+	double seconds;
+};
+
+/**
+ * Computes the key under which the configuration tuned for a filter and an image
+ * size is stored.
+ *
+ * @param filter The convolution filter.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param max_threads Most threads a configuration may use.
+ * @param key Receives the key.
+ */
+void make_autotune_key(const struct filter *filter, int width, int height,
+					   int max_threads, struct autotune_key *key);
+
+/**
+ * Builds the path of the profile of the machine: `AUTOTUNE_PROFILE_NAME` in
+ * `$XDG_CACHE_HOME`, or else in `$HOME/.cache`.
+ *
+ * @param path Receives the path.
+ * @param size Size of `path`.
+ *
+ * @return `0` on success, `-1` if neither variable is set or the path is too long.
+ */
+int autotune_default_profile(char *path, size_t size);
+
+/**
+ * Looks up the configuration stored under a key in a profile. When the key was
+ * stored several times, the last configuration wins.
+ *
+ * @param path Path to the profile.
+ * @param key The key.
+ * @param config Receives the configuration.
+ *
+ * @return `true` if the profile holds the key.
+ */
+bool load_autotune_config(const char *path, const struct autotune_key *key,
+						  struct autotune_config *config);
+
+/**
+ * Appends a configuration to a profile under a key, creating the profile and its
+ * directories if needed. Each line of the profile holds one key and its
+ * configuration, in tab-separated fields.
+ *
+ * @param path Path to the profile.
+ * @param key The key.
+ * @param config The configuration.
+ *
+ * @return `0` on success, `-1` if the profile cannot be written.
+ */
+int save_autotune_config(const char *path, const struct autotune_key *key,
+						 const struct autotune_config *config);
+
+/**
+ * Times the candidate configurations on a synthetic image of the given size,
+ * reduced to at most `AUTOTUNE_MAX_PIXELS` pixels by leaving out rows: the row,
+ * column, pixel and block modes, and blocks of a few fixed sizes, each with 1, 2,
+ * 4, ... and `max_threads` threads. Ties go to the candidate with fewer threads.
+ *
+ * @param filter The convolution filter.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param max_threads Most threads a configuration may use.
+ * @param config Receives the fastest configuration.
+ *
+ * @return `0` on success, `-1` if memory allocation or a run fails.
+ */
+int benchmark_autotune_candidates(const struct filter *filter, int width,
+								  int height, int max_threads,
+								  struct autotune_config *config);
+
+/**
+ * Finds the fastest configuration for a filter and an image size: from the profile
+ * if it holds its key (see `make_autotune_key()`), otherwise by timing the
+ * candidates with `benchmark_autotune_candidates()` and storing the winner in the
+ * profile.
+ *
+ * @param profile_path Path to the profile, `NULL` to always time the candidates.
+ * @param filter The convolution filter.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param max_threads Most threads a configuration may use.
+ * @param config Receives the configuration.
+ * @param cached Receives whether the configuration came from the profile.
+ *
+ * @return `0` on success, `-1` if the candidates cannot be timed.
+ */
+int autotune(const char *profile_path, const struct filter *filter, int width,
+			 int height, int max_threads, struct autotune_config *config,
+			 bool *cached);
@@ -0,0 +1,103 @@
+#include "border.h"
+
+size_t border_position(ptrdiff_t position, size_t length, enum border_mode border) {
+	switch (border) {
+		case BORDER_CLAMP:
+			return position < 0 ? 0 : min((size_t)position, length - 1);
+		case BORDER_MIRROR: {
+			// The image and its mirror image repeat every `2 * length` pixels
+			size_t mirrored = wrap_position(position, 2 * length);
+			return mirrored < length ? mirrored : 2 * length - 1 - mirrored;
+		}
+		default:
+			return wrap_position(position, length);
+	}
+}
+
+// Returns the value a tap at column `x` of a row of the image reads
+static inline unsigned char border_value(const unsigned char *row, ptrdiff_t x,
+										 size_t width, enum border_mode border) {
+	if (border == BORDER_CONSTANT) {
+		return BORDER_CONSTANT_VALUE;
+	}
+	return row[border_position(x, width, border)];
+}
+
+void fill_row_border(unsigned char *row, int width, int halo,
+					 enum border_mode border) {
+	for (ptrdiff_t x = -halo; x < 0; x++) {
+		row[x] = border_value(row, x, width, border);
+	}
+	for (ptrdiff_t x = width; x < width + halo; x++) {
+		row[x] = border_value(row, x, width, border);
+	}
+}
+
+void fill_border(struct image_rgb *image, int width, int height,
+				 enum border_mode border) {
+	ptrdiff_t halo = image->halo;
+	ptrdiff_t stride = (ptrdiff_t)image->stride;
+	unsigned char *channels[] = {image->red, image->green, image->blue};
+
+	if (halo == 0 || width <= 0 || height <= 0) {
+		return;
+	}
+
+	for (int c = 0; c < 3; c++) {
+		unsigned char *channel = channels[c];
+
+		// The halo left and right of the rows of the image
+		for (ptrdiff_t y = 0; y < height; y++) {
+			fill_row_border(channel + y * stride, width, (int)halo, border);
+		}
+
+		// The rows above and below, corners included, from the rows just filled
+		for (ptrdiff_t y = -halo; y < height + halo; y++) {
+			unsigned char *row = channel + y * stride - halo;
+
+			if (y >= 0 && y < height) {
+				continue;
+			}
+
+			if (border == BORDER_CONSTANT) {
+				memset(row, BORDER_CONSTANT_VALUE, width + 2 * halo);
+			} else {
+				ptrdiff_t source = (ptrdiff_t)border_position(y, height, border);
+				memcpy(row, channel + source * stride - halo, width + 2 * halo);
+			}
+		}
+	}
+}
+
+struct image_rgb *border_input(struct image_rgb *input, int width, int height,
+							   const struct filter *filter,
+							   struct image_rgb *padded) {
+	int radius = filter->size / 2;
+
+	if (input->halo >= radius) {
+		fill_border(input, width, height, filter->border);
+		return input;
+	}
+
+	if (filter->border == BORDER_WRAP) {
+		return input;
+	}
+
+	*padded = initialize_padded_image_rgb(width, height, radius);
+	if (padded->red == NULL) {
+		error("Memory allocation error for the padded image.\n");
+		return NULL;
+	}
+
+	for (size_t y = 0; y < (size_t)height; y++) {
+		memcpy(padded->red + y * padded->stride, input->red + y * input->stride,
+			   width);
+		memcpy(padded->green + y * padded->stride, input->green + y * input->stride,
+			   width);
+		memcpy(padded->blue + y * padded->stride, input->blue + y * input->stride,
+			   width);
+	}
+	fill_border(padded, width, height, filter->border);
+
+	return padded;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "filter_application.h"
+
+/**
+ * Maps a row or column that may lie outside the image to the one a tap reads there
+ * in a border mode other than `BORDER_CONSTANT` (see `enum border_mode`).
+ *
+ * @param position The coordinate, possibly negative or past the end.
+ * @param length Width or height of the image.
+ * @param border The border mode.
+ *
+ * @return The coordinate in `[0, length)`.
+ */
+size_t border_position(ptrdiff_t position, size_t length, enum border_mode border);
+
+/**
+ * Fills the `halo` pixels left and right of a row with the pixels that taps outside
+ * the row read in a border mode. The halo may be wider than the row.
+ *
+ * @param row The first pixel of the row, preceded and followed by `halo` pixels.
+ * @param width Width of the row.
+ * @param halo Number of pixels to fill on each side.
+ * @param border The border mode.
+ */
+void fill_row_border(unsigned char *row, int width, int halo,
+					 enum border_mode border);
+
+/**
+ * Fills the halo of an image allocated with `initialize_padded_image_rgb()` with
+ * the pixels that taps outside the image read in a border mode, so that the taps
+ * of filters reaching at most `halo` pixels outside of it are read without any
+ * wrapping or bounds check. The halo may be wider than the image.
+ *
+ * @param image The image.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param border The border mode.
+ */
+void fill_border(struct image_rgb *image, int width, int height,
+				 enum border_mode border);
+
+/**
+ * Prepares the input of a filter for the engines, once before the filter is applied
+ * to the whole image. The halo of an input with one at least as wide as the radius
+ * of the filter is filled with the border mode of the filter by `fill_border()`.
+ * Without such a halo the engines wrap the taps around the image themselves, which
+ * is `BORDER_WRAP`, and in the other modes the input is copied to `padded`, a new
+ * image with a halo of the radius of the filter.
+ *
+ * @param input The input image.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param filter The filter to be applied.
+ * @param padded Receives the padded copy if one is made, to be freed with
+ * `free_image_rgb()` after the filter is applied. It is left untouched otherwise.
+ *
+ * @return The image the filter reads, `input` or `padded`, or `NULL` if memory
+ * allocation fails.
+ */
+struct image_rgb *border_input(struct image_rgb *input, int width, int height,
+							   const struct filter *filter,
+							   struct image_rgb *padded);
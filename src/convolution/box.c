@@ -0,0 +1,293 @@
+#include "box.h"
+#include "../utils/thread_pool.h"
+
+/**
+ * Represents the data passed to each thread building a band of the summed-area
+ * tables of an image.
+ *
+ * @param sums The tables.
+ * @param input_image The input image.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param radius Radius of the filter, `size / 2`.
+ * @param first First row (first pass) or column (second pass) of the band.
+ * @param last Row or column after the last one of the band.
+ * @param accumulate Whether the band accumulates columns of rows already summed.
+ */
+struct box_sums_data {
+	struct box_sums *sums;
+	const struct image_rgb *input_image;
+	int width;
+	int height;
+	int radius;
+	size_t first;
+	size_t last;
+	bool accumulate;
+};
+
+// Maps the row or column of a tap to the one it is read from, like `tap_position()`
+static inline ptrdiff_t source_position(const struct image_rgb *input_image,
+										int radius, ptrdiff_t position,
+										size_t length) {
+	if (input_image->halo >= radius ||
+		(position >= 0 && position < (ptrdiff_t)length)) {
+		return position;
+	}
+	return (ptrdiff_t)wrap_position(position, length);
+}
+
+// Sums the input rows of a band of table rows, or accumulates the rows of a band of
+// table columns from the top of the tables down.
+static void *build_band(void *arg) {
+	struct box_sums_data *band = (struct box_sums_data *)arg;
+	const struct image_rgb *input = band->input_image;
+	struct box_sums *sums = band->sums;
+	const unsigned char *inputs[] = {input->red, input->green, input->blue};
+	uint32_t *tables[] = {sums->red, sums->green, sums->blue};
+
+	for (int c = 0; c < 3; c++) {
+		uint32_t *table = tables[c];
+
+		if (band->accumulate) {
+			for (size_t y = 1; y < sums->rows; y++) {
+				uint32_t *row = table + y * sums->stride;
+
+				for (size_t x = band->first; x < band->last; x++) {
+					row[x] += row[x - sums->stride];
+				}
+			}
+			continue;
+		}
+
+		for (size_t y = band->first; y < band->last; y++) {
+			uint32_t *row = table + y * sums->stride;
+
+			// Row 0 of the tables sums no input row
+			if (y == 0) {
+				memset(row, 0, sums->stride * sizeof(uint32_t));
+				continue;
+			}
+
+			ptrdiff_t input_row = source_position(
+				input, band->radius, (ptrdiff_t)y - 1 - band->radius, band->height);
+			const unsigned char *line =
+				inputs[c] + input_row * (ptrdiff_t)input->stride;
+			uint32_t sum = 0;
+			row[0] = 0;
+
+			for (size_t x = 1; x < sums->stride; x++) {
+				sum += line[source_position(input, band->radius,
+											(ptrdiff_t)x - 1 - band->radius,
+											band->width)];
+				row[x] = sum;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+int build_box_sums(struct box_sums *sums, const struct image_rgb *input_image,
+				   int width, int height, const struct filter *filter,
+				   int num_threads) {
+	size_t stride = (size_t)width + filter->size;
+	size_t rows = (size_t)height + filter->size;
+	size_t table_size = stride * rows;
+
+	uint32_t *data = malloc(3 * table_size * sizeof(uint32_t));
+	if (data == NULL) {
+		error("Memory allocation error for the summed-area tables\n");
+		return -1;
+	}
+
+	*sums = (struct box_sums){.red = data,
+							  .green = data + table_size,
+							  .blue = data + 2 * table_size,
+							  .stride = stride,
+							  .rows = rows};
+
+	// The columns of a band cover whole cache lines, which no other band writes
+	size_t line = CACHE_LINE_SIZE / sizeof(uint32_t);
+	size_t column_lines = (stride + line - 1) / line;
+	num_threads = max(min(num_threads, (int)min(rows, column_lines)), 1);
+
+	struct box_sums_data bands[num_threads];
+	int status = 0;
+
+	for (int pass = 0; pass < 2 && status == 0; pass++) {
+		for (int i = 0; i < num_threads; i++) {
+			bands[i] = (struct box_sums_data){
+				.sums = sums,
+				.input_image = input_image,
+				.width = width,
+				.height = height,
+				.radius = filter->size / 2,
+				.accumulate = pass == 1,
+			};
+
+			if (pass == 0) {
+				bands[i].first = rows * i / num_threads;
+				bands[i].last = rows * (i + 1) / num_threads;
+			} else {
+				bands[i].first = min(column_lines * i / num_threads * line, stride);
+				bands[i].last =
+					min(column_lines * (i + 1) / num_threads * line, stride);
+			}
+		}
+
+		status = thread_pool_run(build_band, bands, sizeof(bands[0]), num_threads);
+	}
+
+	if (status != 0) {
+		free_box_sums(sums);
+	}
+
+	return status;
+}
+
+void free_box_sums(struct box_sums *sums) {
+	free(sums->red);
+	*sums = (struct box_sums){NULL, NULL, NULL, 0, 0};
+}
+
+// Adds `sign` times the `count` pixels of an input row starting at column `first`
+// to the column sums, wrapping around to column 0 at column `wrap`.
+static void add_row(double *sums, const unsigned char *line, ptrdiff_t first,
+					size_t count, ptrdiff_t wrap, double sign) {
+	ptrdiff_t column = first;
+
+	for (size_t i = 0; i < count; i++) {
+		sums[i] += sign * line[column];
+
+		if (++column == wrap) {
+			column = 0;
+		}
+	}
+}
+
+// Writes row `y` of one output channel from the column sums with a sliding window
+// of `size` columns.
+static void slide_window(const struct thread_data *data, const double *sums,
+						 unsigned char *output, size_t y, size_t start_x,
+						 size_t end_x) {
+	const struct filter *filter = &data->filter;
+	double weight = filter->kernel[0];
+	double window = 0.0;
+
+	for (int i = 0; i < filter->size - 1; i++) {
+		window += sums[i];
+	}
+
+	unsigned char *out = output + output_index(data, start_x, y);
+
+	for (size_t x = 0; x < end_x - start_x; x++) {
+		window += sums[x + filter->size - 1];
+		int value = (int)(filter->factor * (weight * window) + filter->bias);
+		out[x] = min(max(value, 0), 255);
+		window -= sums[x];
+	}
+}
+
+// Writes the region of the output from the summed-area tables, four lookups per
+// pixel and channel.
+static void lookup_block(const struct thread_data *data, size_t start_x,
+						 size_t start_y, size_t end_x, size_t end_y) {
+	const struct filter *filter = &data->filter;
+	const struct box_sums *sums = data->box_sums;
+	const uint32_t *tables[] = {sums->red, sums->green, sums->blue};
+	unsigned char *outputs[] = {data->output_image->red, data->output_image->green,
+								data->output_image->blue};
+	double weight = filter->kernel[0];
+	size_t size = filter->size;
+
+	for (int c = 0; c < 3; c++) {
+		for (size_t y = start_y; y < end_y; y++) {
+			const uint32_t *top = tables[c] + y * sums->stride;
+			const uint32_t *bottom = top + size * sums->stride;
+			unsigned char *out = outputs[c] + output_index(data, start_x, y);
+
+			for (size_t x = start_x; x < end_x; x++) {
+				uint32_t window =
+					bottom[x + size] - bottom[x] - top[x + size] + top[x];
+				int value =
+					(int)(filter->factor * (weight * window) + filter->bias);
+				out[x - start_x] = min(max(value, 0), 255);
+			}
+		}
+	}
+}
+
+bool box_block(struct thread_data *data, size_t start_x, size_t start_y,
+			   size_t end_x, size_t end_y) {
+	const struct filter *filter = &data->filter;
+
+	if (data->box_sums != NULL) {
+		lookup_block(data, start_x, start_y, end_x, end_y);
+		return true;
+	}
+
+	// A kernel larger than the image wraps around it more than once, which the
+	// running sums do not reproduce, unless the input has a halo.
+	if (input_halo(data) == 0 &&
+		(filter->size > data->width || filter->size > data->height)) {
+		return false;
+	}
+
+	if (start_x >= end_x || start_y >= end_y) {
+		return true;
+	}
+
+	size_t span = end_x - start_x + filter->size - 1;
+	double *scratch = reserve_scratch(data, 3 * span);
+	if (scratch == NULL) {
+		return false;
+	}
+
+	const unsigned char *inputs[] = {data->input_image->red,
+									 data->input_image->green,
+									 data->input_image->blue};
+	unsigned char *outputs[] = {data->output_image->red, data->output_image->green,
+								data->output_image->blue};
+
+	// The rows only wrap around the image without a halo
+	ptrdiff_t first_column =
+		tap_position(data, (ptrdiff_t)start_x - filter->size / 2, data->width);
+	ptrdiff_t wrap = input_halo(data) > 0 ? PTRDIFF_MAX : data->width;
+	ptrdiff_t top = (ptrdiff_t)start_y - filter->size / 2;
+
+	for (int c = 0; c < 3; c++) {
+		double *sums = scratch + c * span;
+
+		for (size_t i = 0; i < span; i++) {
+			sums[i] = 0.0;
+		}
+
+		for (int i = 0; i < filter->size; i++) {
+			ptrdiff_t row = tap_position(data, top + i, data->height);
+			add_row(sums, inputs[c] + input_index(data, 0, row), first_column, span,
+					wrap, 1.0);
+		}
+	}
+
+	for (size_t y = start_y; y < end_y; y++) {
+		for (int c = 0; c < 3; c++) {
+			double *sums = scratch + c * span;
+
+			slide_window(data, sums, outputs[c], y, start_x, end_x);
+
+			if (y + 1 < end_y) {
+				ptrdiff_t oldest = top + (ptrdiff_t)(y - start_y);
+				ptrdiff_t added =
+					tap_position(data, oldest + filter->size, data->height);
+				ptrdiff_t removed = tap_position(data, oldest, data->height);
+
+				add_row(sums, inputs[c] + input_index(data, 0, added), first_column,
+						span, wrap, 1.0);
+				add_row(sums, inputs[c] + input_index(data, 0, removed),
+						first_column, span, wrap, -1.0);
+			}
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "filter_application.h"
+
+#define BOX_SUMS_MAX_SIZE 4104 // Largest box whose window sums fit in 32 bits
+
+/**
+ * Summed-area tables of the three channels of an image, from which the box engine
+ * computes the window sum of any output pixel with four lookups per channel.
+ * Entry `(x, y)` of a table is the sum of the input pixels in rows
+ * `[-size / 2, y - size / 2)` and columns `[-size / 2, x - size / 2)`, read as the
+ * taps of the filter read them (see `tap_position()`), so the window of output
+ * pixel `(x, y)` is spanned by entries `(x, y)` and `(x + size, y + size)`. The
+ * entries are computed modulo 2^32, which keeps the differences exact for windows
+ * of up to `BOX_SUMS_MAX_SIZE` pixels a side.
+ *
+ * @param red Table of the red channel.
+ * @param green Table of the green channel.
+ * @param blue Table of the blue channel.
+ * @param stride Distance between the rows of each table, `width + size`.
+ * @param rows Number of rows of each table, `height + size`.
+ */
+struct box_sums {
+	uint32_t *red;
+	uint32_t *green;
+	uint32_t *blue;
+	size_t stride;
+	size_t rows;
+};
+
+/**
+ * Builds the summed-area tables of an image for a box filter, once before the filter
+ * is applied to the whole image. The rows of the tables are summed by bands of rows
+ * and then accumulated by bands of columns, each band on a thread of the pool.
+ *
+ * @param sums Receives the tables, to be freed with `free_box_sums()`.
+ * @param input_image The input image, as the engines read it (see
+ * `border_input()`).
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param filter The box filter to be applied.
+ * @param num_threads Number of threads to use.
+ *
+ * @return `0` on success, `-1` if thread creation or memory allocation fails.
+ */
+int build_box_sums(struct box_sums *sums, const struct image_rgb *input_image,
+				   int width, int height, const struct filter *filter,
+				   int num_threads);
+
+/**
+ * Frees the summed-area tables built by `build_box_sums()` and resets them.
+ *
+ * @param sums The tables.
+ */
+void free_box_sums(struct box_sums *sums);
+
+/**
+ * Applies a box filter (`filter.box`) to the output region
+ * `[start_x, end_x) x [start_y, end_y)`. With the summed-area tables of the input
+ * (`data->box_sums`), each output pixel costs four lookups per channel, whatever the
+ * size of the kernel and the shape of the region. Otherwise the region is filtered
+ * with running sums: the thread's scratch buffer keeps, for every column the
+ * region's windows cover, the sum of the `size` input rows around the current
+ * output row; moving to the next row adds one input row and subtracts another, and
+ * each output pixel is a sliding window over these column sums. Setting up the
+ * column sums reads `size` input rows per region, so their cost per pixel only
+ * stays independent of the size of the kernel for regions at least `size` rows
+ * high. All sums are integers, so the result is identical to the one of the direct
+ * application.
+ *
+ * @param data Pointer to the `struct thread_data` describing the images and filter.
+ * @param start_x First column of the region.
+ * @param start_y First row of the region.
+ * @param end_x Column after the last one of the region.
+ * @param end_y Row after the last one of the region.
+ *
+ * @return `true` on success, `false` if the kernel is larger than the image without
+ * summed-area tables or the scratch buffer could not be allocated (nothing is
+ * written in that case).
+ */
+bool box_block(struct thread_data *data, size_t start_x, size_t start_y,
+			   size_t end_x, size_t end_y);
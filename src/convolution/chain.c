@@ -0,0 +1,701 @@
+#include <math.h>
+
+#include "chain.h"
+#include "border.h"
+#include "dispatch.h"
+#include "simd.h"
+#include "../utils/thread_pool.h"
+
+/**
+ * Represents the data passed to each thread applying a chain of filters.
+ *
+ * @param input_image Pointer to the input image.
+ * @param output_image Pointer to the output image.
+ * @param interleaved_input Interleaved (`RGBRGB...`) input pixels, read instead of
+ * `input_image` if not `NULL`.
+ * @param interleaved_output Interleaved output pixels, written instead of
+ * `output_image` if not `NULL`.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param filters The filters of the chain.
+ * @param num_filters Number of filters in the chain.
+ * @param tile_width Width of the output tiles.
+ * @param tile_height Height of the output tiles.
+ * @param num_cols Number of columns of tiles in the image.
+ * @param num_tiles Total number of tiles in the image.
+ * @param next_tile Atomic integer pointer used to assign tiles dynamically to
+ * threads.
+ * @param status Receives `-1` if the thread could not allocate its buffers.
+ */
+struct chain_data {
+	struct image_rgb *input_image;
+	struct image_rgb *output_image;
+	const unsigned char *interleaved_input;
+	unsigned char *interleaved_output;
+	int width;
+	int height;
+	const struct filter *filters;
+	int num_filters;
+	int tile_width;
+	int tile_height;
+	int num_cols;
+	int num_tiles;
+	atomic_int *next_tile;
+	atomic_int status;
+};
+
+int chain_halo(const struct filter *filters, int num_filters) {
+	int halo = 0;
+
+	for (int i = 0; i < num_filters; i++) {
+		halo += filters[i].size / 2;
+	}
+
+	return halo;
+}
+
+size_t chain_tile_budget(void) {
+	return (size_t)(l2_cache_size() * CHAIN_TILE_CACHE_SHARE);
+}
+
+void chain_tile_size(const struct filter *filters, int num_filters, int width,
+					 int *tile_width, int *tile_height) {
+	int halo = chain_halo(filters, num_filters);
+	*tile_width = min(width, CHAIN_TILE_WIDTH);
+
+	// Two buffers of three channels
+	int rows = (int)(chain_tile_budget() / (6 * (*tile_width + 2 * halo)));
+	*tile_height = max(rows - 2 * halo, CHAIN_MIN_TILE_HEIGHT);
+}
+
+// Copies `count` pixels of a row of the image, starting at `column`, to the buffer
+// channels at `offset`.
+static inline void copy_run(const struct chain_data *chain,
+							unsigned char *const *outputs, size_t offset,
+							size_t row, size_t column, size_t count,
+							deinterleave_fn deinterleave) {
+	if (chain->interleaved_input != NULL) {
+		size_t index = row * chain->width + column;
+		deinterleave(chain->interleaved_input + 3 * index, outputs[0] + offset,
+					 outputs[1] + offset, outputs[2] + offset, count);
+	} else {
+		size_t index = row * chain->input_image->stride + column;
+		memcpy(outputs[0] + offset, chain->input_image->red + index, count);
+		memcpy(outputs[1] + offset, chain->input_image->green + index, count);
+		memcpy(outputs[2] + offset, chain->input_image->blue + index, count);
+	}
+}
+
+// Copies the pixels `[left, left + width) x [top, top + height)` of the image, which
+// may lie outside of it, to the top left corner of the buffer. Outside of the image
+// the buffer receives what the border mode of the first filter reads there.
+static void gather_tile(const struct chain_data *chain, struct image_rgb *buffer,
+						ptrdiff_t left, ptrdiff_t top, size_t width, size_t height) {
+	unsigned char *outputs[] = {buffer->red, buffer->green, buffer->blue};
+	enum border_mode border = chain->filters[0].border;
+	deinterleave_fn deinterleave = get_deinterleave(detect_simd_level());
+
+	for (size_t y = 0; y < height; y++) {
+		ptrdiff_t image_y = top + (ptrdiff_t)y;
+		size_t offset = y * buffer->stride;
+
+		if (border == BORDER_CONSTANT && (image_y < 0 || image_y >= chain->height)) {
+			for (int c = 0; c < 3; c++) {
+				memset(outputs[c] + offset, BORDER_CONSTANT_VALUE, width);
+			}
+			continue;
+		}
+
+		size_t row = border_position(image_y, chain->height, border);
+
+		// Runs of the row inside the image or, when wrapping, between wraps around
+		// the border; the other border modes take the outside pixels one by one
+		for (size_t x = 0; x < width;) {
+			ptrdiff_t image_x = left + (ptrdiff_t)x;
+			size_t count = 1;
+
+			if (image_x >= 0 && image_x < chain->width) {
+				count = min(width - x, (size_t)(chain->width - image_x));
+				copy_run(chain, outputs, offset + x, row, (size_t)image_x, count,
+						 deinterleave);
+			} else if (border == BORDER_CONSTANT) {
+				count = image_x < 0 ? min(width - x, (size_t)-image_x) : width - x;
+				for (int c = 0; c < 3; c++) {
+					memset(outputs[c] + offset + x, BORDER_CONSTANT_VALUE, count);
+				}
+			} else {
+				size_t column = border_position(image_x, chain->width, border);
+				if (border == BORDER_WRAP) {
+					count = min(width - x, (size_t)chain->width - column);
+				}
+				copy_run(chain, outputs, offset + x, row, column, count,
+						 deinterleave);
+			}
+
+			x += count;
+		}
+	}
+}
+
+// Copies the pixels `[offset, offset + width) x [offset, offset + height)` of the
+// buffer to the region of the output image starting at `(start_x, start_y)`.
+static void scatter_tile(const struct chain_data *chain,
+						 const struct image_rgb *buffer, size_t offset,
+						 size_t start_x, size_t start_y, size_t width,
+						 size_t height) {
+	const unsigned char *inputs[] = {buffer->red, buffer->green, buffer->blue};
+	interleave_fn interleave = get_interleave(detect_simd_level());
+
+	for (size_t y = 0; y < height; y++) {
+		size_t position = (offset + y) * buffer->stride + offset;
+
+		if (chain->interleaved_output != NULL) {
+			size_t index = (start_y + y) * chain->width + start_x;
+			interleave(inputs[0] + position, inputs[1] + position,
+					   inputs[2] + position, chain->interleaved_output + 3 * index,
+					   width);
+		} else {
+			size_t index = (start_y + y) * chain->output_image->stride + start_x;
+			memcpy(chain->output_image->red + index, inputs[0] + position, width);
+			memcpy(chain->output_image->green + index, inputs[1] + position, width);
+			memcpy(chain->output_image->blue + index, inputs[2] + position, width);
+		}
+	}
+}
+
+static void *process_chain(void *arg) {
+	struct chain_data *chain = (struct chain_data *)arg;
+	int halo = chain_halo(chain->filters, chain->num_filters);
+	size_t columns = chain->tile_width + 2 * halo;
+	size_t rows = chain->tile_height + 2 * halo;
+
+	// The filters are applied between the two buffers, which take the place of the
+	// images, so they only ever read inside of them.
+	struct image_rgb buffers[] = {initialize_image_rgb(columns, rows),
+								  initialize_image_rgb(columns, rows)};
+	struct thread_data stage = {
+		.width = columns, .height = rows, .scratch = NULL, .scratch_size = 0};
+
+	if (buffers[0].red == NULL || buffers[1].red == NULL) {
+		error("Failed to allocate the tile buffers\n");
+		atomic_store(&chain->status, -1);
+		atomic_store(chain->next_tile, chain->num_tiles);
+	}
+
+	while (atomic_load(&chain->status) == 0) {
+		int tile_index = atomic_fetch_add(chain->next_tile, 1);
+
+		if (tile_index >= chain->num_tiles) {
+			break;
+		}
+
+		size_t start_x = (tile_index % chain->num_cols) * chain->tile_width;
+		size_t start_y = (tile_index / chain->num_cols) * chain->tile_height;
+		size_t width = min((size_t)chain->tile_width, chain->width - start_x);
+		size_t height = min((size_t)chain->tile_height, chain->height - start_y);
+
+		gather_tile(chain, &buffers[0], (ptrdiff_t)start_x - halo,
+					(ptrdiff_t)start_y - halo, width + 2 * halo, height + 2 * halo);
+
+		// Pixels of the buffers still valid around the tile after each filter
+		int margin = halo;
+
+		for (int i = 0; i < chain->num_filters; i++) {
+			margin -= chain->filters[i].size / 2;
+
+			stage.filter = chain->filters[i];
+			stage.input_image = &buffers[i % 2];
+			stage.output_image = &buffers[(i + 1) % 2];
+
+			apply_filter_to_block(&stage, halo - margin, halo - margin,
+								  halo + width + margin, halo + height + margin);
+		}
+
+		scatter_tile(chain, &buffers[chain->num_filters % 2], halo, start_x, start_y,
+					 width, height);
+	}
+
+	free(stage.scratch);
+	free_image_rgb(&buffers[0]);
+	free_image_rgb(&buffers[1]);
+
+	return NULL;
+}
+
+int chain_application(struct image_rgb *input_image, struct image_rgb *output_image,
+					  int width, int height, const struct filter *filters,
+					  int num_filters, int num_threads) {
+	int tile_width, tile_height;
+	chain_tile_size(filters, num_filters, width, &tile_width, &tile_height);
+
+	return chain_application_tiled(input_image, output_image, width, height,
+								   filters, num_filters, tile_width, tile_height,
+								   num_threads);
+}
+
+// Checks that the filters of a chain may be applied to the same tiles. The wrapped
+// border is the only one that commutes with the filters, the others are taken
+// around the input of each filter, so such chains are applied filter by filter.
+static bool chain_fuses(const struct filter *filters, int num_filters) {
+	for (int i = 0; i < num_filters && num_filters > 1; i++) {
+		if (filters[i].border != BORDER_WRAP) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Checks that the halo of no filter wraps around the image more than once
+static bool chain_fits_image(const struct filter *filters, int num_filters,
+							 int width, int height) {
+	for (int i = 0; i < num_filters; i++) {
+		if (filters[i].size > width || filters[i].size > height) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Splits the image into tiles of the size given in `chain` and applies the chain to
+// them with `num_threads` threads.
+static int apply_to_tiles(struct chain_data *chain, int num_threads) {
+	int tile_width = min(max(chain->tile_width, 1), chain->width);
+	int tile_height = min(max(chain->tile_height, 1), chain->height);
+
+	int num_cols = (chain->width + tile_width - 1) / tile_width;
+	int num_rows = (chain->height + tile_height - 1) / tile_height;
+
+	atomic_int next_tile;
+	atomic_init(&next_tile, 0);
+
+	chain->tile_width = tile_width;
+	chain->tile_height = tile_height;
+	chain->num_cols = num_cols;
+	chain->num_tiles = num_cols * num_rows;
+	chain->next_tile = &next_tile;
+	atomic_init(&chain->status, 0);
+
+	// All the threads share the chain data
+	if (thread_pool_run(process_chain, chain, 0, num_threads) != 0) {
+		return -1;
+	}
+
+	return atomic_load(&chain->status);
+}
+
+// Applies the filters of the chain one after another to whole images, each one to
+// the tiles of the output of the previous one, alternating between the output and
+// an intermediate image so that the last one writes to the output image.
+static int tiled_passes(struct chain_data *chain, int num_threads) {
+	const struct filter *filters = chain->filters;
+	int num_filters = chain->num_filters;
+	struct image_rgb *output_image = chain->output_image;
+	struct image_rgb intermediate =
+		initialize_image_rgb(chain->width, chain->height);
+	int status = 0;
+
+	if (intermediate.red == NULL) {
+		error("Memory allocation error for the intermediate image\n");
+		return -1;
+	}
+
+	for (int i = 0; i < num_filters && status == 0; i++) {
+		chain->output_image =
+			(num_filters - i) % 2 == 1 ? output_image : &intermediate;
+		chain->filters = &filters[i];
+		chain->num_filters = 1;
+
+		status = apply_to_tiles(chain, num_threads);
+		chain->input_image = chain->output_image;
+	}
+
+	free_image_rgb(&intermediate);
+
+	return status;
+}
+
+int chain_application_tiled(struct image_rgb *input_image,
+							struct image_rgb *output_image, int width, int height,
+							const struct filter *filters, int num_filters,
+							int tile_width, int tile_height, int num_threads) {
+	if (!chain_fits_image(filters, num_filters, width, height)) {
+		error("A filter of the chain is larger than the image\n");
+		return -1;
+	}
+
+	struct chain_data chain = {.input_image = input_image,
+							   .output_image = output_image,
+							   .interleaved_input = NULL,
+							   .interleaved_output = NULL,
+							   .width = width,
+							   .height = height,
+							   .filters = filters,
+							   .num_filters = num_filters,
+							   .tile_width = tile_width,
+							   .tile_height = tile_height};
+
+	if (!chain_fuses(filters, num_filters)) {
+		return tiled_passes(&chain, num_threads);
+	}
+
+	return apply_to_tiles(&chain, num_threads);
+}
+
+// Applies the filters one after another over whole split images, for chains whose
+// halo wraps around the image more than once or that may not be fused.
+static int interleaved_passes(const unsigned char *input, unsigned char *output,
+							  int width, int height, const struct filter *filters,
+							  int num_filters) {
+	struct image_rgb images[] = {initialize_image_rgb(width, height),
+								 initialize_image_rgb(width, height)};
+	int status = -1;
+
+	if (images[0].red != NULL && images[1].red != NULL) {
+		split_image_into_rgb_channels(input, images[0], width, height);
+
+		for (int i = 0; i < num_filters; i++) {
+			sequential_fast_application(&images[i % 2], &images[(i + 1) % 2], width,
+										height, filters[i]);
+		}
+
+		assemble_image_from_rgb_channels(output, images[num_filters % 2], width,
+										 height);
+		status = 0;
+	} else {
+		error("Memory allocation error for the split images\n");
+	}
+
+	free_image_rgb(&images[0]);
+	free_image_rgb(&images[1]);
+
+	return status;
+}
+
+int chain_application_interleaved(const unsigned char *input,
+								  unsigned char *output, int width, int height,
+								  const struct filter *filters, int num_filters,
+								  int tile_width, int tile_height,
+								  int num_threads) {
+	if (!chain_fits_image(filters, num_filters, width, height) ||
+		!chain_fuses(filters, num_filters)) {
+		return interleaved_passes(input, output, width, height, filters,
+								  num_filters);
+	}
+
+	int auto_width, auto_height;
+	chain_tile_size(filters, num_filters, width, &auto_width, &auto_height);
+
+	struct chain_data chain = {
+		.input_image = NULL,
+		.output_image = NULL,
+		.interleaved_input = input,
+		.interleaved_output = output,
+		.width = width,
+		.height = height,
+		.filters = filters,
+		.num_filters = num_filters,
+		.tile_width = tile_width > 0 ? tile_width : auto_width,
+		.tile_height = tile_height > 0 ? tile_height : auto_height};
+
+	return apply_to_tiles(&chain, num_threads);
+}
+
+// Composes the filters `[first, last]` of a chain into `group`, which only owns a
+// kernel (to be freed with `free_filter()`) if `first < last`.
+static int compose_group(const struct filter *filters, int first, int last,
+						 struct filter *group) {
+	*group = filters[first];
+
+	for (int i = first + 1; i <= last; i++) {
+		struct filter composed = compose_filters(group, &filters[i]);
+
+		if (i > first + 1) {
+			free_filter(group);
+		}
+		if (composed.kernel == NULL) {
+			error("Memory allocation error for a composed filter\n");
+			return -1;
+		}
+
+		*group = composed;
+	}
+
+	group->engine = filters[first].engine;
+	group->border = filters[first].border;
+	return 0;
+}
+
+// Estimates the cost of applying the filters of one pass over the whole image,
+// fused per tile if there are several.
+static double run_cost(const struct filter *stages, int num_stages, int width,
+					   double height) {
+	double pass = CHAIN_PASS_COST * width * height;
+
+	if (num_stages == 1) {
+		return pass + estimate_filter_cost(&stages[0], width, height);
+	}
+
+	for (int i = 0; i < num_stages; i++) {
+		if (stages[i].size > width || stages[i].size > height) {
+			return INFINITY;
+		}
+	}
+
+	int tile_width, tile_height;
+	chain_tile_size(stages, num_stages, width, &tile_width, &tile_height);
+	tile_height = min(tile_height, (int)height);
+
+	int margin = chain_halo(stages, num_stages);
+	double tile = 0.0;
+
+	for (int i = 0; i < num_stages; i++) {
+		margin -= stages[i].size / 2;
+		tile += estimate_filter_cost(&stages[i], tile_width + 2 * margin,
+									 tile_height + 2 * margin);
+	}
+
+	double tiles = ceil((double)width / tile_width) * ceil(height / tile_height);
+	return pass + tiles * tile;
+}
+
+// Estimates the cost of a plan, `INFINITY` if it composes filters that may not be
+// composed. `groups[first][last]` holds the composition of the filters
+// `[first, last]`, with a `NULL` kernel if they may not be composed.
+static double plan_cost(const struct filter *filters,
+						struct filter groups[][CHAIN_MAX_FILTERS],
+						const struct chain_plan *plan, int width, int height) {
+	struct filter stages[CHAIN_MAX_FILTERS];
+	int num_stages = 0, first = 0;
+	double cost = 0.0;
+
+	for (int i = 0; i < plan->num_filters; i++) {
+		bool last = i + 1 == plan->num_filters;
+
+		if (!last && plan->links[i] == CHAIN_LINK_COMPOSE) {
+			continue;
+		}
+
+		stages[num_stages] = first == i ? filters[i] : groups[first][i];
+		if (stages[num_stages++].kernel == NULL) {
+			return INFINITY;
+		}
+		first = i + 1;
+
+		if (last || plan->links[i] == CHAIN_LINK_PASS) {
+			cost += run_cost(stages, num_stages, width, height);
+			num_stages = 0;
+		}
+	}
+
+	return cost;
+}
+
+int plan_chain(const struct filter *filters, int num_filters, int width, int height,
+			   bool passes_only, struct chain_plan *plan) {
+	if (num_filters < 1 || num_filters > CHAIN_MAX_FILTERS) {
+		error("A chain has 1 to %d filters\n", CHAIN_MAX_FILTERS);
+		return -1;
+	}
+
+	struct filter groups[CHAIN_MAX_FILTERS][CHAIN_MAX_FILTERS];
+	int status = 0;
+
+	// Composed and fused filters only match separate passes with a wrapped border
+	passes_only = passes_only || !chain_fuses(filters, num_filters);
+
+	for (int first = 0; first < num_filters; first++) {
+		for (int last = first; last < num_filters; last++) {
+			groups[first][last].kernel = NULL;
+		}
+
+		// Each composition extends the previous one by a filter
+		for (int last = first + 1; last < num_filters && !passes_only; last++) {
+			const struct filter *previous =
+				last == first + 1 ? &filters[first] : &groups[first][last - 1];
+
+			int size = previous->size + filters[last].size - 1;
+
+			if (!filter_output_in_range(&filters[last - 1]) ||
+				filter_gain(&filters[last]) > CHAIN_MAX_COMPOSED_GAIN ||
+				size > CHAIN_MAX_COMPOSED_SIZE || size > min(width, height)) {
+				break;
+			}
+
+			if (compose_group(filters, first, last, &groups[first][last]) != 0) {
+				status = -1;
+				break;
+			}
+		}
+	}
+
+	struct chain_plan candidate = {.num_filters = num_filters};
+	int num_plans = 1;
+
+	for (int i = 0; i + 1 < num_filters && !passes_only; i++) {
+		num_plans *= 3;
+	}
+
+	// The first candidate applies every filter in its own pass
+	for (int code = 0; code < num_plans && status == 0; code++) {
+		for (int i = 0, digits = code; i + 1 < num_filters; i++, digits /= 3) {
+			candidate.links[i] = (enum chain_link)((CHAIN_LINK_PASS + digits) % 3);
+		}
+
+		candidate.cost = plan_cost(filters, groups, &candidate, width, height);
+		if (code == 0 || candidate.cost < plan->cost) {
+			*plan = candidate;
+		}
+	}
+
+	for (int first = 0; first < num_filters; first++) {
+		for (int last = first + 1; last < num_filters; last++) {
+			if (groups[first][last].kernel != NULL) {
+				free_filter(&groups[first][last]);
+			}
+		}
+	}
+
+	return status;
+}
+
+void print_chain_plan(char *const *names, const struct chain_plan *plan) {
+	const char *separators[] = {[CHAIN_LINK_COMPOSE] = "*",
+								[CHAIN_LINK_FUSE] = " > ",
+								[CHAIN_LINK_PASS] = " | "};
+
+	printf("Chain plan: ");
+	for (int i = 0; i < plan->num_filters; i++) {
+		printf("%s%s", names[i],
+			   i + 1 < plan->num_filters ? separators[plan->links[i]] : "");
+	}
+	printf(" (estimated cost: %.1f million operations)\n", plan->cost / 1e6);
+}
+
+// Counts the runs of a plan, the groups of filters applied in one pass
+static int count_runs(const struct chain_plan *plan) {
+	int num_runs = 1;
+
+	for (int i = 0; i + 1 < plan->num_filters; i++) {
+		num_runs += plan->links[i] == CHAIN_LINK_PASS;
+	}
+
+	return num_runs;
+}
+
+// Applies one run of a plan between two planar images, or two interleaved buffers
+// if `interleaved`, which always go through the tiled chain application.
+static int apply_run(void *source, void *target, bool interleaved, int width,
+					 int height, const struct filter *stages, int num_stages,
+					 chain_pass_fn pass, int num_threads) {
+	if (interleaved) {
+		return chain_application_interleaved(source, target, width, height, stages,
+											 num_stages, 0, 0, num_threads);
+	}
+
+	if (num_stages == 1) {
+		return pass(source, target, width, height, stages[0], num_threads);
+	}
+
+	return chain_application(source, target, width, height, stages, num_stages,
+							 num_threads);
+}
+
+// Applies the runs of a plan, alternating between the output and the intermediate
+// image so that the last one writes to the output image.
+static int apply_runs(void *input, void *output, void *intermediate,
+					  bool interleaved, int width, int height,
+					  const struct filter *filters, const struct chain_plan *plan,
+					  chain_pass_fn pass, int num_threads) {
+	struct filter stages[CHAIN_MAX_FILTERS];
+	bool composed[CHAIN_MAX_FILTERS];
+	int num_stages = 0, first = 0, status = 0;
+	int num_runs = count_runs(plan), run = 0;
+	void *source = input;
+
+	for (int i = 0; i < plan->num_filters && status == 0; i++) {
+		bool last = i + 1 == plan->num_filters;
+
+		if (!last && plan->links[i] == CHAIN_LINK_COMPOSE) {
+			continue;
+		}
+
+		status = compose_group(filters, first, i, &stages[num_stages]);
+		composed[num_stages] = first < i && status == 0;
+		num_stages += status == 0;
+		first = i + 1;
+
+		if (status == 0 && (last || plan->links[i] == CHAIN_LINK_PASS)) {
+			void *target = (num_runs - run) % 2 == 1 ? output : intermediate;
+
+			status = apply_run(source, target, interleaved, width, height, stages,
+							   num_stages, pass, num_threads);
+
+			source = target;
+			run++;
+
+			for (int j = 0; j < num_stages; j++) {
+				if (composed[j]) {
+					free_filter(&stages[j]);
+				}
+			}
+			num_stages = 0;
+		}
+	}
+
+	for (int j = 0; j < num_stages; j++) {
+		if (composed[j]) {
+			free_filter(&stages[j]);
+		}
+	}
+
+	return status;
+}
+
+int apply_chain_plan(struct image_rgb *input_image, struct image_rgb *output_image,
+					 int width, int height, const struct filter *filters,
+					 const struct chain_plan *plan, chain_pass_fn pass,
+					 int num_threads) {
+	struct image_rgb intermediate = {NULL, NULL, NULL, 0, 0, NULL};
+
+	if (count_runs(plan) > 1) {
+		// Of the output and intermediate images, each is the input of a pass
+		intermediate =
+			initialize_padded_image_rgb(width, height, output_image->halo);
+		if (intermediate.red == NULL) {
+			error("Memory allocation error for the intermediate image\n");
+			return -1;
+		}
+	}
+
+	int status = apply_runs(input_image, output_image, &intermediate, false, width,
+							height, filters, plan, pass, num_threads);
+
+	free_image_rgb(&intermediate);
+
+	return status;
+}
+
+int apply_chain_plan_interleaved(const unsigned char *input, unsigned char *output,
+								 int width, int height,
+								 const struct filter *filters,
+								 const struct chain_plan *plan, int num_threads) {
+	unsigned char *intermediate = NULL;
+
+	if (count_runs(plan) > 1) {
+		intermediate = malloc((size_t)width * height * 3);
+		if (intermediate == NULL) {
+			error("Memory allocation error for the intermediate image\n");
+			return -1;
+		}
+	}
+
+	// The input is only read, by the first run
+	int status = apply_runs((void *)input, output, intermediate, true, width,
+							height, filters, plan, NULL, num_threads);
+
+	free(intermediate);
+
+	return status;
+}
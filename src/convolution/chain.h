@@ -0,0 +1,241 @@
+#pragma once
+
+#include "filter_application.h"
+
+#define CHAIN_TILE_CACHE_SHARE 0.5		// Share of L2 taken by the tile buffers
+#define CHAIN_TILE_WIDTH 1024			// Widest output tile, copied in runs of rows
+#define CHAIN_MIN_TILE_HEIGHT 16		// Lowest output tile
+#define CHAIN_MAX_FILTERS 8				// Longest chain the planner accepts
+#define CHAIN_MAX_COMPOSED_SIZE 33		// Widest kernel the planner composes
+#define CHAIN_MAX_COMPOSED_GAIN 1.001	// Largest gain of a composed filter
+#define CHAIN_PASS_COST 4.0				// Streaming one pixel through memory
+
+/**
+ * How two adjacent filters of a chain are applied.
+ *
+ * @param CHAIN_LINK_COMPOSE Both kernels are composed into one (`*` in plans).
+ * @param CHAIN_LINK_FUSE Both filters are applied to the same tiles by
+ * `chain_application()` (`>` in plans).
+ * @param CHAIN_LINK_PASS The second filter is applied to the whole output image of
+ * the first one (`|` in plans).
+ */
+enum chain_link { CHAIN_LINK_COMPOSE, CHAIN_LINK_FUSE, CHAIN_LINK_PASS };
+
+/**
+ * Describes how a chain of filters is applied.
+ *
+ * @param num_filters Number of filters in the chain.
+ * @param links How each filter and the next one are applied.
+ * @param cost Estimated cost, in the units of `estimate_filter_cost()`.
+ */
+struct chain_plan {
+	int num_filters;
+	enum chain_link links[CHAIN_MAX_FILTERS - 1];
+	double cost;
+};
+
+/**
+ * Computes how far the first filter of a chain reads beyond the output pixel of the
+ * last one, i.e. the sum of the halos (`size / 2`) of all filters.
+ *
+ * @param filters The filters of the chain.
+ * @param num_filters Number of filters in the chain.
+ *
+ * @return The accumulated halo of the chain.
+ */
+int chain_halo(const struct filter *filters, int num_filters);
+
+/**
+ * Computes how many bytes the two tile buffers of a thread may take:
+ * `CHAIN_TILE_CACHE_SHARE` of the L2 cache (see `l2_cache_size()`), so the buffers
+ * stay in it while the filters are applied, with room left for the scratch buffers
+ * of the engines and the output rows.
+ *
+ * @return The budget of the tile buffers in bytes.
+ */
+size_t chain_tile_budget(void);
+
+/**
+ * Computes the size of the output tiles of a chain. Tiles are wide, as the input
+ * rows are copied to the tile buffers in runs and long runs stream from memory much
+ * faster, and as high as the two tile buffers of a thread, which also hold the
+ * accumulated halo around the tile, allow to fit in `chain_tile_budget()` bytes,
+ * but at least `CHAIN_MIN_TILE_HEIGHT` rows.
+ *
+ * @param filters The filters of the chain.
+ * @param num_filters Number of filters in the chain.
+ * @param width Width of the image.
+ * @param tile_width Receives the width of the output tiles.
+ * @param tile_height Receives the height of the output tiles.
+ */
+void chain_tile_size(const struct filter *filters, int num_filters, int width,
+					 int *tile_width, int *tile_height);
+
+/**
+ * Applies a chain of filters to an image, the output of each filter being the input
+ * of the next one. The image is split into tiles (see `chain_tile_size()`)
+ * that the threads take dynamically. For each tile a thread copies the input pixels
+ * the chain reads into a tile buffer, applies the filters back-to-back between two
+ * such buffers, each filter shrinking the valid region by its halo, and writes the
+ * last one to the output image, so no intermediate image is ever allocated. The
+ * filters are applied with `apply_filter_to_block()` and the intermediate pixels
+ * are rounded like the output of a single filter, so the result is identical to
+ * applying the filters one after another over whole images. Chains reading another
+ * border mode than `BORDER_WRAP` are applied tile by tile one filter at a time, as
+ * the border is taken around the input of each filter.
+ *
+ * @param input_image Pointer to the input image (`struct image_rgb`).
+ * @param output_image Pointer to the output image (`struct image_rgb`).
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param filters The filters to be applied, in order.
+ * @param num_filters Number of filters in the chain.
+ * @param num_threads Number of threads to use.
+ *
+ * @return `0` on success, `-1` if a kernel is larger than the image, thread
+ * creation or memory allocation fails.
+ */
+int chain_application(struct image_rgb *input_image, struct image_rgb *output_image,
+					  int width, int height, const struct filter *filters,
+					  int num_filters, int num_threads);
+
+/**
+ * Applies a chain of filters like `chain_application()`, but with output tiles of
+ * the given size instead of the one `chain_tile_size()` computes.
+ *
+ * @param input_image Pointer to the input image (`struct image_rgb`).
+ * @param output_image Pointer to the output image (`struct image_rgb`).
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param filters The filters to be applied, in order.
+ * @param num_filters Number of filters in the chain.
+ * @param tile_width Width of the output tiles.
+ * @param tile_height Height of the output tiles.
+ * @param num_threads Number of threads to use.
+ *
+ * @return `0` on success, `-1` if a kernel is larger than the image, thread
+ * creation or memory allocation fails.
+ */
+int chain_application_tiled(struct image_rgb *input_image,
+							struct image_rgb *output_image, int width, int height,
+							const struct filter *filters, int num_filters,
+							int tile_width, int tile_height, int num_threads);
+
+/**
+ * Applies a chain of filters like `chain_application_tiled()` to an interleaved
+ * (`RGBRGB...`) image, as loaded by stb_image, without splitting it into channels
+ * first: every tile is deinterleaved into the scratch buffers of its thread, and
+ * its output interleaved back, so no whole-image planar copy is made. Chains with a
+ * kernel larger than the image are applied one filter after another to split
+ * copies of the image instead.
+ *
+ * @param input Interleaved input pixels.
+ * @param output Interleaved output pixels, not overlapping the input.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param filters The filters to be applied, in order.
+ * @param num_filters Number of filters in the chain.
+ * @param tile_width Width of the output tiles, `0` for the one `chain_tile_size()`
+ * computes.
+ * @param tile_height Height of the output tiles, `0` for the one
+ * `chain_tile_size()` computes.
+ * @param num_threads Number of threads to use.
+ *
+ * @return `0` on success, `-1` if thread creation or memory allocation fails.
+ */
+int chain_application_interleaved(const unsigned char *input,
+								  unsigned char *output, int width, int height,
+								  const struct filter *filters, int num_filters,
+								  int tile_width, int tile_height,
+								  int num_threads);
+
+/**
+ * Plans how to apply a chain of filters to an image. Adjacent filters are composed
+ * into one kernel, fused per tile or applied in separate passes over the whole
+ * image, and the cheapest combination is chosen: each filter (or composed kernel)
+ * costs what `estimate_filter_cost()` expects for the regions it is applied to, so
+ * the cost accounts for the tap counts, separability and other structure of the
+ * kernels, the halos recomputed around the tiles of fused filters, and every pass
+ * streams the image through memory once (`CHAIN_PASS_COST` per pixel).
+ *
+ * A filter is only composed with the next one if its output is never clamped (see
+ * `filter_output_in_range()`), the next one does not amplify the rounding of its
+ * output (see `filter_gain()`) and the composed kernel is at most
+ * `CHAIN_MAX_COMPOSED_SIZE` wide, so that a composition only changes the result by
+ * rounding. Composed and fused kernels must not be larger than the image. Only
+ * wrapped borders commute with the filters, so chains reading another border mode
+ * are applied in separate passes.
+ *
+ * @param filters The filters of the chain.
+ * @param num_filters Number of filters in the chain, at most `CHAIN_MAX_FILTERS`.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param passes_only Only consider separate passes, e.g. for the reference mode.
+ * @param plan Receives the plan.
+ *
+ * @return `0` on success, `-1` if the chain is too long or memory allocation fails.
+ */
+int plan_chain(const struct filter *filters, int num_filters, int width, int height,
+			   bool passes_only, struct chain_plan *plan);
+
+/**
+ * Prints a plan, e.g. `bl*gbl > mbl | ed` for the composition of `bl` and `gbl`
+ * fused with `mbl` and followed by a pass of `ed`, and its estimated cost.
+ *
+ * @param names Names of the filters of the chain.
+ * @param plan The plan.
+ */
+void print_chain_plan(char *const *names, const struct chain_plan *plan);
+
+/**
+ * Signature of the functions applying a single filter to a whole image, such as
+ * `parallel_row()`.
+ */
+typedef int (*chain_pass_fn)(struct image_rgb *input_image,
+							 struct image_rgb *output_image, int width, int height,
+							 struct filter filter, int num_threads);
+
+/**
+ * Applies a chain of filters to an image as planned by `plan_chain()`. Composed
+ * kernels are built first and take the engine of their first filter. Runs of fused
+ * filters are applied by `chain_application()`, single filters between passes by
+ * `pass`. At most one intermediate image is allocated.
+ *
+ * @param input_image Pointer to the input image (`struct image_rgb`).
+ * @param output_image Pointer to the output image (`struct image_rgb`).
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param filters The filters of the chain.
+ * @param plan The plan.
+ * @param pass Function applying a single filter to the whole image.
+ * @param num_threads Number of threads to use.
+ *
+ * @return `0` on success, `-1` if memory allocation, thread creation or one of
+ * the passes fails.
+ */
+int apply_chain_plan(struct image_rgb *input_image, struct image_rgb *output_image,
+					 int width, int height, const struct filter *filters,
+					 const struct chain_plan *plan, chain_pass_fn pass,
+					 int num_threads);
+
+/**
+ * Applies a chain of filters to an interleaved image as planned by `plan_chain()`,
+ * like `apply_chain_plan()`, but every run, fused or not, is applied by
+ * `chain_application_interleaved()`. At most one interleaved intermediate image is
+ * allocated.
+ *
+ * @param input Interleaved input pixels.
+ * @param output Interleaved output pixels, not overlapping the input.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param filters The filters of the chain.
+ * @param plan The plan.
+ * @param num_threads Number of threads to use.
+ *
+ * @return `0` on success, `-1` if memory allocation, thread creation or one of
+ * the runs fails.
+ */
+int apply_chain_plan_interleaved(const unsigned char *input, unsigned char *output,
+								 int width, int height,
+								 const struct filter *filters,
+								 const struct chain_plan *plan, int num_threads);
@@ -0,0 +1,174 @@
+#include "dispatch.h"
+#include "box.h"
+#include "fft.h"
+
+#include <math.h>
+
+// Specific engines in the order they are tried, so the earlier one wins a tie
+static const enum filter_engine specific_engines[] = {
+	FILTER_ENGINE_SHIFT,
+	FILTER_ENGINE_BOX,
+	FILTER_ENGINE_LINE,
+	FILTER_ENGINE_FIXED_POINT,
+	FILTER_ENGINE_SEPARABLE,
+	FILTER_ENGINE_SPARSE,
+	FILTER_ENGINE_GENERIC,
+	FILTER_ENGINE_FFT,
+};
+
+bool engine_applies(const struct filter *filter, enum filter_engine engine) {
+	switch (engine) {
+		case FILTER_ENGINE_SHIFT:
+			return filter->shift;
+		case FILTER_ENGINE_BOX:
+			return filter->box;
+		case FILTER_ENGINE_LINE:
+			return filter->line;
+		case FILTER_ENGINE_SEPARABLE:
+			return filter->separable;
+		case FILTER_ENGINE_FIXED_POINT:
+			return filter->fixed_point;
+		default:
+			return true;
+	}
+}
+
+// Cost per output pixel and channel of the spatial engines for regions of `width` x
+// `height` pixels
+static double spatial_pixel_cost(const struct filter *filter,
+								 enum filter_engine engine, size_t width,
+								 size_t height) {
+	double size = filter->size;
+
+	switch (engine) {
+		case FILTER_ENGINE_SHIFT:
+			return SHIFT_PIXEL_COST;
+		case FILTER_ENGINE_BOX: {
+			// The column sums span the region and its halo: `size` input rows are
+			// added to them for each region, and two more for each further row
+			double span = width + size - 1;
+			double column_sums = size * span / ((double)width * height) +
+								 2.0 * span / width;
+			return BOX_PIXEL_COST + column_sums * BOX_COLUMN_SUM_COST;
+		}
+		case FILTER_ENGINE_LINE:
+			return (filter->slides[0].num_taps + 1) * FIXED_POINT_TAP_COST;
+		case FILTER_ENGINE_SEPARABLE:
+			// The horizontal pass also covers `size - 1` halo rows
+			return (size * (height + size - 1) / height + size) * SEPARABLE_TAP_COST;
+		case FILTER_ENGINE_FIXED_POINT:
+			return filter->num_taps * FIXED_POINT_TAP_COST;
+		case FILTER_ENGINE_SPARSE:
+			return filter->num_taps * SPARSE_TAP_COST;
+		default:
+			return size * size;
+	}
+}
+
+double engine_cost(const struct filter *filter, enum filter_engine engine,
+				   size_t width, size_t height) {
+	if (!engine_applies(filter, engine)) {
+		return INFINITY;
+	}
+
+	if (width == 0 || height == 0) {
+		return 0.0;
+	}
+
+	if (engine == FILTER_ENGINE_FFT) {
+		return estimate_fft_cost(filter, width, height);
+	}
+
+	return 3.0 * spatial_pixel_cost(filter, engine, width, height) *
+		   (double)width * (double)height;
+}
+
+// Finds the cheapest specific engine, leaving out the FFT one unless `with_fft`
+static enum filter_engine cheapest_engine(const struct filter *filter, size_t width,
+										  size_t height, bool with_fft) {
+	enum filter_engine best = FILTER_ENGINE_GENERIC;
+	double best_cost = INFINITY;
+
+	for (size_t i = 0; i < sizeof(specific_engines) / sizeof(specific_engines[0]);
+		 i++) {
+		enum filter_engine engine = specific_engines[i];
+		if (engine == FILTER_ENGINE_FFT && !with_fft) {
+			continue;
+		}
+
+		double cost = engine_cost(filter, engine, width, height);
+		if (cost < best_cost) {
+			best_cost = cost;
+			best = engine;
+		}
+	}
+
+	return best;
+}
+
+enum filter_engine choose_engine(const struct filter *filter, size_t width,
+								 size_t height) {
+	switch (filter->engine) {
+		case FILTER_ENGINE_AUTO:
+			// The result must not depend on the mode, so FFTs are only picked where
+			// they are exact
+			return cheapest_engine(filter, width, height, fft_is_exact(filter));
+		case FILTER_ENGINE_DIRECT:
+			return cheapest_engine(filter, width, height, false);
+		default:
+			return engine_applies(filter, filter->engine)
+					   ? filter->engine
+					   : cheapest_engine(filter, width, height, true);
+	}
+}
+
+bool fft_is_cheaper(const struct filter *filter, size_t width, size_t height) {
+	if (width == 0 || height == 0) {
+		return false;
+	}
+
+	enum filter_engine spatial = cheapest_engine(filter, width, height, false);
+
+	return estimate_fft_cost(filter, width, height) <
+		   engine_cost(filter, spatial, width, height);
+}
+
+bool box_sums_are_cheaper(const struct filter *filter, size_t width,
+						  size_t height) {
+	bool box_allowed = filter->engine == FILTER_ENGINE_AUTO ||
+					   filter->engine == FILTER_ENGINE_DIRECT ||
+					   filter->engine == FILTER_ENGINE_BOX;
+
+	if (!filter->box || !box_allowed || filter->size > BOX_SUMS_MAX_SIZE ||
+		width == 0 || height == 0) {
+		return false;
+	}
+
+	return 3.0 * BOX_SUMS_PIXEL_COST * (double)width * (double)height <
+		   estimate_filter_cost(filter, width, height);
+}
+
+double estimate_filter_cost(const struct filter *filter, size_t width,
+							size_t height) {
+	return engine_cost(filter, choose_engine(filter, width, height), width,
+					   height);
+}
+
+void print_dispatch(const char *name, const struct filter *filter,
+					size_t block_width, size_t block_height) {
+	char description[128];
+	describe_filter(filter, description, sizeof(description));
+
+	// The parallel modes apply box filters from summed-area tables where they pay
+	// off (see `parallel_filter()`)
+	bool tables = box_sums_are_cheaper(filter, block_width, block_height);
+	enum filter_engine engine =
+		tables ? FILTER_ENGINE_BOX
+			   : choose_engine(filter, block_width, block_height);
+	const char *reason =
+		filter->engine == engine ? "forced" : filter_engine_name(filter->engine);
+
+	printf("Dispatch: %s (%s) -> %s (%s%s)\n", name, description,
+		   filter_engine_name(engine), reason,
+		   tables ? ", summed-area tables" : "");
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "filter_application.h"
+
+// Relative costs of the engines, in units of one floating-point multiply-add of a
+// kernel tap for one channel, the cost of the generic engine. They were measured
+// on x86-64.
+#define SHIFT_PIXEL_COST 0.05	  // Copying or looking up one pixel
+#define BOX_PIXEL_COST 2.0		  // Sliding the window over the column sums of a box
+#define BOX_COLUMN_SUM_COST 1.0	  // Adding one input pixel to a column sum of a box
+#define FIXED_POINT_TAP_COST 0.1  // One tap of the vectorized fixed-point engine
+#define SEPARABLE_TAP_COST 1.4	  // One tap of either pass of a separable filter
+#define SPARSE_TAP_COST 1.2		  // One tap of the sparse engine
+#define BOX_SUMS_PIXEL_COST 7.0	  // Building and looking up summed-area tables
+
+/**
+ * Checks whether an engine can apply a filter, e.g. the box engine only applies box
+ * filters. The automatic choices, the FFT, sparse and generic engines apply all
+ * filters.
+ *
+ * @param filter The convolution filter.
+ * @param engine The engine.
+ *
+ * @return `true` if the engine applies the filter.
+ */
+bool engine_applies(const struct filter *filter, enum filter_engine engine);
+
+/**
+ * Estimates the cost of applying the filter to an output region of `width` x
+ * `height` pixels with a specific engine. The unit is one floating-point
+ * multiply-add of a kernel tap for one channel.
+ *
+ * @param filter The convolution filter.
+ * @param engine The engine, not one of the automatic choices.
+ * @param width Width of the output region.
+ * @param height Height of the output region.
+ *
+ * @return The estimated cost of the three channels of the region, `INFINITY` if
+ * the engine does not apply the filter.
+ */
+double engine_cost(const struct filter *filter, enum filter_engine engine,
+				   size_t width, size_t height);
+
+/**
+ * Resolves `filter.engine` to the specific engine that applies the filter to output
+ * regions of `width` x `height` pixels: a forced engine if it applies the filter,
+ * otherwise the one with the lowest `engine_cost()`, leaving out the FFT engine
+ * for `FILTER_ENGINE_DIRECT`, and for `FILTER_ENGINE_AUTO` unless it is exact for
+ * the filter (see `fft_is_exact()`), so that the automatic choice of every block
+ * shape gives the result of `sequential_application()`. Filters are classified
+ * once by `prepare_filter()`, so this is cheap, but the parallel modes still
+ * resolve the engine only once per image for the shape of their blocks.
+ *
+ * @param filter The convolution filter.
+ * @param width Width of the output regions.
+ * @param height Height of the output regions.
+ *
+ * @return The specific engine.
+ */
+enum filter_engine choose_engine(const struct filter *filter, size_t width,
+								 size_t height);
+
+/**
+ * Estimates whether convolving the output region of `width` x `height` pixels with
+ * FFTs is cheaper than the cheapest spatial engine. The butterflies of the tile
+ * transforms are counted against the taps the spatial engines would compute, so
+ * FFTs win for large kernels over large regions.
+ *
+ * @param filter The convolution filter.
+ * @param width Width of the output region.
+ * @param height Height of the output region.
+ *
+ * @return `true` if the FFT engine is expected to be faster.
+ */
+bool fft_is_cheaper(const struct filter *filter, size_t width, size_t height);
+
+/**
+ * Estimates whether applying a box filter to output regions of `width` x `height`
+ * pixels from summed-area tables of the whole image (see `build_box_sums()`) is
+ * cheaper than the engine `choose_engine()` resolves `filter.engine` to. The tables
+ * cost the same per pixel for any shape of the regions, while the running sums of
+ * the box engine set up `size` rows per region, so the tables win for regions less
+ * than `size` rows high, e.g. those of the row and pixel modes.
+ *
+ * @param filter The convolution filter.
+ * @param width Width of the output regions.
+ * @param height Height of the output regions.
+ *
+ * @return `true` if the filter is a box, of at most `BOX_SUMS_MAX_SIZE` pixels a
+ * side, the box engine may be chosen for it and the tables are expected to be
+ * faster.
+ */
+bool box_sums_are_cheaper(const struct filter *filter, size_t width,
+						  size_t height);
+
+/**
+ * Estimates the cost of applying the filter to an output region of `width` x
+ * `height` pixels with the engine `choose_engine()` picks for it (see
+ * `engine_cost()`).
+ *
+ * @param filter The convolution filter.
+ * @param width Width of the output region.
+ * @param height Height of the output region.
+ *
+ * @return The estimated cost of the three channels of the region.
+ */
+double estimate_filter_cost(const struct filter *filter, size_t width,
+							size_t height);
+
+/**
+ * Prints the structure of a filter (see `describe_filter()`) and the engine that
+ * applies it to blocks of `block_width` x `block_height` pixels, e.g.
+ * `Dispatch: gbl (5x5, 25 taps, rank 1, ...) -> fixed (auto)`, noting box filters
+ * applied from summed-area tables (see `box_sums_are_cheaper()`).
+ *
+ * @param name Name of the filter.
+ * @param filter The convolution filter.
+ * @param block_width Width of the blocks.
+ * @param block_height Height of the blocks.
+ */
+void print_dispatch(const char *name, const struct filter *filter,
+					size_t block_width, size_t block_height);
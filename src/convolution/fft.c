@@ -0,0 +1,371 @@
+#include "fft.h"
+
+#include <math.h>
+
+#define FFT_PI 3.14159265358979323846
+
+// Relative costs of the transforms, in the units of `engine_cost()`. They were
+// measured on x86-64.
+#define FFT_BUTTERFLY_COST 3.5 // One complex radix-2 butterfly
+#define FFT_POINT_COST 3.0	   // Gathering, multiplying and storing one point
+
+static size_t next_power_of_two(size_t n) {
+	size_t power = 1;
+	while (power < n) {
+		power <<= 1;
+	}
+	return power;
+}
+
+static double log2_of_power(size_t n) {
+	double bits = 0.0;
+	while (n > 1) {
+		n >>= 1;
+		bits += 1.0;
+	}
+	return bits;
+}
+
+// Cost of convolving a `width` x `height` region with transforms of
+// `fft_width` x `fft_height` points, including the transform of the kernel.
+static double fft_cost(const struct filter *filter, size_t width, size_t height,
+					   size_t fft_width, size_t fft_height) {
+	size_t tile_width = fft_width - filter->size + 1;
+	size_t tile_height = fft_height - filter->size + 1;
+	double tiles = (double)((width + tile_width - 1) / tile_width) *
+				   (double)((height + tile_height - 1) / tile_height);
+
+	double points = (double)fft_width * (double)fft_height;
+	double transform =
+		points / 2.0 * log2_of_power(fft_width * fft_height) * FFT_BUTTERFLY_COST;
+
+	// Two complex tiles (red and green packed, then blue) are transformed forward
+	// and back.
+	double tile = 4.0 * transform + 2.0 * points * FFT_POINT_COST;
+
+	return tiles * tile + transform;
+}
+
+// Picks the transform size with the lowest cost for the region.
+static double plan_fft(const struct filter *filter, size_t width, size_t height,
+					   size_t *fft_width, size_t *fft_height) {
+	size_t smallest = max(next_power_of_two(filter->size), (size_t)FFT_MIN_SIZE);
+	size_t largest_width =
+		max(min(next_power_of_two(width + filter->size - 1), (size_t)FFT_MAX_SIZE),
+			smallest);
+	size_t largest_height =
+		max(min(next_power_of_two(height + filter->size - 1), (size_t)FFT_MAX_SIZE),
+			smallest);
+	double best = INFINITY;
+
+	for (size_t w = smallest; w <= largest_width; w <<= 1) {
+		for (size_t h = smallest; h <= largest_height; h <<= 1) {
+			double cost = fft_cost(filter, width, height, w, h);
+
+			if (cost < best) {
+				best = cost;
+				*fft_width = w;
+				*fft_height = h;
+			}
+		}
+	}
+
+	return best;
+}
+
+double estimate_fft_cost(const struct filter *filter, size_t width,
+						 size_t height) {
+	size_t fft_width, fft_height;
+	return plan_fft(filter, width, height, &fft_width, &fft_height);
+}
+
+// Fills `twiddles` with the `n / 2` roots of unity `e^(-2 * pi * i * k / n)` as
+// (real, imaginary) pairs.
+static void compute_twiddles(double *twiddles, size_t n) {
+	for (size_t k = 0; k < n / 2; k++) {
+		double angle = -2.0 * FFT_PI * (double)k / (double)n;
+		twiddles[2 * k] = cos(angle);
+		twiddles[2 * k + 1] = sin(angle);
+	}
+}
+
+// Transforms `n` complex values stored as (real, imaginary) pairs in place with the
+// iterative radix-2 algorithm. The inverse transform is not normalized.
+static void fft_row(double *row, size_t n, const double *twiddles, bool inverse) {
+	for (size_t i = 1, j = 0; i < n; i++) {
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1) {
+			j ^= bit;
+		}
+		j ^= bit;
+
+		if (i < j) {
+			double re = row[2 * i], im = row[2 * i + 1];
+			row[2 * i] = row[2 * j];
+			row[2 * i + 1] = row[2 * j + 1];
+			row[2 * j] = re;
+			row[2 * j + 1] = im;
+		}
+	}
+
+	for (size_t length = 2; length <= n; length <<= 1) {
+		size_t half = length / 2, step = n / length;
+
+		for (size_t i = 0; i < n; i += length) {
+			for (size_t k = 0; k < half; k++) {
+				double wr = twiddles[2 * k * step];
+				double wi = inverse ? -twiddles[2 * k * step + 1]
+									: twiddles[2 * k * step + 1];
+				double *a = row + 2 * (i + k), *b = row + 2 * (i + k + half);
+				double tr = b[0] * wr - b[1] * wi;
+				double ti = b[0] * wi + b[1] * wr;
+
+				b[0] = a[0] - tr;
+				b[1] = a[1] - ti;
+				a[0] += tr;
+				a[1] += ti;
+			}
+		}
+	}
+}
+
+// Transforms the `width` columns of an `n`-row complex matrix in place. The
+// butterflies combine whole rows, so the memory is walked contiguously instead of
+// striding down each column.
+static void fft_columns(double *data, size_t width, size_t n,
+						const double *twiddles, bool inverse) {
+	size_t row_length = 2 * width;
+
+	for (size_t i = 1, j = 0; i < n; i++) {
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1) {
+			j ^= bit;
+		}
+		j ^= bit;
+
+		if (i < j) {
+			double *a = data + i * row_length, *b = data + j * row_length;
+			for (size_t c = 0; c < row_length; c++) {
+				double value = a[c];
+				a[c] = b[c];
+				b[c] = value;
+			}
+		}
+	}
+
+	for (size_t length = 2; length <= n; length <<= 1) {
+		size_t half = length / 2, step = n / length;
+
+		for (size_t i = 0; i < n; i += length) {
+			for (size_t k = 0; k < half; k++) {
+				double wr = twiddles[2 * k * step];
+				double wi = inverse ? -twiddles[2 * k * step + 1]
+									: twiddles[2 * k * step + 1];
+				double *a = data + (i + k) * row_length;
+				double *b = data + (i + k + half) * row_length;
+
+				for (size_t c = 0; c < row_length; c += 2) {
+					double tr = b[c] * wr - b[c + 1] * wi;
+					double ti = b[c] * wi + b[c + 1] * wr;
+
+					b[c] = a[c] - tr;
+					b[c + 1] = a[c + 1] - ti;
+					a[c] += tr;
+					a[c + 1] += ti;
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Describes the transforms of one region: their size, the twiddle factors for both
+ * dimensions, the spectrum of the kernel and the two complex tile buffers.
+ */
+struct fft_plan {
+	size_t width;
+	size_t height;
+	const double *twiddles_x;
+	const double *twiddles_y;
+	double *spectrum;
+	double *tiles[2];
+};
+
+// Transforms a complex matrix of the plan's size. Only the first `rows` rows of the
+// inverse transform are computed, the others are not needed.
+static void fft_2d(const struct fft_plan *plan, double *data, bool inverse,
+				   size_t rows) {
+	if (!inverse) {
+		for (size_t y = 0; y < plan->height; y++) {
+			fft_row(data + 2 * y * plan->width, plan->width, plan->twiddles_x,
+					false);
+		}
+		fft_columns(data, plan->width, plan->height, plan->twiddles_y, false);
+		return;
+	}
+
+	fft_columns(data, plan->width, plan->height, plan->twiddles_y, true);
+	for (size_t y = 0; y < rows; y++) {
+		fft_row(data + 2 * y * plan->width, plan->width, plan->twiddles_x, true);
+	}
+}
+
+// Computes the spectrum of the kernel mirrored around the origin, so multiplying by
+// it correlates the tile with the kernel like the direct application does.
+static void transform_kernel(const struct fft_plan *plan,
+							 const struct filter *filter) {
+	size_t points = plan->width * plan->height;
+
+	for (size_t i = 0; i < 2 * points; i++) {
+		plan->spectrum[i] = 0.0;
+	}
+
+	for (int filterY = 0; filterY < filter->size; filterY++) {
+		for (int filterX = 0; filterX < filter->size; filterX++) {
+			size_t y = (plan->height - filterY) % plan->height;
+			size_t x = (plan->width - filterX) % plan->width;
+			plan->spectrum[2 * (y * plan->width + x)] =
+				filter->kernel[filterY * filter->size + filterX];
+		}
+	}
+
+	fft_2d(plan, plan->spectrum, false, plan->height);
+}
+
+// Copies the input of the tile whose first output pixel is (`x`, `y`), including
+// its halo, into the real parts of `real` and the imaginary parts of `imaginary`
+// (the real part of the blue tile when `imaginary` is `NULL`).
+static void gather_tile(const struct thread_data *data,
+						const struct fft_plan *plan, size_t x, size_t y,
+						const unsigned char *real, const unsigned char *imaginary,
+						double *tile) {
+	ptrdiff_t left = (ptrdiff_t)x - data->filter.size / 2;
+	ptrdiff_t top = (ptrdiff_t)y - data->filter.size / 2;
+	ptrdiff_t halo = input_halo(data);
+	bool inside =
+		left >= -halo && left + (ptrdiff_t)plan->width <= data->width + halo;
+
+	for (size_t v = 0; v < plan->height; v++) {
+		ptrdiff_t row = input_index(
+			data, 0, tap_position(data, top + (ptrdiff_t)v, data->height));
+		double *out = tile + 2 * v * plan->width;
+
+		for (size_t u = 0; u < plan->width; u++) {
+			ptrdiff_t column = left + (ptrdiff_t)u;
+			ptrdiff_t index =
+				row + (inside ? column : tap_position(data, column, data->width));
+			out[2 * u] = real[index];
+			out[2 * u + 1] = imaginary != NULL ? imaginary[index] : 0.0;
+		}
+	}
+}
+
+// Multiplies a transformed tile by the spectrum of the kernel.
+static void multiply_spectrum(const struct fft_plan *plan, double *tile) {
+	size_t points = plan->width * plan->height;
+
+	for (size_t i = 0; i < points; i++) {
+		double re = tile[2 * i], im = tile[2 * i + 1];
+		double kr = plan->spectrum[2 * i], ki = plan->spectrum[2 * i + 1];
+
+		tile[2 * i] = re * kr - im * ki;
+		tile[2 * i + 1] = re * ki + im * kr;
+	}
+}
+
+static inline unsigned char scale(const struct filter *filter, double sum,
+								  bool integer_sums) {
+	if (integer_sums) {
+		sum = nearbyint(sum);
+	}
+	return min(max((int)(filter->factor * sum + filter->bias), 0), 255);
+}
+
+bool fft_is_exact(const struct filter *filter) {
+	for (int i = 0; i < filter->size * filter->size; i++) {
+		if (filter->kernel[i] != floor(filter->kernel[i])) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool fft_block(struct thread_data *data, size_t start_x, size_t start_y,
+			   size_t end_x, size_t end_y) {
+	const struct filter *filter = &data->filter;
+
+	// A kernel larger than the image wraps around it more than once, which the
+	// spatial engines do not handle as a periodic convolution, unless the input has
+	// a halo.
+	if (input_halo(data) == 0 &&
+		(filter->size > data->width || filter->size > data->height)) {
+		return false;
+	}
+
+	if (start_x >= end_x || start_y >= end_y) {
+		return true;
+	}
+
+	struct fft_plan plan;
+	plan_fft(filter, end_x - start_x, end_y - start_y, &plan.width, &plan.height);
+
+	size_t points = plan.width * plan.height;
+	double *scratch =
+		reserve_scratch(data, plan.width + plan.height + 3 * 2 * points);
+	if (scratch == NULL) {
+		return false;
+	}
+
+	double *twiddles_x = scratch;
+	double *twiddles_y = twiddles_x + plan.width;
+	compute_twiddles(twiddles_x, plan.width);
+	compute_twiddles(twiddles_y, plan.height);
+	plan.twiddles_x = twiddles_x;
+	plan.twiddles_y = twiddles_y;
+	plan.spectrum = twiddles_y + plan.height;
+	plan.tiles[0] = plan.spectrum + 2 * points;
+	plan.tiles[1] = plan.tiles[0] + 2 * points;
+
+	transform_kernel(&plan, filter);
+
+	bool integer_sums = fft_is_exact(filter);
+	double normalization = 1.0 / (double)points;
+	size_t tile_width = plan.width - filter->size + 1;
+	size_t tile_height = plan.height - filter->size + 1;
+
+	for (size_t y = start_y; y < end_y; y += tile_height) {
+		size_t rows = min(tile_height, end_y - y);
+
+		for (size_t x = start_x; x < end_x; x += tile_width) {
+			size_t columns = min(tile_width, end_x - x);
+
+			gather_tile(data, &plan, x, y, data->input_image->red,
+						data->input_image->green, plan.tiles[0]);
+			gather_tile(data, &plan, x, y, data->input_image->blue, NULL,
+						plan.tiles[1]);
+
+			for (int i = 0; i < 2; i++) {
+				fft_2d(&plan, plan.tiles[i], false, plan.height);
+				multiply_spectrum(&plan, plan.tiles[i]);
+				fft_2d(&plan, plan.tiles[i], true, rows);
+			}
+
+			for (size_t v = 0; v < rows; v++) {
+				const double *red_green = plan.tiles[0] + 2 * v * plan.width;
+				const double *blue = plan.tiles[1] + 2 * v * plan.width;
+				size_t index = output_index(data, x, y + v);
+
+				for (size_t u = 0; u < columns; u++) {
+					data->output_image->red[index + u] = scale(
+						filter, red_green[2 * u] * normalization, integer_sums);
+					data->output_image->green[index + u] = scale(
+						filter, red_green[2 * u + 1] * normalization, integer_sums);
+					data->output_image->blue[index + u] =
+						scale(filter, blue[2 * u] * normalization, integer_sums);
+				}
+			}
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "filter_application.h"
+
+#define FFT_MIN_SIZE 16	 // Smallest transform side considered for a tile
+#define FFT_MAX_SIZE 512 // Largest transform side, keeps a tile's buffers in L2
+
+/**
+ * Estimates the cost of convolving an output region of `width` x `height` pixels
+ * with FFTs of the best tile size, including the transform of the kernel, in the
+ * units of `engine_cost()`.
+ *
+ * @param filter The convolution filter.
+ * @param width Width of the output region.
+ * @param height Height of the output region.
+ *
+ * @return The estimated cost of the three channels of the region.
+ */
+double estimate_fft_cost(const struct filter *filter, size_t width,
+						 size_t height);
+
+/**
+ * Checks whether the FFT engine gives exactly the result of the direct application
+ * for a filter, which is the case if all kernel values are integers (see
+ * `fft_block()`).
+ *
+ * @param filter The convolution filter.
+ *
+ * @return `true` if the kernel values are all integers.
+ */
+bool fft_is_exact(const struct filter *filter);
+
+/**
+ * Applies the filter to the output region `[start_x, end_x) x [start_y, end_y)` with
+ * FFT-based overlap-save convolution. The region is split into tiles; the input
+ * of each tile and its halo is gathered with the usual wrap-around borders, so the
+ * borders need no special handling, then transformed, multiplied by the spectrum of
+ * the kernel and transformed back. Two real channels are packed into the real and
+ * imaginary parts of one complex transform.
+ *
+ * If all kernel values are integers, the sums are rounded to the nearest integer,
+ * which makes the result identical to the one of the direct application. Otherwise
+ * a pixel may differ from it by one where a sum lies within rounding error of an
+ * integer.
+ *
+ * @param data Pointer to the `struct thread_data` describing the images and filter.
+ * @param start_x First column of the region.
+ * @param start_y First row of the region.
+ * @param end_x Column after the last one of the region.
+ * @param end_y Row after the last one of the region.
+ *
+ * @return `true` on success, `false` if the kernel is larger than the image or the
+ * scratch buffer could not be allocated (nothing is written in that case).
+ */
+bool fft_block(struct thread_data *data, size_t start_x, size_t start_y,
+			   size_t end_x, size_t end_y);
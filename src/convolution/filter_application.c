@@ -1,95 +1,522 @@
 #include "filter_application.h"
+#include "border.h"
+#include "box.h"
+#include "dispatch.h"
+#include "fft.h"
+#include "fixed_point.h"
+#include "line.h"
+#include "separable.h"
+#include "shift.h"
+#include "sparse.h"
+
+// Sums the kernel products for a pixel whose whole neighbourhood lies inside the
+// image or its halo, so the taps are addressed relative to its top-left corner
+// without wrapping.
+static inline void interior_pixel(const struct thread_data *data, size_t x, size_t y,
+								  double sums[3]) {
+	const struct filter *filter = &data->filter;
+	ptrdiff_t corner = input_index(data, (ptrdiff_t)x - filter->size / 2,
+								   (ptrdiff_t)y - filter->size / 2);
+	const unsigned char *red = data->input_image->red + corner;
+	const unsigned char *green = data->input_image->green + corner;
+	const unsigned char *blue = data->input_image->blue + corner;
+
+	for (int filterY = 0; filterY < filter->size; filterY++) {
+		const double *kernel_row = filter->kernel + filterY * filter->size;
+		size_t offset = filterY * data->input_image->stride;
+
+		for (int filterX = 0; filterX < filter->size; filterX++) {
+			sums[0] += red[offset + filterX] * kernel_row[filterX];
+			sums[1] += green[offset + filterX] * kernel_row[filterX];
+			sums[2] += blue[offset + filterX] * kernel_row[filterX];
+		}
+	}
+}
+
+// Sums the kernel products for `DIRECT_RUN_LENGTH` adjacent interior pixels at once.
+// Every input value loaded for a tap is reused by the neighbouring outputs and each
+// pixel still sums its products in the same order as `interior_pixel()`.
+static inline void interior_run(const struct thread_data *data, size_t x, size_t y,
+								double sums[DIRECT_RUN_LENGTH][3]) {
+	const struct filter *filter = &data->filter;
+	ptrdiff_t corner = input_index(data, (ptrdiff_t)x - filter->size / 2,
+								   (ptrdiff_t)y - filter->size / 2);
+	const unsigned char *red = data->input_image->red + corner;
+	const unsigned char *green = data->input_image->green + corner;
+	const unsigned char *blue = data->input_image->blue + corner;
+
+	for (int filterY = 0; filterY < filter->size; filterY++) {
+		const double *kernel_row = filter->kernel + filterY * filter->size;
+		size_t offset = filterY * data->input_image->stride;
+
+		for (int filterX = 0; filterX < filter->size; filterX++) {
+			double weight = kernel_row[filterX];
+			size_t index = offset + filterX;
+
+			for (int i = 0; i < DIRECT_RUN_LENGTH; i++) {
+				sums[i][0] += red[index + i] * weight;
+				sums[i][1] += green[index + i] * weight;
+				sums[i][2] += blue[index + i] * weight;
+			}
+		}
+	}
+}
+
+// Sums the kernel products for a pixel near the image border, wrapping the taps
+// that fall outside the image around to the opposite side.
+static inline void border_pixel(const struct thread_data *data, size_t x, size_t y,
+								double sums[3]) {
+	const struct filter *filter = &data->filter;
+
+	for (int filterY = 0; filterY < filter->size; filterY++) {
+		const double *kernel_row = filter->kernel + filterY * filter->size;
+
+		for (int filterX = 0; filterX < filter->size; filterX++) {
+			size_t imageX = wrap_position(
+				(ptrdiff_t)x - filter->size / 2 + filterX, data->width);
+			size_t imageY = wrap_position(
+				(ptrdiff_t)y - filter->size / 2 + filterY, data->height);
+			size_t index = input_index(data, imageX, imageY);
+
+			sums[0] += data->input_image->red[index] * kernel_row[filterX];
+			sums[1] += data->input_image->green[index] * kernel_row[filterX];
+			sums[2] += data->input_image->blue[index] * kernel_row[filterX];
+		}
+	}
+}
+
+// Scales the sums, adds the bias and truncates values smaller than zero and larger
+// than 255.
+static inline void store_pixel(const struct thread_data *data, size_t x, size_t y,
+							   const double sums[3]) {
+	const struct filter *filter = &data->filter;
+	size_t index = output_index(data, x, y);
+
+	data->output_image->red[index] =
+		min(max((int)(filter->factor * sums[0] + filter->bias), 0), 255);
+	data->output_image->green[index] =
+		min(max((int)(filter->factor * sums[1] + filter->bias), 0), 255);
+	data->output_image->blue[index] =
+		min(max((int)(filter->factor * sums[2] + filter->bias), 0), 255);
+}
+
+void interior_bounds(int size, size_t length, size_t *begin, size_t *end) {
+	size_t before = size / 2;
+	size_t after = size - 1 - before;
+
+	if (length < before + after) {
+		*begin = 0;
+		*end = 0;
+		return;
+	}
+
+	*begin = before;
+	*end = length - after;
+}
+
+void tap_bounds(const struct thread_data *data, size_t length, size_t *begin,
+				size_t *end) {
+	if (input_halo(data) > 0) {
+		*begin = 0;
+		*end = length;
+		return;
+	}
+
+	interior_bounds(data->filter.size, length, begin, end);
+}
 
 // Source: https://lodev.org/cgtutor/filtering.html
 void sequential_application(struct image_rgb *input_image,
 							struct image_rgb *output_image, int width, int height,
 							struct filter filter) {
-	for (int x = 0; x < width; x++) {
-		for (int y = 0; y < height; y++) {
-			double red = 0.0, green = 0.0, blue = 0.0;
-
-			// multiply every value of the filter with corresponding image pixel
-			for (int filterY = 0; filterY < filter.size; filterY++) {
-				for (int filterX = 0; filterX < filter.size; filterX++) {
-					int imageX = (x - filter.size / 2 + filterX + width) % width;
-					int imageY = (y - filter.size / 2 + filterY + height) % height;
-
-					red += input_image->red[imageY * width + imageX] *
-						   filter.kernel[filterY][filterX];
-					green += input_image->green[imageY * width + imageX] *
-							 filter.kernel[filterY][filterX];
-					blue += input_image->blue[imageY * width + imageX] *
-							filter.kernel[filterY][filterX];
-				}
-			}
+	struct image_rgb padded = {NULL, NULL, NULL, 0, 0, NULL};
+	struct thread_data data = {
+		.input_image = border_input(input_image, width, height, &filter, &padded),
+		.output_image = output_image,
+		.width = width,
+		.height = height,
+		.filter = filter};
+
+	if (data.input_image == NULL) {
+		return;
+	}
+
+	size_t interior_x_begin, interior_x_end, interior_y_begin, interior_y_end;
+	tap_bounds(&data, width, &interior_x_begin, &interior_x_end);
+	tap_bounds(&data, height, &interior_y_begin, &interior_y_end);
+
+	for (size_t x = 0; x < (size_t)width; x++) {
+		size_t begin = 0, end = 0;
+
+		if (x >= interior_x_begin && x < interior_x_end) {
+			begin = interior_y_begin;
+			end = interior_y_end;
+		}
 
-			// truncate values smaller than zero and larger than 255
-			output_image->red[y * width + x] =
-				min(max((int)(filter.factor * red + filter.bias), 0), 255);
-			output_image->green[y * width + x] =
-				min(max((int)(filter.factor * green + filter.bias), 0), 255);
-			output_image->blue[y * width + x] =
-				min(max((int)(filter.factor * blue + filter.bias), 0), 255);
+		// multiply every value of the filter with corresponding image pixel
+		for (size_t y = 0; y < begin; y++) {
+			double sums[3] = {0.0, 0.0, 0.0};
+			border_pixel(&data, x, y, sums);
+			store_pixel(&data, x, y, sums);
+		}
+
+		for (size_t y = begin; y < end; y++) {
+			double sums[3] = {0.0, 0.0, 0.0};
+			interior_pixel(&data, x, y, sums);
+			store_pixel(&data, x, y, sums);
+		}
+
+		for (size_t y = end; y < (size_t)height; y++) {
+			double sums[3] = {0.0, 0.0, 0.0};
+			border_pixel(&data, x, y, sums);
+			store_pixel(&data, x, y, sums);
 		}
 	}
+
+	free_image_rgb(&padded);
 }
 
-void *process_dynamic(void *arg) {
-	struct thread_data *data = (struct thread_data *)arg;
+void sequential_fast_application(struct image_rgb *input_image,
+								 struct image_rgb *output_image, int width,
+								 int height, struct filter filter) {
+	struct image_rgb padded = {NULL, NULL, NULL, 0, 0, NULL};
+	struct thread_data data = {
+		.input_image = border_input(input_image, width, height, &filter, &padded),
+		.output_image = output_image,
+		.width = width,
+		.height = height,
+		.filter = filter};
 
-	while (1) {
-		int block_index = atomic_fetch_add(data->next_block, 1);
+	if (data.input_image != NULL) {
+		apply_filter_to_block(&data, 0, 0, width, height);
+	}
+
+	free(data.scratch);
+	free_image_rgb(&padded);
+}
+
+// Applies the whole 2D kernel to every pixel of the block. Each row is split into
+// the pixels whose neighbourhood wraps around the image border and the interior
+// ones, which are handled without any index arithmetic per tap, several adjacent
+// pixels at a time. All pixels are interior ones if the input has a halo.
+static void direct_block(struct thread_data *data, size_t start_x, size_t start_y,
+						 size_t end_x, size_t end_y) {
+	size_t interior_x_begin, interior_x_end, interior_y_begin, interior_y_end;
+	tap_bounds(data, data->width, &interior_x_begin, &interior_x_end);
+	tap_bounds(data, data->height, &interior_y_begin, &interior_y_end);
+
+	for (size_t y = start_y; y < end_y; y++) {
+		size_t begin = start_x, end = start_x;
+
+		if (y >= interior_y_begin && y < interior_y_end) {
+			begin = min(max(start_x, interior_x_begin), end_x);
+			end = max(min(end_x, interior_x_end), begin);
+		}
 
-		if (block_index >= data->num_blocks) {
+		for (size_t x = start_x; x < begin; x++) {
+			double sums[3] = {0.0, 0.0, 0.0};
+			border_pixel(data, x, y, sums);
+			store_pixel(data, x, y, sums);
+		}
+
+		size_t x = begin;
+
+		for (; x + DIRECT_RUN_LENGTH <= end; x += DIRECT_RUN_LENGTH) {
+			double sums[DIRECT_RUN_LENGTH][3] = {{0.0}};
+			interior_run(data, x, y, sums);
+
+			for (int i = 0; i < DIRECT_RUN_LENGTH; i++) {
+				store_pixel(data, x + i, y, sums[i]);
+			}
+		}
+
+		for (; x < end; x++) {
+			double sums[3] = {0.0, 0.0, 0.0};
+			interior_pixel(data, x, y, sums);
+			store_pixel(data, x, y, sums);
+		}
+
+		for (size_t x = end; x < end_x; x++) {
+			double sums[3] = {0.0, 0.0, 0.0};
+			border_pixel(data, x, y, sums);
+			store_pixel(data, x, y, sums);
+		}
+	}
+}
+
+void apply_filter_to_block(struct thread_data *data, size_t start_x, size_t start_y,
+						   size_t end_x, size_t end_y) {
+	const struct filter *filter = &data->filter;
+	bool done = false;
+
+	switch (choose_engine(filter, end_x - start_x, end_y - start_y)) {
+		case FILTER_ENGINE_SHIFT:
+			shift_block(data, start_x, start_y, end_x, end_y);
+			return;
+		case FILTER_ENGINE_BOX:
+			done = box_block(data, start_x, start_y, end_x, end_y);
+			break;
+		case FILTER_ENGINE_LINE:
+			done = line_block(data, start_x, start_y, end_x, end_y);
 			break;
+		case FILTER_ENGINE_FFT:
+			done = fft_block(data, start_x, start_y, end_x, end_y);
+			break;
+		case FILTER_ENGINE_SEPARABLE:
+			done = separable_block(data, start_x, start_y, end_x, end_y);
+			break;
+		case FILTER_ENGINE_SPARSE:
+			done = sparse_block(data, start_x, start_y, end_x, end_y);
+			break;
+		case FILTER_ENGINE_GENERIC:
+			direct_block(data, start_x, start_y, end_x, end_y);
+			return;
+		default:
+			break;
+	}
+
+	// Engines decline regions they cannot handle, e.g. running sums and FFTs a
+	// kernel larger than the image, or fail to allocate their scratch buffers.
+	if (done) {
+		return;
+	}
+
+	if (filter->fixed_point) {
+		fixed_point_block(data, start_x, start_y, end_x, end_y);
+	} else {
+		direct_block(data, start_x, start_y, end_x, end_y);
+	}
+}
+
+double *reserve_scratch(struct thread_data *data, size_t count) {
+	if (data->scratch_size >= count) {
+		return data->scratch;
+	}
+
+	double *scratch = realloc(data->scratch, count * sizeof(double));
+	if (scratch == NULL) {
+		return NULL;
+	}
+
+	data->scratch = scratch;
+	data->scratch_size = count;
+
+	return scratch;
+}
+
+static const char *const schedule_names[] = {
+	[SCHEDULE_STATIC] = "static",
+	[SCHEDULE_DYNAMIC] = "dynamic",
+	[SCHEDULE_GUIDED] = "guided",
+	[SCHEDULE_STEALING] = "stealing",
+};
+
+const char *schedule_policy_name(enum schedule_policy schedule) {
+	return schedule_names[schedule];
+}
+
+bool parse_schedule_policy(const char *name, enum schedule_policy *schedule) {
+	for (int i = 0; i < NUM_SCHEDULE_POLICIES; i++) {
+		if (strcmp(name, schedule_names[i]) == 0) {
+			*schedule = (enum schedule_policy)i;
+			return true;
 		}
+	}
 
-		size_t block_x = block_index % data->num_cols;
-		size_t block_y = block_index / data->num_cols;
+	return false;
+}
 
-		size_t start_x = block_x * data->block_width;
-		size_t start_y = block_y * data->block_height;
+// Applies the filter to the columns `[start_x, end_x)` of the row of blocks
+// `block_y`, block by block, into the staging buffer, a band of `WRITE_COMBINE_ROWS`
+// rows at a time, and copies every finished row of the band to the output planes.
+// Returns `false` if the staging buffer cannot be allocated.
+static bool staged_blocks(struct thread_data *data, size_t block_y, size_t start_x,
+						  size_t end_x) {
+	size_t stride = image_stride((size_t)data->group_blocks * data->block_width);
+	size_t band_size = stride * WRITE_COMBINE_ROWS;
+
+	if (data->staging == NULL) {
+		data->staging = aligned_alloc(CACHE_LINE_SIZE, 3 * band_size);
+		if (data->staging == NULL) {
+			return false;
+		}
+	}
+
+	size_t start_y = block_y * data->block_height;
+	size_t end_y = min(start_y + data->block_height, (size_t)data->height);
+	size_t unit_width = end_x - start_x;
+
+	struct image_rgb *output_image = data->output_image;
+	struct image_rgb staging = {data->staging, data->staging + band_size,
+								data->staging + 2 * band_size, stride, 0, NULL};
+	unsigned char *outputs[] = {output_image->red, output_image->green,
+								output_image->blue};
+	unsigned char *staged[] = {staging.red, staging.green, staging.blue};
 
+	data->output_image = &staging;
+	data->output_x = start_x;
+
+	for (size_t band_y = start_y; band_y < end_y; band_y += WRITE_COMBINE_ROWS) {
+		size_t band_end = min(band_y + WRITE_COMBINE_ROWS, end_y);
+		data->output_y = band_y;
+
+		for (size_t x = start_x; x < end_x; x += data->block_width) {
+			apply_filter_to_block(data, x, band_y,
+								  min(x + data->block_width, end_x), band_end);
+		}
+
+		for (size_t y = band_y; y < band_end; y++) {
+			for (int c = 0; c < 3; c++) {
+				memcpy(outputs[c] + y * output_image->stride + start_x,
+					   staged[c] + (y - band_y) * stride, unit_width);
+			}
+		}
+	}
+
+	data->output_image = output_image;
+	data->output_x = 0;
+	data->output_y = 0;
+
+	return true;
+}
+
+static void process_unit(struct thread_data *data, int unit_index) {
+	size_t block_y = unit_index / data->num_groups;
+	size_t first = (unit_index % data->num_groups) * data->group_blocks;
+	size_t last = min(first + data->group_blocks, (size_t)data->num_cols);
+
+	size_t start_y = block_y * data->block_height;
+	size_t end_y = min(start_y + data->block_height, (size_t)data->height);
+
+	// Blocks narrower than a cache line share the lines of their unit
+	if (data->group_blocks > 1 &&
+		staged_blocks(data, block_y, first * data->block_width,
+					  min(last * data->block_width, (size_t)data->width))) {
+		return;
+	}
+
+	for (size_t block_x = first; block_x < last; block_x++) {
+		size_t start_x = block_x * data->block_width;
 		size_t end_x = min(start_x + data->block_width, (size_t)data->width);
-		size_t end_y = min(start_y + data->block_height, (size_t)data->height);
-
-		for (size_t y = start_y; y < end_y; y++) {
-			for (size_t x = start_x; x < end_x; x++) {
-				double red = 0.0, green = 0.0, blue = 0.0;
-
-				for (int filterY = 0; filterY < data->filter.size; filterY++) {
-					for (int filterX = 0; filterX < data->filter.size; filterX++) {
-						size_t imageX =
-							(x - data->filter.size / 2 + filterX + data->width) %
-							data->width;
-						size_t imageY =
-							(y - data->filter.size / 2 + filterY + data->height) %
-							data->height;
-
-						red +=
-							data->input_image->red[imageY * data->width + imageX] *
-							data->filter.kernel[filterY][filterX];
-						green +=
-							data->input_image->green[imageY * data->width + imageX] *
-							data->filter.kernel[filterY][filterX];
-						blue +=
-							data->input_image->blue[imageY * data->width + imageX] *
-							data->filter.kernel[filterY][filterX];
-					}
-				}
-
-				data->output_image->red[y * data->width + x] =
-					min(max((int)(data->filter.factor * red + data->filter.bias), 0),
-						255);
-				data->output_image->green[y * data->width + x] = min(
-					max((int)(data->filter.factor * green + data->filter.bias), 0),
-					255);
-				data->output_image->blue[y * data->width + x] = min(
-					max((int)(data->filter.factor * blue + data->filter.bias), 0),
-					255);
+
+		apply_filter_to_block(data, start_x, start_y, end_x, end_y);
+	}
+}
+
+// Processes the units from `first` to `last` (excluded)
+static void process_units(struct thread_data *data, int first, int last) {
+	for (int unit_index = first; unit_index < last; unit_index++) {
+		process_unit(data, unit_index);
+	}
+}
+
+// Claims the units from `*first` to `*last` (excluded) from the shared counter, a
+// chunk at a time or a share of the remaining units (`SCHEDULE_GUIDED`)
+static bool claim_units(struct thread_data *data, int *first, int *last) {
+	if (data->schedule == SCHEDULE_DYNAMIC) {
+		*first = atomic_fetch_add(data->next_block, data->chunk_size);
+		*last = min(*first + data->chunk_size, data->num_units);
+		return *first < data->num_units;
+	}
+
+	int count;
+	*first = atomic_load(data->next_block);
+	do {
+		int remaining = data->num_units - *first;
+		if (remaining <= 0) {
+			return false;
+		}
+		count = min(max(remaining / data->num_threads, data->chunk_size), remaining);
+	} while (!atomic_compare_exchange_weak(data->next_block, first, *first + count));
+
+	*last = *first + count;
+	return true;
+}
+
+// Picks a random other deque (xorshift)
+static int random_victim(struct thread_data *data) {
+	data->seed ^= data->seed << 13;
+	data->seed ^= data->seed >> 17;
+	data->seed ^= data->seed << 5;
+
+	int victim = (int)(data->seed % (unsigned int)(data->num_threads - 1));
+	return victim < data->index ? victim : victim + 1;
+}
+
+// Steals a chunk from the other deques, starting at a random one. Nothing is pushed
+// once the threads run, so the blocks are done when every deque is seen empty.
+static int steal_chunk(struct thread_data *data) {
+	if (data->num_threads < 2) {
+		return WORK_DEQUE_EMPTY;
+	}
+
+	bool aborted;
+	do {
+		int first = random_victim(data);
+		aborted = false;
+
+		for (int i = 0; i < data->num_threads; i++) {
+			int victim = (first + i) % data->num_threads;
+			if (victim == data->index) {
+				continue;
+			}
+
+			int chunk = work_deque_steal(&data->deques[victim]);
+			if (chunk >= 0) {
+				return chunk;
 			}
+			aborted |= chunk == WORK_DEQUE_ABORT;
 		}
+	} while (aborted);
+
+	return WORK_DEQUE_EMPTY;
+}
+
+// Processes the chunks of the thread's deque, then the ones it steals
+static void process_stealing(struct thread_data *data) {
+	struct work_deque *own = &data->deques[data->index];
+
+	while (1) {
+		int chunk = work_deque_take(own);
+		if (chunk < 0) {
+			chunk = steal_chunk(data);
+		}
+		if (chunk < 0) {
+			break;
+		}
+
+		int first = chunk * data->chunk_size;
+		process_units(data, first, min(first + data->chunk_size, data->num_units));
 	}
+}
+
+void *process_dynamic(void *arg) {
+	struct thread_data *data = (struct thread_data *)arg;
+
+	int first, last;
+
+	switch (data->schedule) {
+		case SCHEDULE_STATIC:
+			first = (int)((long)data->num_units * data->index / data->num_threads);
+			last = (int)((long)data->num_units * (data->index + 1) /
+						 data->num_threads);
+			process_units(data, first, last);
+			break;
+		case SCHEDULE_STEALING:
+			process_stealing(data);
+			break;
+		default:
+			while (claim_units(data, &first, &last)) {
+				process_units(data, first, last);
+			}
+			break;
+	}
+
+	free(data->scratch);
+	data->scratch = NULL;
+	data->scratch_size = 0;
+	free(data->staging);
+	data->staging = NULL;
 
-	pthread_exit(NULL);
+	return NULL;
 }
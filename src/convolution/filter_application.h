@@ -2,15 +2,49 @@
 
 #include <pthread.h>
 #include <stdatomic.h>
+#include <stddef.h>
 #include <stdio.h>
 
 #include "../utils/utils.h"
+#include "../utils/work_deque.h"
 
 #include "../filters/filter.h"
 
+#define DIRECT_RUN_LENGTH 4 // Adjacent output pixels computed per inner iteration
+#define STEALING_CHUNKS_PER_THREAD 32 // Chunks of units each deque is seeded with
+#define WRITE_COMBINE_ROWS 32 // Rows of output staged at a time for sub-line units
+
+/**
+ * Policies distributing the work units of an image (see `struct thread_data`) among
+ * the threads of `process_dynamic()`. A chunk is a run of consecutive units.
+ *
+ * - `SCHEDULE_STATIC`: every thread processes one contiguous range of the image,
+ * without any claim.
+ * - `SCHEDULE_DYNAMIC`: every thread claims the next chunk from one shared counter.
+ * - `SCHEDULE_GUIDED`: like `SCHEDULE_DYNAMIC`, but every claim takes the remaining
+ * units divided by the number of threads, at least a chunk, so that the claims
+ * shrink towards the end of the image.
+ * - `SCHEDULE_STEALING`: every thread takes chunks from its own deque, seeded with a
+ * contiguous range of the image, and steals chunks from random other threads once
+ * it runs dry.
+ */
+enum schedule_policy {
+	SCHEDULE_STATIC,
+	SCHEDULE_DYNAMIC,
+	SCHEDULE_GUIDED,
+	SCHEDULE_STEALING,
+	NUM_SCHEDULE_POLICIES,
+};
+
 /**
  * Represents the data passed to each thread during parallel filter application.
  *
+ * The image is split into blocks, and the blocks into work units: a unit is a
+ * block, or, for blocks narrower than a cache line, the `group_blocks` adjacent
+ * blocks of a row of blocks that cover the same `CACHE_LINE_SIZE` columns, so that
+ * two threads never write the same line of the output planes. The output of such
+ * sub-line blocks is staged in `staging` and written a whole line at a time.
+ *
  * @param input_image Pointer to the input image (RGB channels) to be processed.
  * @param output_image Pointer to the output image (RGB channels) where the result
  * will be stored.
@@ -20,9 +54,29 @@
  * @param block_width Width of each processing block in the image.
  * @param block_height Height of each processing block in the image.
  * @param num_cols Number of columns of blocks in the image.
- * @param num_blocks Total number of blocks in the image.
- * @param next_block Atomic integer pointer used to assign blocks dynamically to
- * threads.
+ * @param group_blocks Number of blocks of a row of blocks in a unit.
+ * @param num_groups Number of units in a row of blocks.
+ * @param num_units Total number of units in the image.
+ * @param next_block Atomic integer pointer used to assign units dynamically to
+ * threads (`SCHEDULE_DYNAMIC` and `SCHEDULE_GUIDED`).
+ * @param schedule Policy distributing the units among the threads.
+ * @param deques The work-stealing deques of all the threads, holding indices of
+ * chunks (`SCHEDULE_STEALING`).
+ * @param num_threads Number of threads.
+ * @param index Index of the thread, and of its deque.
+ * @param chunk_size Number of units of a chunk, the smallest claim of
+ * `SCHEDULE_GUIDED`.
+ * @param seed State of the generator picking the victims of steals.
+ * @param scratch Per-thread buffer for intermediate results (e.g. the horizontal
+ * pass of a separable filter), grown on demand by `reserve_scratch()`.
+ * @param scratch_size Number of `double` values `scratch` can hold.
+ * @param output_x Column of the image stored first in the rows of `output_image`.
+ * @param output_y Row of the image stored first in `output_image` (see
+ * `output_index()`).
+ * @param staging Per-thread buffer the output of sub-line units is written to,
+ * `WRITE_COMBINE_ROWS` rows of a unit per channel, allocated on demand.
+ * @param box_sums Summed-area tables of `input_image` the box engine reads (see
+ * `build_box_sums()`), shared by all threads, `NULL` to use running sums.
  */
 struct thread_data {
 	struct image_rgb *input_image;
@@ -33,12 +87,56 @@ struct thread_data {
 	int block_width;
 	int block_height;
 	int num_cols;
-	int num_blocks;
+	int group_blocks;
+	int num_groups;
+	int num_units;
 	atomic_int *next_block;
+	enum schedule_policy schedule;
+	struct work_deque *deques;
+	int num_threads;
+	int index;
+	int chunk_size;
+	unsigned int seed;
+	double *scratch;
+	size_t scratch_size;
+	size_t output_x;
+	size_t output_y;
+	unsigned char *staging;
+	const struct box_sums *box_sums;
 };
 
 /**
- * Applies a convolution filter sequentially to an image.
+ * Returns the index of pixel (`x`, `y`) in the channels of `input_image`, negative
+ * for pixels of the halo above the image.
+ *
+ * @param data The data of the thread.
+ * @param x Column of the pixel, negative in the halo left of the image.
+ * @param y Row of the pixel, negative in the halo above the image.
+ */
+static inline ptrdiff_t input_index(const struct thread_data *data, ptrdiff_t x,
+									ptrdiff_t y) {
+	return y * (ptrdiff_t)data->input_image->stride + x;
+}
+
+/**
+ * Returns the index of the output of pixel (`x`, `y`) in the channels of
+ * `output_image`, which may hold a window of the image only.
+ *
+ * @param data The data of the thread.
+ * @param x Column of the pixel, at least `output_x`.
+ * @param y Row of the pixel, at least `output_y`.
+ */
+static inline size_t output_index(const struct thread_data *data, size_t x,
+								  size_t y) {
+	return (y - data->output_y) * data->output_image->stride + (x - data->output_x);
+}
+
+/**
+ * Applies a convolution filter sequentially to an image. This is the reference
+ * implementation: it walks the image column by column and applies the whole kernel
+ * in floating point, the other modes are checked against its output. The taps
+ * outside the image read the pixels the border mode of the filter selects (see
+ * `border_input()`).
  *
  * @param input_image Pointer to the input image (`struct image_rgb`).
  * @param output_image Pointer to the output image (`struct image_rgb`).
@@ -51,7 +149,142 @@ void sequential_application(struct image_rgb *input_image,
 							struct filter filter);
 
 /**
- * Processes image blocks dynamically in a parallel execution environment.
+ * Applies a convolution filter sequentially to an image, row by row, using the
+ * fastest engine for the filter (see `apply_filter_to_block()`). The result is
+ * identical to the one of `sequential_application()`.
+ *
+ * @param input_image Pointer to the input image (`struct image_rgb`).
+ * @param output_image Pointer to the output image (`struct image_rgb`).
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param filter The convolution filter to be applied.
+ */
+void sequential_fast_application(struct image_rgb *input_image,
+								 struct image_rgb *output_image, int width,
+								 int height, struct filter filter);
+
+/**
+ * Applies the filter to the output region `[start_x, end_x) x [start_y, end_y)`
+ * with the engine `choose_engine()` resolves `filter.engine` to for the region (see
+ * `dispatch.h`): shifts are copied, box and line filters applied with running sums,
+ * large kernels over large regions with FFTs, separable filters in two 1D passes,
+ * filters with small integer kernels in fixed point, sparse filters over their
+ * non-zero taps and all others directly in floating point, `DIRECT_RUN_LENGTH`
+ * adjacent pixels at a time. If the engine declines the region (e.g. the running
+ * sums a kernel larger than the image), the fixed-point or direct engine applies it.
+ *
+ * @param data Pointer to the `struct thread_data` describing the images and filter.
+ * @param start_x First column of the region.
+ * @param start_y First row of the region.
+ * @param end_x Column after the last one of the region.
+ * @param end_y Row after the last one of the region.
+ */
+void apply_filter_to_block(struct thread_data *data, size_t start_x, size_t start_y,
+						   size_t end_x, size_t end_y);
+
+/**
+ * Computes the range of positions along one image axis at which the whole kernel
+ * fits inside the image, i.e. where no tap has to wrap around the border. The range
+ * is empty if the image is smaller than the kernel.
+ *
+ * @param size Size of the filter kernel.
+ * @param length Width or height of the image.
+ * @param begin Receives the first interior position.
+ * @param end Receives the position after the last interior one.
+ */
+void interior_bounds(int size, size_t length, size_t *begin, size_t *end);
+
+/**
+ * Computes the range of positions along one image axis whose taps are all read
+ * without wrapping: the whole axis if the input has a halo for the filter (see
+ * `input_halo()`), the range of `interior_bounds()` otherwise.
+ *
+ * @param data The data of the thread.
+ * @param length Width or height of the image.
+ * @param begin Receives the first such position.
+ * @param end Receives the position after the last such one.
+ */
+void tap_bounds(const struct thread_data *data, size_t length, size_t *begin,
+				size_t *end);
+
+/**
+ * Wraps a coordinate that may lie outside the image (e.g. a tap of a border pixel)
+ * around to the opposite side.
+ *
+ * @param position The coordinate, possibly negative or past the end.
+ * @param length Width or height of the image.
+ *
+ * @return The coordinate wrapped into `[0, length)`.
+ */
+static inline size_t wrap_position(ptrdiff_t position, size_t length) {
+	ptrdiff_t wrapped = position % (ptrdiff_t)length;
+	return wrapped < 0 ? (size_t)(wrapped + (ptrdiff_t)length) : (size_t)wrapped;
+}
+
+/**
+ * Returns how far outside the image the taps of the filter are read directly from
+ * the halo of `input_image`, which `border_input()` fills with the border mode of
+ * the filter: the whole halo if it is at least as wide as the radius of the filter,
+ * otherwise `0`, and the engines wrap the taps around the image themselves.
+ *
+ * @param data The data of the thread.
+ */
+static inline ptrdiff_t input_halo(const struct thread_data *data) {
+	int halo = data->input_image->halo;
+	return halo >= data->filter.size / 2 ? halo : 0;
+}
+
+/**
+ * Maps the row or column of a tap, which may lie outside the image, to the one it
+ * is read from: itself within the halo of the input (see `input_halo()`), otherwise
+ * wrapped around the image.
+ *
+ * @param data The data of the thread.
+ * @param position The coordinate, possibly negative or past the end.
+ * @param length Width or height of the image.
+ *
+ * @return The coordinate in `[-input_halo(), length + input_halo())`.
+ */
+static inline ptrdiff_t tap_position(const struct thread_data *data,
+									 ptrdiff_t position, size_t length) {
+	ptrdiff_t halo = input_halo(data);
+
+	if (position >= -halo && position < (ptrdiff_t)length + halo) {
+		return position;
+	}
+	return (ptrdiff_t)wrap_position(position, length);
+}
+
+/**
+ * Makes sure the thread's scratch buffer holds at least `count` values.
+ *
+ * @param data Pointer to the `struct thread_data` owning the buffer.
+ * @param count Required number of `double` values.
+ *
+ * @return Pointer to the buffer, or `NULL` if memory allocation fails.
+ */
+double *reserve_scratch(struct thread_data *data, size_t count);
+
+/**
+ * Returns a printable name of a scheduling policy (e.g. "stealing").
+ *
+ * @param schedule The policy.
+ */
+const char *schedule_policy_name(enum schedule_policy schedule);
+
+/**
+ * Finds the scheduling policy with the given name.
+ *
+ * @param name Name of the policy, as given by `schedule_policy_name()`.
+ * @param schedule Receives the policy.
+ *
+ * @return `true` if the name is known.
+ */
+bool parse_schedule_policy(const char *name, enum schedule_policy *schedule);
+
+/**
+ * Processes image blocks dynamically in a parallel execution environment, as
+ * distributed by the policy `schedule`.
  *
  * @param arg A pointer to a `struct thread_data` containing the thread's processing
  * data.
@@ -0,0 +1,71 @@
+#include "fixed_point.h"
+#include "simd.h"
+
+// Sums the kernel products for a pixel near the image border, wrapping the taps
+// that fall outside the image around to the opposite side.
+static inline void border_pixel(const struct thread_data *data, size_t x, size_t y,
+								int32_t sums[3]) {
+	const struct filter *filter = &data->filter;
+
+	for (int i = 0; i < filter->num_taps; i++) {
+		const struct filter_tap *tap = &filter->taps[i];
+		size_t imageX = wrap_position((ptrdiff_t)x + tap->dx, data->width);
+		size_t imageY = wrap_position((ptrdiff_t)y + tap->dy, data->height);
+		size_t index = input_index(data, imageX, imageY);
+
+		sums[0] += data->input_image->red[index] * tap->fixed_weight;
+		sums[1] += data->input_image->green[index] * tap->fixed_weight;
+		sums[2] += data->input_image->blue[index] * tap->fixed_weight;
+	}
+}
+
+static inline void store_pixel(const struct thread_data *data, size_t x, size_t y,
+							   const int32_t sums[3]) {
+	size_t index = output_index(data, x, y);
+
+	data->output_image->red[index] = fixed_point_scale(&data->filter, sums[0]);
+	data->output_image->green[index] = fixed_point_scale(&data->filter, sums[1]);
+	data->output_image->blue[index] = fixed_point_scale(&data->filter, sums[2]);
+}
+
+void fixed_point_block(struct thread_data *data, size_t start_x, size_t start_y,
+					   size_t end_x, size_t end_y) {
+	fixed_point_row_fn interior_row = get_fixed_point_row(detect_simd_level());
+
+	unsigned char *inputs[] = {data->input_image->red, data->input_image->green,
+							   data->input_image->blue};
+	unsigned char *outputs[] = {data->output_image->red, data->output_image->green,
+								data->output_image->blue};
+
+	size_t interior_x_begin, interior_x_end, interior_y_begin, interior_y_end;
+	tap_bounds(data, data->width, &interior_x_begin, &interior_x_end);
+	tap_bounds(data, data->height, &interior_y_begin, &interior_y_end);
+
+	for (size_t y = start_y; y < end_y; y++) {
+		size_t begin = start_x, end = start_x;
+
+		if (y >= interior_y_begin && y < interior_y_end) {
+			begin = min(max(start_x, interior_x_begin), end_x);
+			end = max(min(end_x, interior_x_end), begin);
+		}
+
+		for (size_t x = start_x; x < begin; x++) {
+			int32_t sums[3] = {0, 0, 0};
+			border_pixel(data, x, y, sums);
+			store_pixel(data, x, y, sums);
+		}
+
+		for (int c = 0; c < 3 && begin < end; c++) {
+			interior_row(inputs[c] + input_index(data, begin, y),
+						 data->input_image->stride,
+						 outputs[c] + output_index(data, begin, y), end - begin,
+						 &data->filter);
+		}
+
+		for (size_t x = end; x < end_x; x++) {
+			int32_t sums[3] = {0, 0, 0};
+			border_pixel(data, x, y, sums);
+			store_pixel(data, x, y, sums);
+		}
+	}
+}
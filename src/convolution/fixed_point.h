@@ -0,0 +1,37 @@
+#pragma once
+
+#include "filter_application.h"
+
+/**
+ * Scales a fixed-point kernel sum with the filter's factor and bias and truncates
+ * values smaller than zero and larger than 255. The shift relies on `>>` being
+ * arithmetic for negative values, as it is on every compiler we build with.
+ *
+ * @param filter The fixed-point filter.
+ * @param sum Sum of the kernel products for one pixel of one channel.
+ *
+ * @return The output pixel value.
+ */
+static inline unsigned char fixed_point_scale(const struct filter *filter,
+											  int32_t sum) {
+	int32_t value = (sum * filter->fixed_multiplier + filter->fixed_offset) >>
+					filter->fixed_shift;
+	return min(max(value, 0), 255);
+}
+
+/**
+ * Applies a fixed-point filter (`filter.fixed_point`) to the output region
+ * `[start_x, end_x) x [start_y, end_y)`. The 8-bit pixels are multiplied by the
+ * integer kernel and accumulated in `int32_t`, and the result is scaled with a
+ * single multiply-shift, which gives exactly the same values as the floating-point
+ * path. The interior of each row is computed by the vectorized kernel for the
+ * instruction set detected at startup (see `simd.h`).
+ *
+ * @param data Pointer to the `struct thread_data` describing the images and filter.
+ * @param start_x First column of the region.
+ * @param start_y First row of the region.
+ * @param end_x Column after the last one of the region.
+ * @param end_y Row after the last one of the region.
+ */
+void fixed_point_block(struct thread_data *data, size_t start_x, size_t start_y,
+					   size_t end_x, size_t end_y);
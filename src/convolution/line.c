@@ -0,0 +1,211 @@
+#include "line.h"
+#include "fixed_point.h"
+#include "simd.h"
+
+// Counts the pixels of a `width` x `height` region whose predecessor along the
+// slide lies outside of it, so they have to sum all taps.
+static size_t edge_pixels(const struct filter_slide *slide, size_t width,
+						  size_t height) {
+	size_t rows = min((size_t)slide->dy, height);
+	size_t columns = min((size_t)abs(slide->dx), width);
+
+	return rows * width + (height - rows) * columns;
+}
+
+// Picks the slide with the fewest taps over the region, or returns `NULL` if
+// summing all taps of every pixel is as cheap.
+static const struct filter_slide *
+choose_slide(const struct filter *filter, size_t width, size_t height) {
+	const struct filter_slide *best = NULL;
+	double best_cost = (double)filter->num_taps * width * height;
+
+	for (int i = 0; i < NUM_LINE_SLIDES; i++) {
+		const struct filter_slide *slide = &filter->slides[i];
+		double edge = (double)edge_pixels(slide, width, height);
+		double cost = slide->num_taps * ((double)width * height - edge) +
+					  filter->num_taps * edge;
+
+		if (cost < best_cost) {
+			best_cost = cost;
+			best = slide;
+		}
+	}
+
+	return best;
+}
+
+// Sums all taps of the pixels `[begin, end)` of row `y` of one channel, wrapping
+// them around the image borders unless the input has a halo, and writes the scaled
+// sums to `output` (`sums` and `output` point to the values of `begin`).
+static void full_sums(const struct thread_data *data, const unsigned char *input,
+					  int32_t *sums, unsigned char *output, size_t y, size_t begin,
+					  size_t end) {
+	const struct filter *filter = &data->filter;
+	size_t count = end - begin;
+	ptrdiff_t wrap = input_halo(data) > 0 ? PTRDIFF_MAX : data->width;
+
+	for (size_t x = 0; x < count; x++) {
+		sums[x] = 0;
+	}
+
+	for (int i = 0; i < filter->num_taps && count > 0; i++) {
+		const struct filter_tap *tap = &filter->taps[i];
+		ptrdiff_t row = tap_position(data, (ptrdiff_t)y + tap->dy, data->height);
+		const unsigned char *line = input + input_index(data, 0, row);
+		ptrdiff_t column =
+			tap_position(data, (ptrdiff_t)begin + tap->dx, data->width);
+
+		for (size_t x = 0; x < count; x++) {
+			sums[x] += tap->fixed_weight * line[column];
+
+			if (++column == wrap) {
+				column = 0;
+			}
+		}
+	}
+
+	for (size_t x = 0; x < count; x++) {
+		output[x] = fixed_point_scale(filter, sums[x]);
+	}
+}
+
+// Continues the sums of the pixels `[begin, end)` of one channel with taps that
+// wrap around the image border, one pixel at a time.
+static void continue_border(const struct thread_data *data,
+							const struct filter_slide *slide,
+							const unsigned char *const *lines, int32_t *sums,
+							const int32_t *previous, unsigned char *output,
+							size_t begin, size_t end) {
+	for (size_t x = 0; x < end - begin; x++) {
+		int32_t sum = previous[x];
+
+		for (int i = 0; i < slide->num_taps; i++) {
+			const struct filter_tap *tap = &slide->taps[i];
+			ptrdiff_t column =
+				tap_position(data, (ptrdiff_t)(begin + x) + tap->dx, data->width);
+			sum += tap->fixed_weight * lines[i][column];
+		}
+
+		sums[x] = sum;
+		output[x] = fixed_point_scale(&data->filter, sum);
+	}
+}
+
+// Continues the sums of the pixels `[begin, end)` of row `y` of one channel from
+// the sums of their predecessors in `previous` and the taps of the slide, and
+// writes the scaled sums to `output` (all three point to the values of `begin`).
+// Along rows `previous` lies before `sums` in the same row.
+static void continue_sums(const struct thread_data *data,
+						  const struct filter_slide *slide, line_row_fn line_row,
+						  const unsigned char *input, int32_t *sums,
+						  const int32_t *previous, unsigned char *output, size_t y,
+						  size_t begin, size_t end) {
+	const unsigned char *lines[slide->num_taps];
+	const unsigned char *pixels[slide->num_taps];
+	int32_t weights[slide->num_taps];
+	int lowest = 0, highest = 0;
+
+	for (int i = 0; i < slide->num_taps; i++) {
+		const struct filter_tap *tap = &slide->taps[i];
+		ptrdiff_t row = tap_position(data, (ptrdiff_t)y + tap->dy, data->height);
+
+		lines[i] = input + input_index(data, 0, row);
+		weights[i] = tap->fixed_weight;
+		lowest = min(lowest, tap->dx);
+		highest = max(highest, tap->dx);
+	}
+
+	// No tap of the pixels `[inner_begin, inner_end)` wraps around the border, and
+	// none of any pixel with a halo
+	size_t inner_begin = begin, inner_end = end;
+	if (input_halo(data) == 0) {
+		inner_begin = min(max((size_t)-lowest, begin), end);
+		inner_end =
+			max(min((size_t)max(data->width - highest, 0), end), inner_begin);
+	}
+	size_t skip = inner_begin - begin;
+
+	continue_border(data, slide, lines, sums, previous, output, begin, inner_begin);
+
+	if (inner_begin < inner_end) {
+		for (int i = 0; i < slide->num_taps; i++) {
+			pixels[i] = lines[i] + inner_begin + slide->taps[i].dx;
+		}
+
+		line_row(pixels, weights, slide->num_taps, previous + skip, sums + skip,
+				 output + skip, inner_end - inner_begin, &data->filter);
+	}
+
+	skip = inner_end - begin;
+	continue_border(data, slide, lines, sums + skip, previous + skip,
+					output + skip, inner_end, end);
+}
+
+bool line_block(struct thread_data *data, size_t start_x, size_t start_y,
+				size_t end_x, size_t end_y) {
+	const struct filter *filter = &data->filter;
+
+	// A kernel larger than the image wraps around it more than once, which the
+	// running sums do not reproduce, unless the input has a halo.
+	if (input_halo(data) == 0 &&
+		(filter->size > data->width || filter->size > data->height)) {
+		return false;
+	}
+
+	if (start_x >= end_x || start_y >= end_y) {
+		return true;
+	}
+
+	size_t width = end_x - start_x;
+	const struct filter_slide *slide =
+		choose_slide(filter, width, end_y - start_y);
+	if (slide == NULL) {
+		return false;
+	}
+
+	// The sums are `int32_t` values, two of them per `double` of the buffer
+	size_t rows = slide->dy + 1;
+	int32_t *scratch = (int32_t *)reserve_scratch(data, (3 * rows * width + 1) / 2);
+	if (scratch == NULL) {
+		return false;
+	}
+
+	// Along rows the sums depend on the ones just computed, which only the scalar
+	// kernel handles.
+	line_row_fn line_row =
+		get_line_row(slide->dy > 0 ? detect_simd_level() : SIMD_NONE);
+
+	const unsigned char *inputs[] = {data->input_image->red,
+									 data->input_image->green,
+									 data->input_image->blue};
+	unsigned char *outputs[] = {data->output_image->red, data->output_image->green,
+								data->output_image->blue};
+
+	for (size_t y = start_y; y < end_y; y++) {
+		// The pixels `[begin, end)` of the region continue the sums of pixels in it
+		size_t begin = 0, end = 0;
+
+		if (y - start_y >= (size_t)slide->dy && (size_t)abs(slide->dx) < width) {
+			begin = max(slide->dx, 0);
+			end = width - max(-slide->dx, 0);
+		}
+
+		size_t current_row = (y - start_y) % rows;
+		size_t previous_row = (y - start_y + rows - slide->dy) % rows;
+
+		for (int c = 0; c < 3; c++) {
+			int32_t *sums = scratch + (c * rows + current_row) * width;
+			const int32_t *previous = scratch + (c * rows + previous_row) * width;
+			unsigned char *out = outputs[c] + output_index(data, start_x, y);
+
+			full_sums(data, inputs[c], sums, out, y, start_x, start_x + begin);
+			continue_sums(data, slide, line_row, inputs[c], sums + begin,
+						  previous + begin - slide->dx, out + begin, y,
+						  start_x + begin, start_x + end);
+			full_sums(data, inputs[c], sums + end, out + end, y, start_x + end,
+					  end_x);
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "filter_application.h"
+
+/**
+ * Applies a line filter (`filter.line`, e.g. a motion blur) to the output region
+ * `[start_x, end_x) x [start_y, end_y)` with running sums along one of its slides:
+ * the sum of each pixel is the one of the pixel a step behind it plus the few taps
+ * of the slide, so the cost per pixel does not depend on the length of the line.
+ * Only the pixels whose predecessor lies outside the region sum all the taps. The
+ * slide is picked per region, so rows and columns of one pixel use the slide along
+ * them. The thread's scratch buffer keeps the sums of the last `dy + 1` rows. All
+ * sums are integers, so the result is identical to the one of the direct
+ * application.
+ *
+ * @param data Pointer to the `struct thread_data` describing the images and filter.
+ * @param start_x First column of the region.
+ * @param start_y First row of the region.
+ * @param end_x Column after the last one of the region.
+ * @param end_y Row after the last one of the region.
+ *
+ * @return `true` on success, `false` if the kernel is larger than the image, no
+ * slide is cheaper than summing all taps over the region or the scratch buffer
+ * could not be allocated (nothing is written in that case).
+ */
+bool line_block(struct thread_data *data, size_t start_x, size_t start_y,
+				size_t end_x, size_t end_y);
@@ -1,22 +1,141 @@
 #include "parallel_dispatch.h"
+#include "border.h"
+#include "box.h"
+#include "chain.h"
+#include "dispatch.h"
+#include "simd.h"
+#include "../utils/thread_pool.h"
+
+// Policy and chunk size of the parallel modes, set once from the command line
+static enum schedule_policy parallel_schedule = SCHEDULE_DYNAMIC;
+static int parallel_chunk_size = 0;
+
+void set_parallel_schedule(enum schedule_policy schedule, int chunk_size) {
+	parallel_schedule = schedule;
+	parallel_chunk_size = chunk_size;
+}
+
+enum schedule_policy get_parallel_schedule(void) {
+	return parallel_schedule;
+}
+
+// Whether blocks narrower than a cache line are grouped into line-wide units
+static bool line_units = true;
+
+void set_line_units(bool enabled) {
+	line_units = enabled;
+}
+
+// Number of blocks of a row of blocks grouped into a unit
+static int unit_blocks(int block_width) {
+	return line_units ? max((CACHE_LINE_SIZE + block_width - 1) / block_width, 1)
+					  : 1;
+}
+
+int parallel_num_units(int width, int height, int block_width, int block_height) {
+	if (width <= 0 || height <= 0) {
+		return 0;
+	}
+
+	int num_cols = (width + block_width - 1) / block_width;
+	int num_rows = (height + block_height - 1) / block_height;
+	int group_blocks = unit_blocks(block_width);
+
+	return (num_cols + group_blocks - 1) / group_blocks * num_rows;
+}
+
+int schedule_chunk_size(enum schedule_policy schedule, int chunk_size,
+						int num_units, int num_threads) {
+	// A chunk never exceeds the share of a thread, so that all of them get work
+	int share = max(num_units / num_threads, 1);
+
+	if (chunk_size <= 0) {
+		chunk_size = schedule == SCHEDULE_STEALING
+						 ? num_units / (num_threads * STEALING_CHUNKS_PER_THREAD)
+						 : 1;
+	}
+
+	return min(max(chunk_size, 1), share);
+}
+
+// Seeds the deque of each thread with the chunks of a contiguous range of the
+// image. They are pushed in reverse, so that the owner takes them in order and
+// thieves steal from the far end of the range.
+static int seed_deques(struct work_deque *deques, int num_threads, int num_chunks) {
+	for (int i = 0; i < num_threads; i++) {
+		int first = (int)((long)num_chunks * i / num_threads);
+		int last = (int)((long)num_chunks * (i + 1) / num_threads);
+
+		if (work_deque_init(&deques[i], last - first) != 0) {
+			error("Memory allocation error for the work deques\n");
+			for (int j = 0; j < i; j++) {
+				work_deque_free(&deques[j]);
+			}
+			return -1;
+		}
+
+		for (int chunk = last - 1; chunk >= first; chunk--) {
+			work_deque_push(&deques[i], chunk);
+		}
+	}
+
+	return 0;
+}
 
-// A helper function that implements parallel filter application using dynamic block
-// assignment.
 int parallel_filter(struct image_rgb *input_image, struct image_rgb *output_image,
 					int width, int height, struct filter filter, int num_threads,
-					int block_width, int block_height) {
-	pthread_t threads[num_threads];
+					int block_width, int block_height,
+					enum schedule_policy schedule, int chunk_size) {
+	if (width <= 0 || height <= 0) {
+		return 0;
+	}
+
+	struct image_rgb padded = {NULL, NULL, NULL, 0, 0, NULL};
+	struct image_rgb *source =
+		border_input(input_image, width, height, &filter, &padded);
+	if (source == NULL) {
+		return -1;
+	}
+
 	struct thread_data thread_data_array[num_threads];
 
 	int num_cols = (width + block_width - 1) / block_width;
-	int num_rows = (height + block_height - 1) / block_height;
-	int num_blocks = num_cols * num_rows;
+	int group_blocks = unit_blocks(block_width);
+	int num_groups = (num_cols + group_blocks - 1) / group_blocks;
+	int num_units = parallel_num_units(width, height, block_width, block_height);
 
 	atomic_int next_block;
 	atomic_init(&next_block, 0);
 
+	// Box filters whose running sums the blocks would not amortize are applied from
+	// summed-area tables of the whole image
+	struct box_sums sums = {NULL, NULL, NULL, 0, 0};
+	if (box_sums_are_cheaper(&filter, block_width, block_height)) {
+		if (build_box_sums(&sums, source, width, height, &filter, num_threads) !=
+			0) {
+			free_image_rgb(&padded);
+			return -1;
+		}
+	}
+
+	struct work_deque deques[schedule == SCHEDULE_STEALING ? num_threads : 1];
+	chunk_size = schedule_chunk_size(schedule, chunk_size, num_units, num_threads);
+
+	if (schedule == SCHEDULE_STEALING &&
+		seed_deques(deques, num_threads,
+					(num_units + chunk_size - 1) / chunk_size) != 0) {
+		free_box_sums(&sums);
+		free_image_rgb(&padded);
+		return -1;
+	}
+
+	// The engine is chosen once for the shape of the blocks rather than per block
+	filter.engine = sums.red != NULL
+						? FILTER_ENGINE_BOX
+						: choose_engine(&filter, block_width, block_height);
+
 	for (int i = 0; i < num_threads; i++) {
-		thread_data_array[i].input_image = input_image;
+		thread_data_array[i].input_image = source;
 		thread_data_array[i].output_image = output_image;
 		thread_data_array[i].width = width;
 		thread_data_array[i].height = height;
@@ -24,42 +143,57 @@ int parallel_filter(struct image_rgb *input_image, struct image_rgb *output_imag
 		thread_data_array[i].block_width = block_width;
 		thread_data_array[i].block_height = block_height;
 		thread_data_array[i].num_cols = num_cols;
-		thread_data_array[i].num_blocks = num_blocks;
+		thread_data_array[i].group_blocks = group_blocks;
+		thread_data_array[i].num_groups = num_groups;
+		thread_data_array[i].num_units = num_units;
 		thread_data_array[i].next_block = &next_block;
-
-		if (pthread_create(&threads[i], NULL, process_dynamic,
-						   (void *)&thread_data_array[i]) != 0) {
-			error("Failed to create a thread\n");
-			for (int j = 0; j < i; j++) {
-				pthread_cancel(threads[j]);
-			}
-			return -1;
-		}
+		thread_data_array[i].schedule = schedule;
+		thread_data_array[i].deques = deques;
+		thread_data_array[i].num_threads = num_threads;
+		thread_data_array[i].index = i;
+		thread_data_array[i].chunk_size = chunk_size;
+		thread_data_array[i].seed = 2654435761u * (unsigned int)(i + 1);
+		thread_data_array[i].scratch = NULL;
+		thread_data_array[i].scratch_size = 0;
+		thread_data_array[i].output_x = 0;
+		thread_data_array[i].output_y = 0;
+		thread_data_array[i].staging = NULL;
+		thread_data_array[i].box_sums = sums.red != NULL ? &sums : NULL;
 	}
 
-	for (int i = 0; i < num_threads; i++) {
-		pthread_join(threads[i], NULL);
+	int status = thread_pool_run(process_dynamic, thread_data_array,
+								 sizeof(struct thread_data), num_threads);
+
+	if (schedule == SCHEDULE_STEALING) {
+		for (int i = 0; i < num_threads; i++) {
+			work_deque_free(&deques[i]);
+		}
 	}
+	free_box_sums(&sums);
+	free_image_rgb(&padded);
 
-	return 0;
+	return status;
 }
 
 int parallel_pixel(struct image_rgb *input_image, struct image_rgb *output_image,
 				   int width, int height, struct filter filter, int num_threads) {
 	return parallel_filter(input_image, output_image, width, height, filter,
-						   num_threads, 1, 1);
+						   num_threads, 1, 1, parallel_schedule,
+						   parallel_chunk_size);
 }
 
 int parallel_row(struct image_rgb *input_image, struct image_rgb *output_image,
 				 int width, int height, struct filter filter, int num_threads) {
 	return parallel_filter(input_image, output_image, width, height, filter,
-						   num_threads, width, 1);
+						   num_threads, width, 1, parallel_schedule,
+						   parallel_chunk_size);
 }
 
 int parallel_column(struct image_rgb *input_image, struct image_rgb *output_image,
 					int width, int height, struct filter filter, int num_threads) {
 	return parallel_filter(input_image, output_image, width, height, filter,
-						   num_threads, 1, height);
+						   num_threads, 1, height, parallel_schedule,
+						   parallel_chunk_size);
 }
 
 int parallel_block(struct image_rgb *input_image, struct image_rgb *output_image,
@@ -67,6 +201,134 @@ int parallel_block(struct image_rgb *input_image, struct image_rgb *output_image
 	int block_width = (width + num_threads - 1) / num_threads;
 	int block_height = (height + num_threads - 1) / num_threads;
 
+	return parallel_block_sized(input_image, output_image, width, height, filter,
+								num_threads, block_width, block_height);
+}
+
+int parallel_block_sized(struct image_rgb *input_image,
+						 struct image_rgb *output_image, int width, int height,
+						 struct filter filter, int num_threads, int block_width,
+						 int block_height) {
 	return parallel_filter(input_image, output_image, width, height, filter,
-						   num_threads, block_width, block_height);
+						   num_threads, block_width, block_height,
+						   parallel_schedule, parallel_chunk_size);
+}
+
+int parallel_tile(struct image_rgb *input_image, struct image_rgb *output_image,
+				  int width, int height, struct filter filter, int num_threads,
+				  int tile_width, int tile_height) {
+	if (filter.size > width || filter.size > height) {
+		return parallel_block(input_image, output_image, width, height, filter,
+							  num_threads);
+	}
+
+	int auto_width, auto_height;
+	chain_tile_size(&filter, 1, width, &auto_width, &auto_height);
+
+	return chain_application_tiled(
+		input_image, output_image, width, height, &filter, 1,
+		tile_width > 0 ? tile_width : auto_width,
+		tile_height > 0 ? tile_height : auto_height, num_threads);
+}
+
+// The passes over the channels of an image, one of which is selected by `kind`
+enum channels_kind { CHANNELS_SPLIT, CHANNELS_ASSEMBLE, CHANNELS_TOUCH };
+
+/**
+ * Represents the data passed to each thread splitting, assembling or touching the
+ * channels of an image.
+ *
+ * @param pixels Pointer to the interleaved pixels of the image.
+ * @param channel_image Pointer to the channels of the image.
+ * @param width Width of the image.
+ * @param first_row First row of the thread.
+ * @param rows Number of rows of the thread.
+ * @param kind The pass over the channels.
+ */
+struct channels_data {
+	unsigned char *pixels;
+	struct image_rgb *channel_image;
+	size_t width;
+	size_t first_row;
+	size_t rows;
+	enum channels_kind kind;
+};
+
+static void *process_channels(void *arg) {
+	struct channels_data *data = (struct channels_data *)arg;
+	struct image_rgb *image = data->channel_image;
+	size_t first = data->first_row * image->stride;
+
+	// Whole rows with their padding, so the pages of the padding are touched too
+	if (data->kind == CHANNELS_TOUCH) {
+		memset(image->red + first, 0, data->rows * image->stride);
+		memset(image->green + first, 0, data->rows * image->stride);
+		memset(image->blue + first, 0, data->rows * image->stride);
+		return NULL;
+	}
+
+	enum simd_level level = detect_simd_level();
+	deinterleave_fn deinterleave = get_deinterleave(level);
+	interleave_fn interleave = get_interleave(level);
+
+	for (size_t y = data->first_row; y < data->first_row + data->rows; y++) {
+		unsigned char *pixels = data->pixels + 3 * y * data->width;
+		size_t row = y * image->stride;
+
+		if (data->kind == CHANNELS_SPLIT) {
+			deinterleave(pixels, image->red + row, image->green + row,
+						 image->blue + row, data->width);
+		} else {
+			interleave(image->red + row, image->green + row, image->blue + row,
+					   pixels, data->width);
+		}
+	}
+
+	return NULL;
+}
+
+// Splits, assembles or touches the channels of an image with ranges of rows per
+// thread, the ranges of `SCHEDULE_STATIC` in row mode
+static int convert_channels(unsigned char *pixels, struct image_rgb *channel_image,
+							int width, int height, int num_threads,
+							enum channels_kind kind) {
+	num_threads = max(min(num_threads, height), 1);
+
+	struct channels_data data[num_threads];
+
+	for (int i = 0; i < num_threads; i++) {
+		size_t first_row = (size_t)height * i / num_threads;
+		size_t last_row = (size_t)height * (i + 1) / num_threads;
+
+		data[i] = (struct channels_data){
+			.pixels = pixels,
+			.channel_image = channel_image,
+			.width = width,
+			.first_row = first_row,
+			.rows = last_row - first_row,
+			.kind = kind,
+		};
+	}
+
+	return thread_pool_run(process_channels, data, sizeof(struct channels_data),
+						   num_threads);
+}
+
+int parallel_split(const unsigned char *image, struct image_rgb *channel_image,
+				   int width, int height, int num_threads) {
+	// The pixels are only read when splitting
+	return convert_channels((unsigned char *)image, channel_image, width, height,
+							num_threads, CHANNELS_SPLIT);
+}
+
+int parallel_assemble(unsigned char *image, struct image_rgb *channel_image,
+					  int width, int height, int num_threads) {
+	return convert_channels(image, channel_image, width, height, num_threads,
+							CHANNELS_ASSEMBLE);
+}
+
+int parallel_first_touch(struct image_rgb *channel_image, int width, int height,
+						 int num_threads) {
+	return convert_channels(NULL, channel_image, width, height, num_threads,
+							CHANNELS_TOUCH);
 }
@@ -1,5 +1,81 @@
 #include "filter_application.h"
 
+/**
+ * Applies a convolution filter to an image in parallel, split into blocks of
+ * `block_width` x `block_height` pixels. The blocks are grouped into work units
+ * (see `parallel_num_units()`) that the threads process as distributed by a
+ * scheduling policy (see `process_dynamic()`). The `parallel_*` modes call it with
+ * the policy set by `set_parallel_schedule()`.
+ *
+ * @param input_image Pointer to the input image (`struct image_rgb`).
+ * @param output_image Pointer to the output image (`struct image_rgb`).
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param filter The convolution filter to be applied.
+ * @param num_threads Number of threads to use for parallel processing.
+ * @param block_width Width of the blocks.
+ * @param block_height Height of the blocks.
+ * @param schedule Policy distributing the units among the threads.
+ * @param chunk_size Number of units of a chunk, `0` for the default of the policy
+ * (see `schedule_chunk_size()`).
+ *
+ * @return `0` on success, `-1` if thread creation or memory allocation fails.
+ */
+int parallel_filter(struct image_rgb *input_image, struct image_rgb *output_image,
+					int width, int height, struct filter filter, int num_threads,
+					int block_width, int block_height,
+					enum schedule_policy schedule, int chunk_size);
+
+/**
+ * Returns the number of work units of a chunk (see `enum schedule_policy`), at most
+ * the share of a thread. By default a chunk is a single unit, and
+ * `SCHEDULE_STEALING` seeds each deque with `STEALING_CHUNKS_PER_THREAD` chunks.
+ *
+ * @param schedule The scheduling policy.
+ * @param chunk_size The requested number of units, `0` for the default.
+ * @param num_units Number of units of the image (see `parallel_num_units()`).
+ * @param num_threads Number of threads.
+ */
+int schedule_chunk_size(enum schedule_policy schedule, int chunk_size,
+						int num_units, int num_threads);
+
+/**
+ * Returns the number of work units `parallel_filter()` splits an image into: its
+ * blocks, or, for blocks narrower than a cache line, groups of the adjacent blocks
+ * of a row of blocks that cover `CACHE_LINE_SIZE` columns (see
+ * `struct thread_data`).
+ *
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param block_width Width of the blocks.
+ * @param block_height Height of the blocks.
+ */
+int parallel_num_units(int width, int height, int block_width, int block_height);
+
+/**
+ * Sets whether `parallel_filter()` groups blocks narrower than a cache line into
+ * line-wide work units and stages their output (the default), or hands out single
+ * blocks, whose output lines are shared by several threads. Meant for benchmarks.
+ *
+ * @param enabled Whether the blocks are grouped.
+ */
+void set_line_units(bool enabled);
+
+/**
+ * Sets the scheduling policy of `parallel_pixel()`, `parallel_row()`,
+ * `parallel_column()` and `parallel_block()` (`SCHEDULE_DYNAMIC` with chunks of a
+ * single block by default).
+ *
+ * @param schedule The policy.
+ * @param chunk_size Number of units of a chunk, `0` for the default of the policy.
+ */
+void set_parallel_schedule(enum schedule_policy schedule, int chunk_size);
+
+/**
+ * Returns the scheduling policy set by `set_parallel_schedule()`.
+ */
+enum schedule_policy get_parallel_schedule(void);
+
 /**
  * Applies a convolution filter to an image in parallel by processing individual
  * pixels.
@@ -62,3 +138,97 @@ int parallel_column(struct image_rgb *input_image, struct image_rgb *output_imag
  */
 int parallel_block(struct image_rgb *input_image, struct image_rgb *output_image,
 				   int width, int height, struct filter filter, int num_threads);
+
+/**
+ * Applies a convolution filter to an image in parallel by processing blocks of a
+ * given size, like `parallel_block()` with blocks of its own.
+ *
+ * @param input_image Pointer to the input image (`struct image_rgb`).
+ * @param output_image Pointer to the output image (`struct image_rgb`).
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param filter The convolution filter to be applied.
+ * @param num_threads Number of threads to use for parallel processing.
+ * @param block_width Width of the blocks.
+ * @param block_height Height of the blocks.
+ *
+ * @return `0` on success, `-1` if thread creation fails.
+ */
+int parallel_block_sized(struct image_rgb *input_image,
+						 struct image_rgb *output_image, int width, int height,
+						 struct filter filter, int num_threads, int block_width,
+						 int block_height);
+
+/**
+ * Applies a convolution filter to an image in parallel by processing tiles sized to
+ * the L2 cache. For each tile a thread copies the input pixels the filter reads,
+ * i.e. the tile and its halo, into a contiguous buffer of its own, applies the
+ * filter to the buffer and copies the result to the output image (see
+ * `chain_application()`). Filters larger than the image are applied by
+ * `parallel_block()`, as their halo wraps around the image more than once.
+ *
+ * @param input_image Pointer to the input image (`struct image_rgb`).
+ * @param output_image Pointer to the output image (`struct image_rgb`).
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param filter The convolution filter to be applied.
+ * @param num_threads Number of threads to use for parallel processing.
+ * @param tile_width Width of the tiles, or `0` to size them with
+ * `chain_tile_size()`.
+ * @param tile_height Height of the tiles, or `0` to size them with
+ * `chain_tile_size()`.
+ *
+ * @return `0` on success, `-1` if thread creation or memory allocation fails.
+ */
+int parallel_tile(struct image_rgb *input_image, struct image_rgb *output_image,
+				  int width, int height, struct filter filter, int num_threads,
+				  int tile_width, int tile_height);
+
+/**
+ * Splits an interleaved (`RGBRGB...`) image into its channels, like
+ * `split_image_into_rgb_channels()`, with the vectorized kernel of
+ * `get_deinterleave()` on ranges of rows in parallel.
+ *
+ * @param image Pointer to the interleaved pixels of the image.
+ * @param channel_image Pointer to the channels receiving the image.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param num_threads Number of threads to use for parallel processing.
+ *
+ * @return `0` on success, `-1` if thread creation fails.
+ */
+int parallel_split(const unsigned char *image, struct image_rgb *channel_image,
+				   int width, int height, int num_threads);
+
+/**
+ * Combines the channels of an image into interleaved (`RGBRGB...`) pixels, like
+ * `assemble_image_from_rgb_channels()`, with the vectorized kernel of
+ * `get_interleave()` on ranges of rows in parallel.
+ *
+ * @param image Pointer receiving the interleaved pixels of the image.
+ * @param channel_image Pointer to the channels of the image.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param num_threads Number of threads to use for parallel processing.
+ *
+ * @return `0` on success, `-1` if thread creation fails.
+ */
+int parallel_assemble(unsigned char *image, struct image_rgb *channel_image,
+					  int width, int height, int num_threads);
+
+/**
+ * Zeroes the channels of a freshly allocated image on ranges of rows in parallel,
+ * the same ranges as `parallel_split()` and the `SCHEDULE_STATIC` partition of row
+ * mode. The memory pages of each range are thus first touched, and placed on the
+ * NUMA node of, the thread that processes them when the threads are pinned (see
+ * `thread_pool_set_affinity()`).
+ *
+ * @param channel_image Pointer to the channels of the image.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param num_threads Number of threads to use for parallel processing.
+ *
+ * @return `0` on success, `-1` if thread creation fails.
+ */
+int parallel_first_touch(struct image_rgb *channel_image, int width, int height,
+						 int num_threads);
@@ -0,0 +1,115 @@
+#include "separable.h"
+
+// Convolves the columns `[begin, end)` of one image row with `filter.row`, wrapping
+// the taps that fall outside the image around to the opposite side.
+static void border_span(const struct thread_data *data, const unsigned char *line,
+						double *out, size_t begin, size_t end) {
+	const struct filter *filter = &data->filter;
+
+	for (size_t x = begin; x < end; x++) {
+		double sum = 0.0;
+
+		for (int filterX = 0; filterX < filter->size; filterX++) {
+			size_t imageX = wrap_position(
+				(ptrdiff_t)x - filter->size / 2 + filterX, data->width);
+			sum += line[imageX] * filter->row[filterX];
+		}
+
+		out[x - begin] = sum;
+	}
+}
+
+// Convolves `rows` image rows starting at `first_row` (see `tap_position()`) with
+// `filter.row`, producing columns `[start_x, end_x)` of each. Only the columns whose
+// taps cross the left or right border are wrapped per tap.
+static void horizontal_pass(const struct thread_data *data,
+							const unsigned char *channel, double *buffer,
+							ptrdiff_t first_row, size_t rows, size_t start_x,
+							size_t end_x) {
+	const struct filter *filter = &data->filter;
+	size_t block_width = end_x - start_x;
+
+	size_t begin, end;
+	tap_bounds(data, data->width, &begin, &end);
+	begin = min(max(start_x, begin), end_x);
+	end = max(min(end_x, end), begin);
+
+	for (size_t i = 0; i < rows; i++) {
+		ptrdiff_t imageY =
+			tap_position(data, first_row + (ptrdiff_t)i, data->height);
+		const unsigned char *line = channel + input_index(data, 0, imageY);
+		double *out = buffer + i * block_width;
+
+		border_span(data, line, out, start_x, begin);
+
+		for (size_t x = begin; x < end; x++) {
+			const unsigned char *taps = line + x - filter->size / 2;
+			double sum = 0.0;
+
+			for (int filterX = 0; filterX < filter->size; filterX++) {
+				sum += taps[filterX] * filter->row[filterX];
+			}
+
+			out[x - start_x] = sum;
+		}
+
+		border_span(data, line, out + (end - start_x), end, end_x);
+	}
+}
+
+// Convolves the columns of the horizontal pass with `filter.column` and writes the
+// rows `[start_y, end_y)` of the output channel.
+static void vertical_pass(const struct thread_data *data, const double *buffer,
+						  unsigned char *channel, size_t start_x, size_t start_y,
+						  size_t end_x, size_t end_y) {
+	const struct filter *filter = &data->filter;
+	size_t block_width = end_x - start_x;
+
+	for (size_t y = start_y; y < end_y; y++) {
+		const double *rows = buffer + (y - start_y) * block_width;
+		unsigned char *out = channel + output_index(data, start_x, y);
+
+		for (size_t x = 0; x < block_width; x++) {
+			double sum = 0.0;
+
+			for (int filterY = 0; filterY < filter->size; filterY++) {
+				sum += rows[filterY * block_width + x] * filter->column[filterY];
+			}
+
+			out[x] =
+				min(max((int)(filter->factor * sum + filter->bias), 0), 255);
+		}
+	}
+}
+
+bool separable_block(struct thread_data *data, size_t start_x, size_t start_y,
+					 size_t end_x, size_t end_y) {
+	int size = data->filter.size;
+	size_t block_width = end_x - start_x;
+	size_t strip_height = min(end_y - start_y, (size_t)SEPARABLE_STRIP_HEIGHT);
+
+	double *buffer = reserve_scratch(data, (strip_height + size - 1) * block_width);
+	if (buffer == NULL) {
+		return false;
+	}
+
+	unsigned char *inputs[] = {data->input_image->red, data->input_image->green,
+							   data->input_image->blue};
+	unsigned char *outputs[] = {data->output_image->red, data->output_image->green,
+								data->output_image->blue};
+
+	for (size_t strip_y = start_y; strip_y < end_y; strip_y += strip_height) {
+		size_t strip_end = min(strip_y + strip_height, end_y);
+		ptrdiff_t first_row = (ptrdiff_t)strip_y - size / 2;
+		size_t rows = strip_end - strip_y + size - 1;
+
+		for (int c = 0; c < 3; c++) {
+			horizontal_pass(data, inputs[c], buffer, first_row, rows, start_x,
+							end_x);
+			vertical_pass(data, buffer, outputs[c], start_x, strip_y, end_x,
+						  strip_end);
+		}
+	}
+
+	return true;
+}
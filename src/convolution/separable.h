@@ -0,0 +1,24 @@
+#pragma once
+
+#include "filter_application.h"
+
+#define SEPARABLE_STRIP_HEIGHT 32 // Output rows produced per horizontal pass
+
+/**
+ * Applies a separable filter to the output region `[start_x, end_x) x [start_y,
+ * end_y)` in two 1D passes: the rows of each strip (plus the kernel halo) are first
+ * convolved with `filter.row` into the thread's scratch buffer, then the columns of
+ * that buffer are convolved with `filter.column`. This takes `2 * size` instead of
+ * `size * size` multiplications per pixel.
+ *
+ * @param data Pointer to the `struct thread_data` describing the images and filter.
+ * @param start_x First column of the region.
+ * @param start_y First row of the region.
+ * @param end_x Column after the last one of the region.
+ * @param end_y Row after the last one of the region.
+ *
+ * @return `true` on success, `false` if the scratch buffer could not be allocated
+ * (nothing is written in that case).
+ */
+bool separable_block(struct thread_data *data, size_t start_x, size_t start_y,
+					 size_t end_x, size_t end_y);
@@ -0,0 +1,42 @@
+#include "shift.h"
+
+void shift_block(struct thread_data *data, size_t start_x, size_t start_y,
+				 size_t end_x, size_t end_y) {
+	const struct filter *filter = &data->filter;
+	const struct filter_tap *tap = &filter->taps[0];
+	size_t width = data->width;
+	ptrdiff_t row_end = (ptrdiff_t)width + input_halo(data);
+
+	const unsigned char *inputs[] = {data->input_image->red,
+									 data->input_image->green,
+									 data->input_image->blue};
+	unsigned char *outputs[] = {data->output_image->red, data->output_image->green,
+								data->output_image->blue};
+
+	for (size_t y = start_y; y < end_y; y++) {
+		ptrdiff_t row = tap_position(data, (ptrdiff_t)y + tap->dy, data->height);
+
+		for (int c = 0; c < 3; c++) {
+			const unsigned char *input = inputs[c] + input_index(data, 0, row);
+			unsigned char *output = outputs[c] + output_index(data, start_x, y);
+
+			// Each run ends at the end of the output region or of the input row,
+			// with its halo
+			for (size_t x = start_x; x < end_x;) {
+				ptrdiff_t column = tap_position(data, (ptrdiff_t)x + tap->dx, width);
+				size_t count = min(end_x - x, (size_t)(row_end - column));
+
+				if (filter->shift_copy) {
+					memcpy(output + (x - start_x), input + column, count);
+				} else {
+					for (size_t i = 0; i < count; i++) {
+						output[x - start_x + i] =
+							filter->shift_table[input[column + i]];
+					}
+				}
+
+				x += count;
+			}
+		}
+	}
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "filter_application.h"
+
+/**
+ * Applies a shift filter (`filter.shift`) to the output region
+ * `[start_x, end_x) x [start_y, end_y)`: each output pixel is the input pixel at the
+ * offset of the single tap looked up in `filter.shift_table`, which gives exactly
+ * the result of the direct application. Rows are split where the shifted input
+ * wraps around the image border, and if the table maps each value to itself
+ * (`filter.shift_copy`, e.g. `id`) the runs are copied with `memcpy()`.
+ *
+ * @param data Pointer to the `struct thread_data` describing the images and filter.
+ * @param start_x First column of the region.
+ * @param start_y First row of the region.
+ * @param end_x Column after the last one of the region.
+ * @param end_y Row after the last one of the region.
+ */
+void shift_block(struct thread_data *data, size_t start_x, size_t start_y,
+				 size_t end_x, size_t end_y);
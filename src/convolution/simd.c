@@ -0,0 +1,604 @@
+#include "simd.h"
+#include "fixed_point.h"
+
+#include <pthread.h>
+#include <stddef.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86
+#include <immintrin.h>
+#endif
+
+static void fixed_point_row_scalar(const unsigned char *input, size_t stride,
+								   unsigned char *output, size_t count,
+								   const struct filter *filter) {
+	for (size_t x = 0; x < count; x++) {
+		int32_t sum = 0;
+
+		for (int i = 0; i < filter->num_taps; i++) {
+			const struct filter_tap *tap = &filter->taps[i];
+			ptrdiff_t offset = tap->dy * (ptrdiff_t)stride + tap->dx;
+			sum += input[offset + x] * tap->fixed_weight;
+		}
+
+		output[x] = fixed_point_scale(filter, sum);
+	}
+}
+
+static void line_row_scalar(const unsigned char *const *lines,
+							const int32_t *weights, int num_taps,
+							const int32_t *previous, int32_t *sums,
+							unsigned char *output, size_t count,
+							const struct filter *filter) {
+	for (size_t x = 0; x < count; x++) {
+		int32_t sum = previous[x];
+
+		for (int i = 0; i < num_taps; i++) {
+			sum += weights[i] * lines[i][x];
+		}
+
+		sums[x] = sum;
+		output[x] = fixed_point_scale(filter, sum);
+	}
+}
+
+static void deinterleave_scalar(const unsigned char *pixels, unsigned char *red,
+								unsigned char *green, unsigned char *blue,
+								size_t count) {
+	for (size_t x = 0; x < count; x++) {
+		red[x] = pixels[3 * x];
+		green[x] = pixels[3 * x + 1];
+		blue[x] = pixels[3 * x + 2];
+	}
+}
+
+static void interleave_scalar(const unsigned char *red, const unsigned char *green,
+							  const unsigned char *blue, unsigned char *pixels,
+							  size_t count) {
+	for (size_t x = 0; x < count; x++) {
+		pixels[3 * x] = red[x];
+		pixels[3 * x + 1] = green[x];
+		pixels[3 * x + 2] = blue[x];
+	}
+}
+
+#ifdef SIMD_X86
+
+// The vector kernels widen 16 input pixels at a time to `int32_t` lanes, multiply
+// them by the broadcast weight of each tap and accumulate, exactly like the scalar
+// code. The last vector of a row ends at its last pixel, overlapping the previous
+// one and writing the same values again (the output never aliases the input), so
+// only rows shorter than a vector are left to the scalar kernel.
+
+__attribute__((target("sse4.1"))) static __m128i
+scale_sse41(const struct filter *filter, __m128i sum) {
+	__m128i value =
+		_mm_add_epi32(_mm_mullo_epi32(sum, _mm_set1_epi32(filter->fixed_multiplier)),
+					  _mm_set1_epi32(filter->fixed_offset));
+	return _mm_sra_epi32(value, _mm_cvtsi32_si128(filter->fixed_shift));
+}
+
+__attribute__((target("sse4.1"))) static void
+fixed_point_row_sse41(const unsigned char *input, size_t stride,
+					  unsigned char *output, size_t count,
+					  const struct filter *filter) {
+	if (count < 16) {
+		fixed_point_row_scalar(input, stride, output, count, filter);
+		return;
+	}
+
+	for (size_t x = 0; x < count; x += 16) {
+		x = min(x, count - 16);
+
+		__m128i sums[4] = {_mm_setzero_si128(), _mm_setzero_si128(),
+						   _mm_setzero_si128(), _mm_setzero_si128()};
+
+		for (int t = 0; t < filter->num_taps; t++) {
+			const struct filter_tap *tap = &filter->taps[t];
+			const unsigned char *pixel =
+				input + tap->dy * (ptrdiff_t)stride + tap->dx + x;
+
+			__m128i weight = _mm_set1_epi32(tap->fixed_weight);
+			__m128i pixels = _mm_loadu_si128((const __m128i *)pixel);
+
+			for (int i = 0; i < 4; i++) {
+				__m128i wide = _mm_cvtepu8_epi32(pixels);
+				sums[i] = _mm_add_epi32(sums[i], _mm_mullo_epi32(wide, weight));
+				pixels = _mm_srli_si128(pixels, 4);
+			}
+		}
+
+		__m128i low = _mm_packs_epi32(scale_sse41(filter, sums[0]),
+									  scale_sse41(filter, sums[1]));
+		__m128i high = _mm_packs_epi32(scale_sse41(filter, sums[2]),
+									   scale_sse41(filter, sums[3]));
+		_mm_storeu_si128((__m128i *)(output + x), _mm_packus_epi16(low, high));
+	}
+}
+
+__attribute__((target("avx2"))) static __m256i
+scale_avx2(const struct filter *filter, __m256i sum) {
+	__m256i value = _mm256_add_epi32(
+		_mm256_mullo_epi32(sum, _mm256_set1_epi32(filter->fixed_multiplier)),
+		_mm256_set1_epi32(filter->fixed_offset));
+	return _mm256_sra_epi32(value, _mm_cvtsi32_si128(filter->fixed_shift));
+}
+
+__attribute__((target("avx2"))) static void
+fixed_point_row_avx2(const unsigned char *input, size_t stride,
+					 unsigned char *output, size_t count,
+					 const struct filter *filter) {
+	if (count < 16) {
+		fixed_point_row_scalar(input, stride, output, count, filter);
+		return;
+	}
+
+	for (size_t x = 0; x < count; x += 16) {
+		x = min(x, count - 16);
+
+		__m256i low = _mm256_setzero_si256();
+		__m256i high = _mm256_setzero_si256();
+
+		for (int t = 0; t < filter->num_taps; t++) {
+			const struct filter_tap *tap = &filter->taps[t];
+			const unsigned char *pixel =
+				input + tap->dy * (ptrdiff_t)stride + tap->dx + x;
+
+			__m256i weight = _mm256_set1_epi32(tap->fixed_weight);
+			__m128i pixels = _mm_loadu_si128((const __m128i *)pixel);
+
+			low = _mm256_add_epi32(
+				low, _mm256_mullo_epi32(_mm256_cvtepu8_epi32(pixels), weight));
+			high = _mm256_add_epi32(
+				high, _mm256_mullo_epi32(
+						  _mm256_cvtepu8_epi32(_mm_srli_si128(pixels, 8)), weight));
+		}
+
+		// `packs` works within 128-bit lanes, so the 16-bit values are reordered
+		// before and the two 8-byte halves picked after the final pack.
+		__m256i words =
+			_mm256_packs_epi32(scale_avx2(filter, low), scale_avx2(filter, high));
+		words = _mm256_permute4x64_epi64(words, 0xD8);
+		__m256i bytes = _mm256_packus_epi16(words, words);
+		bytes = _mm256_permute4x64_epi64(bytes, 0x08);
+		_mm_storeu_si128((__m128i *)(output + x), _mm256_castsi256_si128(bytes));
+	}
+}
+
+__attribute__((target("avx512f"))) static void
+fixed_point_row_avx512(const unsigned char *input, size_t stride,
+					   unsigned char *output, size_t count,
+					   const struct filter *filter) {
+	const __m512i multiplier = _mm512_set1_epi32(filter->fixed_multiplier);
+	const __m512i offset = _mm512_set1_epi32(filter->fixed_offset);
+	const __m128i shift = _mm_cvtsi32_si128(filter->fixed_shift);
+
+	if (count < 32) {
+		fixed_point_row_scalar(input, stride, output, count, filter);
+		return;
+	}
+
+	for (size_t x = 0; x < count; x += 32) {
+		x = min(x, count - 32);
+
+		__m512i low = _mm512_setzero_si512();
+		__m512i high = _mm512_setzero_si512();
+
+		for (int t = 0; t < filter->num_taps; t++) {
+			const struct filter_tap *tap = &filter->taps[t];
+			const unsigned char *pixel =
+				input + tap->dy * (ptrdiff_t)stride + tap->dx + x;
+
+			__m512i weight = _mm512_set1_epi32(tap->fixed_weight);
+			__m128i first = _mm_loadu_si128((const __m128i *)pixel);
+			__m128i second = _mm_loadu_si128((const __m128i *)(pixel + 16));
+
+			low = _mm512_add_epi32(
+				low, _mm512_mullo_epi32(_mm512_cvtepu8_epi32(first), weight));
+			high = _mm512_add_epi32(
+				high, _mm512_mullo_epi32(_mm512_cvtepu8_epi32(second), weight));
+		}
+
+		__m512i sums[2] = {low, high};
+		for (int i = 0; i < 2; i++) {
+			__m512i value = _mm512_sra_epi32(
+				_mm512_add_epi32(_mm512_mullo_epi32(sums[i], multiplier), offset),
+				shift);
+			value = _mm512_max_epi32(value, _mm512_setzero_si512());
+			_mm_storeu_si128((__m128i *)(output + x + i * 16),
+							 _mm512_cvtusepi32_epi8(value));
+		}
+	}
+}
+
+// Advances the pointers of `line_row_scalar()` past the pixels done by a vector
+// kernel and lets it compute the remaining ones.
+static void line_row_rest(const unsigned char *const *lines, const int32_t *weights,
+						  int num_taps, const int32_t *previous, int32_t *sums,
+						  unsigned char *output, size_t count, size_t done,
+						  const struct filter *filter) {
+	const unsigned char *rest[num_taps];
+
+	for (int i = 0; i < num_taps; i++) {
+		rest[i] = lines[i] + done;
+	}
+
+	line_row_scalar(rest, weights, num_taps, previous + done, sums + done,
+					output + done, count - done, filter);
+}
+
+// The line kernels load 16 sums of the predecessors and add the widened input
+// pixels under each tap of the slide to them.
+
+__attribute__((target("sse4.1"))) static void
+line_row_sse41(const unsigned char *const *lines, const int32_t *weights,
+			   int num_taps, const int32_t *previous, int32_t *sums,
+			   unsigned char *output, size_t count, const struct filter *filter) {
+	size_t x = 0;
+
+	for (; x + 16 <= count; x += 16) {
+		__m128i values[4];
+		for (int i = 0; i < 4; i++) {
+			values[i] = _mm_loadu_si128((const __m128i *)(previous + x + 4 * i));
+		}
+
+		for (int t = 0; t < num_taps; t++) {
+			__m128i weight = _mm_set1_epi32(weights[t]);
+			__m128i pixels = _mm_loadu_si128((const __m128i *)(lines[t] + x));
+
+			for (int i = 0; i < 4; i++) {
+				__m128i wide = _mm_cvtepu8_epi32(pixels);
+				values[i] = _mm_add_epi32(values[i], _mm_mullo_epi32(wide, weight));
+				pixels = _mm_srli_si128(pixels, 4);
+			}
+		}
+
+		for (int i = 0; i < 4; i++) {
+			_mm_storeu_si128((__m128i *)(sums + x + 4 * i), values[i]);
+		}
+
+		__m128i low = _mm_packs_epi32(scale_sse41(filter, values[0]),
+									  scale_sse41(filter, values[1]));
+		__m128i high = _mm_packs_epi32(scale_sse41(filter, values[2]),
+									   scale_sse41(filter, values[3]));
+		_mm_storeu_si128((__m128i *)(output + x), _mm_packus_epi16(low, high));
+	}
+
+	line_row_rest(lines, weights, num_taps, previous, sums, output, count, x,
+				  filter);
+}
+
+__attribute__((target("avx2"))) static void
+line_row_avx2(const unsigned char *const *lines, const int32_t *weights,
+			  int num_taps, const int32_t *previous, int32_t *sums,
+			  unsigned char *output, size_t count, const struct filter *filter) {
+	size_t x = 0;
+
+	for (; x + 16 <= count; x += 16) {
+		__m256i low = _mm256_loadu_si256((const __m256i *)(previous + x));
+		__m256i high = _mm256_loadu_si256((const __m256i *)(previous + x + 8));
+
+		for (int t = 0; t < num_taps; t++) {
+			__m256i weight = _mm256_set1_epi32(weights[t]);
+			__m128i pixels = _mm_loadu_si128((const __m128i *)(lines[t] + x));
+
+			low = _mm256_add_epi32(
+				low, _mm256_mullo_epi32(_mm256_cvtepu8_epi32(pixels), weight));
+			high = _mm256_add_epi32(
+				high, _mm256_mullo_epi32(
+						  _mm256_cvtepu8_epi32(_mm_srli_si128(pixels, 8)), weight));
+		}
+
+		_mm256_storeu_si256((__m256i *)(sums + x), low);
+		_mm256_storeu_si256((__m256i *)(sums + x + 8), high);
+
+		__m256i words =
+			_mm256_packs_epi32(scale_avx2(filter, low), scale_avx2(filter, high));
+		words = _mm256_permute4x64_epi64(words, 0xD8);
+		__m256i bytes = _mm256_packus_epi16(words, words);
+		bytes = _mm256_permute4x64_epi64(bytes, 0x08);
+		_mm_storeu_si128((__m128i *)(output + x), _mm256_castsi256_si128(bytes));
+	}
+
+	line_row_rest(lines, weights, num_taps, previous, sums, output, count, x,
+				  filter);
+}
+
+__attribute__((target("avx512f"))) static void
+line_row_avx512(const unsigned char *const *lines, const int32_t *weights,
+				int num_taps, const int32_t *previous, int32_t *sums,
+				unsigned char *output, size_t count, const struct filter *filter) {
+	const __m512i multiplier = _mm512_set1_epi32(filter->fixed_multiplier);
+	const __m512i offset = _mm512_set1_epi32(filter->fixed_offset);
+	const __m128i shift = _mm_cvtsi32_si128(filter->fixed_shift);
+	size_t x = 0;
+
+	for (; x + 16 <= count; x += 16) {
+		__m512i value = _mm512_loadu_si512((const void *)(previous + x));
+
+		for (int t = 0; t < num_taps; t++) {
+			__m512i weight = _mm512_set1_epi32(weights[t]);
+			__m128i pixels = _mm_loadu_si128((const __m128i *)(lines[t] + x));
+
+			value = _mm512_add_epi32(
+				value, _mm512_mullo_epi32(_mm512_cvtepu8_epi32(pixels), weight));
+		}
+
+		_mm512_storeu_si512((void *)(sums + x), value);
+
+		value = _mm512_sra_epi32(
+			_mm512_add_epi32(_mm512_mullo_epi32(value, multiplier), offset), shift);
+		value = _mm512_max_epi32(value, _mm512_setzero_si512());
+		_mm_storeu_si128((__m128i *)(output + x), _mm512_cvtusepi32_epi8(value));
+	}
+
+	line_row_rest(lines, weights, num_taps, previous, sums, output, count, x,
+				  filter);
+}
+
+// The channel kernels shuffle 16 interleaved pixels, three 16-byte vectors, at a
+// time with `pshufb`: each channel is gathered from the three vectors with masks
+// selecting its bytes and or-ed together (`-1` zeroes a byte), and each vector is
+// scattered from the three channels the same way. The AVX2 kernels shuffle two
+// groups of 16 pixels, one per 128-bit lane.
+
+static const int8_t gather_masks[3][3][16] = {
+	{{0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+	 {-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1},
+	 {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13}},
+	{{1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+	 {-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1},
+	 {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14}},
+	{{2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+	 {-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1},
+	 {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15}},
+};
+
+static const int8_t scatter_masks[3][3][16] = {
+	{{0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1, 5},
+	 {-1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1, -1},
+	 {-1, -1, 0, -1, -1, 1, -1, -1, 2, -1, -1, 3, -1, -1, 4, -1}},
+	{{-1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10, -1},
+	 {5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1, 10},
+	 {-1, 5, -1, -1, 6, -1, -1, 7, -1, -1, 8, -1, -1, 9, -1, -1}},
+	{{-1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1, -1},
+	 {-1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15, -1},
+	 {10, -1, -1, 11, -1, -1, 12, -1, -1, 13, -1, -1, 14, -1, -1, 15}},
+};
+
+__attribute__((target("sse4.1"))) static void
+deinterleave_sse41(const unsigned char *pixels, unsigned char *red,
+				   unsigned char *green, unsigned char *blue, size_t count) {
+	unsigned char *channels[] = {red, green, blue};
+	__m128i masks[3][3];
+	size_t x = 0;
+
+	for (int c = 0; c < 3; c++) {
+		for (int v = 0; v < 3; v++) {
+			masks[c][v] = _mm_loadu_si128((const __m128i *)gather_masks[c][v]);
+		}
+	}
+
+	for (; x + 16 <= count; x += 16) {
+		__m128i vectors[3];
+		for (int v = 0; v < 3; v++) {
+			vectors[v] = _mm_loadu_si128((const __m128i *)(pixels + 3 * x + 16 * v));
+		}
+
+		for (int c = 0; c < 3; c++) {
+			__m128i channel = _mm_or_si128(
+				_mm_or_si128(_mm_shuffle_epi8(vectors[0], masks[c][0]),
+							 _mm_shuffle_epi8(vectors[1], masks[c][1])),
+				_mm_shuffle_epi8(vectors[2], masks[c][2]));
+			_mm_storeu_si128((__m128i *)(channels[c] + x), channel);
+		}
+	}
+
+	deinterleave_scalar(pixels + 3 * x, red + x, green + x, blue + x, count - x);
+}
+
+__attribute__((target("sse4.1"))) static void
+interleave_sse41(const unsigned char *red, const unsigned char *green,
+				 const unsigned char *blue, unsigned char *pixels, size_t count) {
+	const unsigned char *channels[] = {red, green, blue};
+	__m128i masks[3][3];
+	size_t x = 0;
+
+	for (int v = 0; v < 3; v++) {
+		for (int c = 0; c < 3; c++) {
+			masks[v][c] = _mm_loadu_si128((const __m128i *)scatter_masks[v][c]);
+		}
+	}
+
+	for (; x + 16 <= count; x += 16) {
+		__m128i values[3];
+		for (int c = 0; c < 3; c++) {
+			values[c] = _mm_loadu_si128((const __m128i *)(channels[c] + x));
+		}
+
+		for (int v = 0; v < 3; v++) {
+			__m128i vector = _mm_or_si128(
+				_mm_or_si128(_mm_shuffle_epi8(values[0], masks[v][0]),
+							 _mm_shuffle_epi8(values[1], masks[v][1])),
+				_mm_shuffle_epi8(values[2], masks[v][2]));
+			_mm_storeu_si128((__m128i *)(pixels + 3 * x + 16 * v), vector);
+		}
+	}
+
+	interleave_scalar(red + x, green + x, blue + x, pixels + 3 * x, count - x);
+}
+
+// Loads two 16-byte vectors into the lanes of a 256-bit one
+__attribute__((target("avx2"))) static __m256i
+load_lanes(const unsigned char *low, const unsigned char *high) {
+	return _mm256_inserti128_si256(
+		_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)low)),
+		_mm_loadu_si128((const __m128i *)high), 1);
+}
+
+__attribute__((target("avx2"))) static void
+store_lanes(unsigned char *low, unsigned char *high, __m256i vector) {
+	_mm_storeu_si128((__m128i *)low, _mm256_castsi256_si128(vector));
+	_mm_storeu_si128((__m128i *)high, _mm256_extracti128_si256(vector, 1));
+}
+
+__attribute__((target("avx2"))) static void
+deinterleave_avx2(const unsigned char *pixels, unsigned char *red,
+				  unsigned char *green, unsigned char *blue, size_t count) {
+	unsigned char *channels[] = {red, green, blue};
+	__m256i masks[3][3];
+	size_t x = 0;
+
+	for (int c = 0; c < 3; c++) {
+		for (int v = 0; v < 3; v++) {
+			masks[c][v] = _mm256_broadcastsi128_si256(
+				_mm_loadu_si128((const __m128i *)gather_masks[c][v]));
+		}
+	}
+
+	for (; x + 32 <= count; x += 32) {
+		const unsigned char *group = pixels + 3 * x;
+		__m256i vectors[3];
+		for (int v = 0; v < 3; v++) {
+			vectors[v] = load_lanes(group + 16 * v, group + 48 + 16 * v);
+		}
+
+		for (int c = 0; c < 3; c++) {
+			__m256i channel = _mm256_or_si256(
+				_mm256_or_si256(_mm256_shuffle_epi8(vectors[0], masks[c][0]),
+								_mm256_shuffle_epi8(vectors[1], masks[c][1])),
+				_mm256_shuffle_epi8(vectors[2], masks[c][2]));
+			_mm256_storeu_si256((__m256i *)(channels[c] + x), channel);
+		}
+	}
+
+	deinterleave_sse41(pixels + 3 * x, red + x, green + x, blue + x, count - x);
+}
+
+__attribute__((target("avx2"))) static void
+interleave_avx2(const unsigned char *red, const unsigned char *green,
+				const unsigned char *blue, unsigned char *pixels, size_t count) {
+	const unsigned char *channels[] = {red, green, blue};
+	__m256i masks[3][3];
+	size_t x = 0;
+
+	for (int v = 0; v < 3; v++) {
+		for (int c = 0; c < 3; c++) {
+			masks[v][c] = _mm256_broadcastsi128_si256(
+				_mm_loadu_si128((const __m128i *)scatter_masks[v][c]));
+		}
+	}
+
+	for (; x + 32 <= count; x += 32) {
+		unsigned char *group = pixels + 3 * x;
+		__m256i values[3];
+		for (int c = 0; c < 3; c++) {
+			values[c] = _mm256_loadu_si256((const __m256i *)(channels[c] + x));
+		}
+
+		for (int v = 0; v < 3; v++) {
+			__m256i vector = _mm256_or_si256(
+				_mm256_or_si256(_mm256_shuffle_epi8(values[0], masks[v][0]),
+								_mm256_shuffle_epi8(values[1], masks[v][1])),
+				_mm256_shuffle_epi8(values[2], masks[v][2]));
+			store_lanes(group + 16 * v, group + 48 + 16 * v, vector);
+		}
+	}
+
+	interleave_sse41(red + x, green + x, blue + x, pixels + 3 * x, count - x);
+}
+
+#endif
+
+static enum simd_level detected_level = SIMD_NONE;
+static pthread_once_t detect_once = PTHREAD_ONCE_INIT;
+
+static void detect_simd_level_once(void) {
+#ifdef SIMD_X86
+	__builtin_cpu_init();
+
+	if (__builtin_cpu_supports("avx512f")) {
+		detected_level = SIMD_AVX512;
+	} else if (__builtin_cpu_supports("avx2")) {
+		detected_level = SIMD_AVX2;
+	} else if (__builtin_cpu_supports("sse4.1")) {
+		detected_level = SIMD_SSE41;
+	}
+#endif
+}
+
+enum simd_level detect_simd_level(void) {
+	pthread_once(&detect_once, detect_simd_level_once);
+	return detected_level;
+}
+
+const char *simd_level_name(enum simd_level level) {
+	switch (level) {
+		case SIMD_SSE41:
+			return "sse4.1";
+		case SIMD_AVX2:
+			return "avx2";
+		case SIMD_AVX512:
+			return "avx512";
+		default:
+			return "scalar";
+	}
+}
+
+fixed_point_row_fn get_fixed_point_row(enum simd_level level) {
+	switch (level) {
+#ifdef SIMD_X86
+		case SIMD_SSE41:
+			return fixed_point_row_sse41;
+		case SIMD_AVX2:
+			return fixed_point_row_avx2;
+		case SIMD_AVX512:
+			return fixed_point_row_avx512;
+#endif
+		default:
+			return fixed_point_row_scalar;
+	}
+}
+
+line_row_fn get_line_row(enum simd_level level) {
+	switch (level) {
+#ifdef SIMD_X86
+		case SIMD_SSE41:
+			return line_row_sse41;
+		case SIMD_AVX2:
+			return line_row_avx2;
+		case SIMD_AVX512:
+			return line_row_avx512;
+#endif
+		default:
+			return line_row_scalar;
+	}
+}
+
+deinterleave_fn get_deinterleave(enum simd_level level) {
+	switch (level) {
+#ifdef SIMD_X86
+		case SIMD_SSE41:
+			return deinterleave_sse41;
+		case SIMD_AVX2:
+		case SIMD_AVX512:
+			return deinterleave_avx2;
+#endif
+		default:
+			return deinterleave_scalar;
+	}
+}
+
+interleave_fn get_interleave(enum simd_level level) {
+	switch (level) {
+#ifdef SIMD_X86
+		case SIMD_SSE41:
+			return interleave_sse41;
+		case SIMD_AVX2:
+		case SIMD_AVX512:
+			return interleave_avx2;
+#endif
+		default:
+			return interleave_scalar;
+	}
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "../filters/filter.h"
+
+/**
+ * Instruction set extensions the vectorized kernels are available for, from the
+ * least to the most capable.
+ */
+enum simd_level { SIMD_NONE, SIMD_SSE41, SIMD_AVX2, SIMD_AVX512 };
+
+/**
+ * Computes `count` consecutive output pixels of one channel of a fixed-point
+ * filter. All of them must be interior pixels, i.e. their whole neighbourhood lies
+ * inside the image.
+ *
+ * @param input Pointer to the input pixel at the position of the first output pixel.
+ * @param stride Distance between two rows of `input`.
+ * @param output Pointer to the first output pixel.
+ * @param count Number of output pixels.
+ * @param filter The fixed-point filter to be applied.
+ */
+typedef void (*fixed_point_row_fn)(const unsigned char *input, size_t stride,
+								   unsigned char *output, size_t count,
+								   const struct filter *filter);
+
+/**
+ * Detects (once, via `cpuid`) the most capable instruction set supported by both the
+ * CPU and the OS.
+ *
+ * @return The detected `enum simd_level`.
+ */
+enum simd_level detect_simd_level(void);
+
+/**
+ * Returns a printable name of the instruction set (e.g. "avx2").
+ *
+ * @param level The instruction set.
+ */
+const char *simd_level_name(enum simd_level level);
+
+/**
+ * Returns the row kernel for fixed-point filters written for the given instruction
+ * set. `SIMD_NONE` gives the scalar reference implementation; the vectorized kernels
+ * produce bit-exact the same output.
+ *
+ * @param level The instruction set, which must not exceed `detect_simd_level()`.
+ */
+fixed_point_row_fn get_fixed_point_row(enum simd_level level);
+
+/**
+ * Continues the running sums of `count` consecutive pixels of one channel of a line
+ * filter (`filter.line`), `sums[x] = previous[x] + sum(weights[i] * lines[i][x])`,
+ * and writes their scaled values to `output`. The pixels are processed in order, so
+ * the scalar kernel also works if `previous` lies before `sums` in the same row;
+ * the vectorized kernels require the two not to overlap.
+ *
+ * @param lines Pointers to the input pixels under each tap of the slide for the
+ * first pixel.
+ * @param weights The fixed-point weights of the taps.
+ * @param num_taps Number of taps of the slide.
+ * @param previous The sums of the predecessors of the pixels.
+ * @param sums Receives the sums of the pixels.
+ * @param output Pointer to the first output pixel.
+ * @param count Number of pixels.
+ * @param filter The line filter, which must be `fixed_point`.
+ */
+typedef void (*line_row_fn)(const unsigned char *const *lines,
+							const int32_t *weights, int num_taps,
+							const int32_t *previous, int32_t *sums,
+							unsigned char *output, size_t count,
+							const struct filter *filter);
+
+/**
+ * Returns the kernel continuing the running sums of line filters written for the
+ * given instruction set. `SIMD_NONE` gives the scalar reference implementation; the
+ * vectorized kernels produce bit-exact the same output.
+ *
+ * @param level The instruction set, which must not exceed `detect_simd_level()`.
+ */
+line_row_fn get_line_row(enum simd_level level);
+
+/**
+ * Splits `count` interleaved (`RGBRGB...`) pixels into their three channels.
+ *
+ * @param pixels Pointer to the first interleaved pixel.
+ * @param red Receives the red channel of the pixels.
+ * @param green Receives the green channel of the pixels.
+ * @param blue Receives the blue channel of the pixels.
+ * @param count Number of pixels.
+ */
+typedef void (*deinterleave_fn)(const unsigned char *pixels, unsigned char *red,
+								unsigned char *green, unsigned char *blue,
+								size_t count);
+
+/**
+ * Combines `count` pixels of three channels into interleaved (`RGBRGB...`) pixels.
+ *
+ * @param red The red channel of the pixels.
+ * @param green The green channel of the pixels.
+ * @param blue The blue channel of the pixels.
+ * @param pixels Receives the interleaved pixels.
+ * @param count Number of pixels.
+ */
+typedef void (*interleave_fn)(const unsigned char *red, const unsigned char *green,
+							  const unsigned char *blue, unsigned char *pixels,
+							  size_t count);
+
+/**
+ * Returns the kernel splitting interleaved pixels into channels written for the
+ * given instruction set. `SIMD_NONE` gives the scalar reference implementation;
+ * `SIMD_AVX512` gives the AVX2 kernel, as its byte shuffles would need AVX512BW
+ * and the copy is bound by memory bandwidth anyway.
+ *
+ * @param level The instruction set, which must not exceed `detect_simd_level()`.
+ */
+deinterleave_fn get_deinterleave(enum simd_level level);
+
+/**
+ * Returns the kernel combining channels into interleaved pixels written for the
+ * given instruction set, like `get_deinterleave()`.
+ *
+ * @param level The instruction set, which must not exceed `detect_simd_level()`.
+ */
+interleave_fn get_interleave(enum simd_level level);
@@ -0,0 +1,96 @@
+#include "sparse.h"
+
+static inline unsigned char scale(const struct filter *filter, double sum) {
+	return min(max((int)(filter->factor * sum + filter->bias), 0), 255);
+}
+
+// Computes a pixel near the image border, wrapping the taps that fall outside the
+// image around to the opposite side.
+static void border_pixel(const struct thread_data *data, size_t x, size_t y) {
+	const struct filter *filter = &data->filter;
+	double red = 0.0, green = 0.0, blue = 0.0;
+
+	for (int i = 0; i < filter->num_taps; i++) {
+		const struct filter_tap *tap = &filter->taps[i];
+		size_t imageX = wrap_position((ptrdiff_t)x + tap->dx, data->width);
+		size_t imageY = wrap_position((ptrdiff_t)y + tap->dy, data->height);
+		size_t index = input_index(data, imageX, imageY);
+
+		red += data->input_image->red[index] * tap->weight;
+		green += data->input_image->green[index] * tap->weight;
+		blue += data->input_image->blue[index] * tap->weight;
+	}
+
+	size_t index = output_index(data, x, y);
+	data->output_image->red[index] = scale(filter, red);
+	data->output_image->green[index] = scale(filter, green);
+	data->output_image->blue[index] = scale(filter, blue);
+}
+
+// Computes the interior pixels `[begin, end)` of row `y` of one channel, whose taps
+// lie inside the image or its halo.
+static void interior_span(const struct thread_data *data, const unsigned char *input,
+						  unsigned char *output, double *sums, size_t y,
+						  size_t begin, size_t end) {
+	const struct filter *filter = &data->filter;
+	size_t count = end - begin;
+
+	for (size_t x = 0; x < count; x++) {
+		sums[x] = 0.0;
+	}
+
+	for (int i = 0; i < filter->num_taps; i++) {
+		const struct filter_tap *tap = &filter->taps[i];
+		const unsigned char *pixels =
+			input + input_index(data, (ptrdiff_t)begin + tap->dx,
+								(ptrdiff_t)y + tap->dy);
+
+		for (size_t x = 0; x < count; x++) {
+			sums[x] += pixels[x] * tap->weight;
+		}
+	}
+
+	for (size_t x = 0; x < count; x++) {
+		output[output_index(data, begin + x, y)] = scale(filter, sums[x]);
+	}
+}
+
+bool sparse_block(struct thread_data *data, size_t start_x, size_t start_y,
+				  size_t end_x, size_t end_y) {
+	double *sums = reserve_scratch(data, end_x - start_x);
+	if (sums == NULL) {
+		return false;
+	}
+
+	unsigned char *inputs[] = {data->input_image->red, data->input_image->green,
+							   data->input_image->blue};
+	unsigned char *outputs[] = {data->output_image->red, data->output_image->green,
+								data->output_image->blue};
+
+	size_t interior_x_begin, interior_x_end, interior_y_begin, interior_y_end;
+	tap_bounds(data, data->width, &interior_x_begin, &interior_x_end);
+	tap_bounds(data, data->height, &interior_y_begin, &interior_y_end);
+
+	for (size_t y = start_y; y < end_y; y++) {
+		size_t begin = start_x, end = start_x;
+
+		if (y >= interior_y_begin && y < interior_y_end) {
+			begin = min(max(start_x, interior_x_begin), end_x);
+			end = max(min(end_x, interior_x_end), begin);
+		}
+
+		for (size_t x = start_x; x < begin; x++) {
+			border_pixel(data, x, y);
+		}
+
+		for (int c = 0; c < 3 && begin < end; c++) {
+			interior_span(data, inputs[c], outputs[c], sums, y, begin, end);
+		}
+
+		for (size_t x = end; x < end_x; x++) {
+			border_pixel(data, x, y);
+		}
+	}
+
+	return true;
+}
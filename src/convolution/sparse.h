@@ -0,0 +1,23 @@
+#pragma once
+
+#include "filter_application.h"
+
+/**
+ * Applies a sparse filter (`filter.sparse`) in floating point to the output region
+ * `[start_x, end_x) x [start_y, end_y)`, iterating only over the non-zero taps of
+ * the kernel. For the interior of each row the taps are the outer loop, so every tap
+ * adds a whole span of shifted input pixels to a row of sums in the thread's scratch
+ * buffer; each sum still receives the products in the same order as in the direct
+ * 2D loop, so the result is bit-exact.
+ *
+ * @param data Pointer to the `struct thread_data` describing the images and filter.
+ * @param start_x First column of the region.
+ * @param start_y First row of the region.
+ * @param end_x Column after the last one of the region.
+ * @param end_y Row after the last one of the region.
+ *
+ * @return `true` on success, `false` if the scratch buffer could not be allocated
+ * (nothing is written in that case).
+ */
+bool sparse_block(struct thread_data *data, size_t start_x, size_t start_y,
+				  size_t end_x, size_t end_y);
@@ -0,0 +1,283 @@
+#include "stream.h"
+#include "border.h"
+#include "dispatch.h"
+#include "simd.h"
+#include "../utils/thread_pool.h"
+
+/**
+ * Represents the data passed to each thread streaming a band of rows of an image.
+ *
+ * @param input_image Pointer to the input image.
+ * @param output_image Pointer to the output image.
+ * @param interleaved_input Interleaved (`RGBRGB...`) input pixels, read instead of
+ * `input_image` if not `NULL`.
+ * @param interleaved_output Interleaved output pixels, written instead of
+ * `output_image` if not `NULL`.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param filter The filter to be applied.
+ * @param start First row of the band.
+ * @param end Row after the last one of the band.
+ * @param apron The `size / 2` input rows above the band followed by the `size / 2`
+ * ones below it, saved before any band is written.
+ * @param status Receives `-1` if the thread could not allocate its buffers.
+ */
+struct stream_data {
+	struct image_rgb *input_image;
+	struct image_rgb *output_image;
+	const unsigned char *interleaved_input;
+	unsigned char *interleaved_output;
+	int width;
+	int height;
+	struct filter filter;
+	int start;
+	int end;
+	struct image_rgb apron;
+	int status;
+};
+
+int stream_strip_rows(const struct filter *filter) {
+	return max(STREAM_STRIP_ROWS, filter->size);
+}
+
+// Finds the three channels of row `y` of an image, which may lie in its halo
+static void image_rows(const struct image_rgb *image, ptrdiff_t y,
+					   unsigned char *rows[3]) {
+	ptrdiff_t index = y * (ptrdiff_t)image->stride;
+
+	rows[0] = image->red + index;
+	rows[1] = image->green + index;
+	rows[2] = image->blue + index;
+}
+
+// Copies row `y` of the input image to the rows of the three channels
+static void read_row(const struct stream_data *band, size_t y,
+					 unsigned char *const rows[3], deinterleave_fn deinterleave) {
+	if (band->interleaved_input != NULL) {
+		deinterleave(band->interleaved_input + 3 * y * band->width, rows[0],
+					 rows[1], rows[2], band->width);
+	} else {
+		unsigned char *inputs[3];
+		image_rows(band->input_image, (ptrdiff_t)y, inputs);
+
+		for (int c = 0; c < 3; c++) {
+			memcpy(rows[c], inputs[c], band->width);
+		}
+	}
+}
+
+// Saves the input rows above and below the band, as the border mode of the filter
+// reads them outside the image.
+static void *save_apron(void *arg) {
+	struct stream_data *band = (struct stream_data *)arg;
+	int radius = band->filter.size / 2;
+	enum border_mode border = band->filter.border;
+	deinterleave_fn deinterleave = get_deinterleave(detect_simd_level());
+
+	band->apron = initialize_image_rgb(band->width, max(2 * radius, 1));
+	if (band->apron.red == NULL) {
+		error("Memory allocation error for the rows around a band\n");
+		band->status = -1;
+		return NULL;
+	}
+
+	for (int i = 0; i < 2 * radius; i++) {
+		ptrdiff_t y = i < radius ? band->start - radius + i : band->end + i - radius;
+		unsigned char *rows[3];
+		image_rows(&band->apron, i, rows);
+
+		if (border == BORDER_CONSTANT && (y < 0 || y >= band->height)) {
+			for (int c = 0; c < 3; c++) {
+				memset(rows[c], BORDER_CONSTANT_VALUE, band->width);
+			}
+		} else {
+			read_row(band, border_position(y, band->height, border), rows,
+					 deinterleave);
+		}
+	}
+
+	return NULL;
+}
+
+// Loads input row `y`, of the band or saved around it, into row `i` of the window
+// and fills its halo.
+static void load_row(const struct stream_data *band, struct image_rgb *window,
+					 ptrdiff_t y, ptrdiff_t i, deinterleave_fn deinterleave) {
+	int radius = band->filter.size / 2;
+	unsigned char *rows[3];
+	image_rows(window, i, rows);
+
+	if (y >= band->start && y < band->end) {
+		read_row(band, (size_t)y, rows, deinterleave);
+	} else {
+		unsigned char *saved[3];
+		image_rows(&band->apron,
+				   y < band->start ? y - (band->start - radius)
+								   : radius + (y - band->end),
+				   saved);
+
+		for (int c = 0; c < 3; c++) {
+			memcpy(rows[c], saved[c], band->width);
+		}
+	}
+
+	for (int c = 0; c < 3; c++) {
+		fill_row_border(rows[c], band->width, radius, band->filter.border);
+	}
+}
+
+// Slides the window down the band a strip at a time, filtering each strip into the
+// output as soon as the window holds all the rows it reads.
+static void *stream_band(void *arg) {
+	struct stream_data *band = (struct stream_data *)arg;
+	int radius = band->filter.size / 2;
+	int strip_rows = stream_strip_rows(&band->filter);
+	bool interleaved = band->interleaved_output != NULL;
+	deinterleave_fn deinterleave = get_deinterleave(detect_simd_level());
+	interleave_fn interleave = get_interleave(detect_simd_level());
+
+	// The rows of the strip and the `radius` rows above and below it, all with a
+	// halo of `radius` columns, and the output of the strip to be interleaved
+	struct image_rgb window =
+		initialize_padded_image_rgb(band->width, strip_rows, radius);
+	struct image_rgb strip = {NULL, NULL, NULL, 0, 0, NULL};
+	if (interleaved) {
+		strip = initialize_image_rgb(band->width, strip_rows);
+	}
+
+	struct thread_data data = {.input_image = &window,
+							   .width = band->width,
+							   .filter = band->filter,
+							   .scratch = NULL,
+							   .scratch_size = 0,
+							   .staging = NULL};
+
+	if (window.red == NULL || (interleaved && strip.red == NULL)) {
+		error("Memory allocation error for the window of a band\n");
+		band->status = -1;
+		free_image_rgb(&window);
+		free_image_rgb(&strip);
+		return NULL;
+	}
+
+	ptrdiff_t loaded = band->start - radius;
+
+	for (int top = band->start; top < band->end; top += strip_rows) {
+		int count = min(strip_rows, band->end - top);
+
+		for (; loaded < top + count + radius; loaded++) {
+			load_row(band, &window, loaded, loaded - top, deinterleave);
+		}
+
+		// Planar output is written straight to the rows of the strip
+		struct image_rgb output = strip;
+		if (!interleaved) {
+			unsigned char *rows[3];
+			image_rows(band->output_image, top, rows);
+
+			output = *band->output_image;
+			output.red = rows[0];
+			output.green = rows[1];
+			output.blue = rows[2];
+		}
+
+		data.output_image = &output;
+		data.height = count;
+		apply_filter_to_block(&data, 0, 0, band->width, count);
+
+		for (int y = 0; y < count && interleaved; y++) {
+			size_t index = (size_t)y * strip.stride;
+			size_t row = (size_t)(top + y) * band->width;
+
+			interleave(strip.red + index, strip.green + index, strip.blue + index,
+					   band->interleaved_output + 3 * row, band->width);
+		}
+
+		// The rows the next strip still reads move to the top of the window
+		for (int i = 0; i < 2 * radius; i++) {
+			unsigned char *rows[3], *kept[3];
+			image_rows(&window, i - radius, rows);
+			image_rows(&window, count - radius + i, kept);
+
+			for (int c = 0; c < 3; c++) {
+				memmove(rows[c] - radius, kept[c] - radius,
+						band->width + 2 * radius);
+			}
+		}
+	}
+
+	free(data.scratch);
+	free_image_rgb(&window);
+	free_image_rgb(&strip);
+
+	return NULL;
+}
+
+// Splits the image into one band of rows per thread and streams the bands, once all
+// the rows around them are saved.
+static int stream_bands(const struct stream_data *stream, int num_threads) {
+	if (stream->width <= 0 || stream->height <= 0) {
+		return 0;
+	}
+
+	int num_bands = max(min(num_threads, stream->height), 1);
+	struct stream_data bands[num_bands];
+
+	for (int i = 0; i < num_bands; i++) {
+		bands[i] = *stream;
+		bands[i].start = (int)((long)stream->height * i / num_bands);
+		bands[i].end = (int)((long)stream->height * (i + 1) / num_bands);
+		bands[i].apron = (struct image_rgb){NULL, NULL, NULL, 0, 0, NULL};
+		bands[i].status = 0;
+
+		// The engine is chosen once for the strips rather than per strip
+		bands[i].filter.engine = choose_engine(&stream->filter, stream->width,
+											   stream_strip_rows(&stream->filter));
+	}
+
+	int status = thread_pool_run(save_apron, bands, sizeof(bands[0]), num_bands);
+	for (int i = 0; i < num_bands; i++) {
+		status = bands[i].status != 0 ? -1 : status;
+	}
+
+	if (status == 0) {
+		status = thread_pool_run(stream_band, bands, sizeof(bands[0]), num_bands);
+		for (int i = 0; i < num_bands; i++) {
+			status = bands[i].status != 0 ? -1 : status;
+		}
+	}
+
+	for (int i = 0; i < num_bands; i++) {
+		free_image_rgb(&bands[i].apron);
+	}
+
+	return status;
+}
+
+int stream_application(struct image_rgb *input_image, struct image_rgb *output_image,
+					   int width, int height, struct filter filter,
+					   int num_threads) {
+	struct stream_data stream = {.input_image = input_image,
+								 .output_image = output_image,
+								 .interleaved_input = NULL,
+								 .interleaved_output = NULL,
+								 .width = width,
+								 .height = height,
+								 .filter = filter};
+
+	return stream_bands(&stream, num_threads);
+}
+
+int stream_application_interleaved(const unsigned char *input,
+								   unsigned char *output, int width, int height,
+								   struct filter filter, int num_threads) {
+	struct stream_data stream = {.input_image = NULL,
+								 .output_image = NULL,
+								 .interleaved_input = input,
+								 .interleaved_output = output,
+								 .width = width,
+								 .height = height,
+								 .filter = filter};
+
+	return stream_bands(&stream, num_threads);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "filter_application.h"
+
+#define STREAM_STRIP_ROWS 16 // Fewest output rows filtered per step of the window
+
+/**
+ * Computes how many output rows the streaming application filters at a time: at
+ * least `STREAM_STRIP_ROWS`, and at least as many as the kernel is high, so that
+ * the engines amortize their per-region work (e.g. the column sums of the box
+ * engine) over as many rows as the window holds for the kernel.
+ *
+ * @param filter The filter.
+ *
+ * @return The number of rows of a strip.
+ */
+int stream_strip_rows(const struct filter *filter);
+
+/**
+ * Applies a filter to an image by streaming its rows through a rolling window, so
+ * that the output may overwrite the input. The image is split into one band of rows
+ * per thread. First every thread saves the `size / 2` input rows above and below its
+ * band, which the neighbouring bands overwrite. Then it slides a window over its
+ * band: the window holds a strip of `stream_strip_rows()` rows and `size / 2` rows
+ * above and below it, each with a halo of `size / 2` columns filled with the border
+ * mode of the filter (see `fill_row_border()`). The strip is filtered by
+ * `apply_filter_to_block()`, whose engines read the window without wrapping, and
+ * written to the output at once. The window then moves down by a strip, keeping
+ * the rows the next strip still reads.
+ *
+ * Besides the images, each thread only holds its window and the saved rows, about
+ * `2 * size + STREAM_STRIP_ROWS` rows per channel, and the result is identical to
+ * that of the other modes.
+ *
+ * @param input_image Pointer to the input image (`struct image_rgb`).
+ * @param output_image Pointer to the output image (`struct image_rgb`), which may
+ * be `input_image` to filter it in place.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param filter The convolution filter to be applied.
+ * @param num_threads Number of threads to use, one per band.
+ *
+ * @return `0` on success, `-1` if thread creation or memory allocation fails.
+ */
+int stream_application(struct image_rgb *input_image, struct image_rgb *output_image,
+					   int width, int height, struct filter filter,
+					   int num_threads);
+
+/**
+ * Applies a filter like `stream_application()` to an interleaved (`RGBRGB...`)
+ * image, as loaded by stb_image: the rows are deinterleaved into the window as they
+ * enter it and every filtered strip is interleaved into the output, which may be
+ * the input. Filtering an image in place this way needs no other copy of it.
+ *
+ * @param input Interleaved input pixels.
+ * @param output Interleaved output pixels, either `input` or not overlapping it.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param filter The convolution filter to be applied.
+ * @param num_threads Number of threads to use, one per band.
+ *
+ * @return `0` on success, `-1` if thread creation or memory allocation fails.
+ */
+int stream_application_interleaved(const unsigned char *input,
+								   unsigned char *output, int width, int height,
+								   struct filter filter, int num_threads);
@@ -1,4 +1,9 @@
 #include "filter.h"
+#include "../utils/utils.h"
+
+#include <math.h>
+
+#define MOTION_BLUR_PI 3.14159265358979323846
 
 const FilterInfo filters_info[] = {
 	{"id", "Identity filter (no effect)."},
@@ -8,9 +13,13 @@ const FilterInfo filters_info[] = {
 	{"mbl", "Motion blur filter (9x9 kernel)."},
 	{"ed", "Edge detection filter (3x3 kernel)."},
 	{"em", "Emboss filter (5x5 kernel)."},
-	{"bl+gbl",
-	 "Composition of Standard blur (5x5) and Gaussian blur (5x5) filters."},
-	{"fbl+mbl", "Composition of Fast blur (3x3) and Motion blur (9x9) filters."}};
+	{"box", "Box blur filter ((2r+1)x(2r+1) kernel, r set by --radius, 20 by "
+			"default)."},
+	{"motion", "Motion blur filter (--length pixels along a line at --angle "
+			   "degrees, 9 at -45 like mbl by default)."},
+	{"bl+gbl", "Standard blur (5x5) followed by Gaussian blur (5x5), any filters "
+			   "can be chained with '+'."},
+	{"fbl+mbl", "Fast blur (3x3) followed by Motion blur (9x9)."}};
 
 const double id[3][3] = {{0.0, 0.0, 0.0}, {0.0, 1.0, 0.0}, {0.0, 0.0, 0.0}};
 
@@ -44,41 +53,602 @@ const double emboss[5][5] = {{-1, -1, -1, -1, 0},
 							 {-1, 0, 1, 1, 1},
 							 {0, 1, 1, 1, 1}};
 
+// Rounds `bytes` up to a multiple of the cache line size.
+static size_t align_to_cache_line(size_t bytes) {
+	return (bytes + FILTER_ALIGNMENT - 1) / FILTER_ALIGNMENT * FILTER_ALIGNMENT;
+}
+
+// Byte offsets of the shadow copies in the block allocated by `allocate_kernel()`.
+static size_t float_kernel_offset(int size) {
+	return align_to_cache_line((size_t)size * size * sizeof(double));
+}
+
+static size_t fixed_kernel_offset(int size) {
+	return float_kernel_offset(size) +
+		   align_to_cache_line((size_t)size * size * sizeof(float));
+}
+
+static size_t shift_table_offset(int size) {
+	return fixed_kernel_offset(size) +
+		   align_to_cache_line((size_t)size * size * sizeof(int32_t));
+}
+
+double *allocate_kernel(int size) {
+	size_t bytes = shift_table_offset(size) + align_to_cache_line(256);
+
+	double *kernel = aligned_alloc(FILTER_ALIGNMENT, bytes);
+	if (kernel == NULL) {
+		return NULL;
+	}
+
+	memset(kernel, 0, bytes);
+
+	return kernel;
+}
+
 struct filter create_filter(int size, double factor, double bias,
 							const double values[size][size]) {
-	struct filter filter;
-	filter.size = size;
-	filter.factor = factor;
-	filter.bias = bias;
+	struct filter filter = {
+		.size = size, .factor = factor, .bias = bias, .kernel = NULL};
 
-	filter.kernel = (double **)malloc(size * sizeof(double *));
+	filter.kernel = allocate_kernel(size);
 	if (filter.kernel == NULL) {
-		struct filter empty = {0, 0.0, 0.0, NULL};
+		struct filter empty = {.kernel = NULL};
 		return empty;
 	}
 
 	for (int i = 0; i < size; i++) {
-		filter.kernel[i] = malloc(size * sizeof(double));
-		if (filter.kernel[i] == NULL) {
-			free_filter(&filter);
+		for (int j = 0; j < size; j++) {
+			filter.kernel[i * size + j] = values[i][j];
+		}
+	}
+
+	if (prepare_filter(&filter) != 0) {
+		free_filter(&filter);
+
+		struct filter empty = {.kernel = NULL};
+		return empty;
+	}
+
+	return filter;
+}
+
+struct filter create_box_filter(int radius) {
+	int size = 2 * radius + 1;
+	struct filter filter = {.size = size,
+							.factor = 1.0 / ((double)size * size),
+							.bias = BOX_BLUR_BIAS,
+							.kernel = NULL};
+
+	filter.kernel = allocate_kernel(size);
+	if (filter.kernel == NULL) {
+		struct filter empty = {.kernel = NULL};
+		return empty;
+	}
+
+	for (int i = 0; i < size * size; i++) {
+		filter.kernel[i] = 1.0;
+	}
+
+	if (prepare_filter(&filter) != 0) {
+		free_filter(&filter);
+
+		struct filter empty = {.kernel = NULL};
+		return empty;
+	}
+
+	return filter;
+}
+
+// Rounds `numerator / denominator` to the nearest integer, halves away from zero.
+static int round_fraction(int numerator, int denominator) {
+	return (int)lround((double)numerator / denominator);
+}
+
+struct filter create_motion_blur_filter(int length, double angle) {
+	int size = length | 1;
+	struct filter filter = {.size = size,
+							.factor = 1.0 / length,
+							.bias = MOTION_BLUR_BIAS,
+							.kernel = NULL};
+
+	filter.kernel = allocate_kernel(size);
+	if (filter.kernel == NULL) {
+		struct filter empty = {.kernel = NULL};
+		return empty;
+	}
+
+	// Image rows grow downwards, so the vertical component is negated
+	double radians = angle * MOTION_BLUR_PI / 180.0;
+	double major = cos(radians), minor = -sin(radians);
+	bool horizontal = fabs(major) >= fabs(minor);
+	if (!horizontal) {
+		double tmp = major;
+		major = minor;
+		minor = tmp;
+	}
 
-			struct filter empty = {0, 0.0, 0.0, NULL};
-			return empty;
+	// The slope is rounded to a fraction with a small denominator, so the line
+	// repeats itself and its running sums need few taps per pixel
+	double slope = minor / major;
+	int numerator = 0, denominator = 1;
+	for (int q = 1; q <= MOTION_BLUR_MAX_PERIOD; q++) {
+		int p = (int)lround(slope * q);
+
+		if (fabs(slope - (double)p / q) <
+			fabs(slope - (double)numerator / denominator)) {
+			numerator = p;
+			denominator = q;
 		}
+	}
+
+	for (int k = -(length / 2); k < length - length / 2; k++) {
+		int offset = round_fraction(k * numerator, denominator);
+		int i = size / 2 + (horizontal ? offset : k);
+		int j = size / 2 + (horizontal ? k : offset);
+
+		filter.kernel[i * size + j] = 1.0;
+	}
+
+	if (prepare_filter(&filter) != 0) {
+		free_filter(&filter);
+
+		struct filter empty = {.kernel = NULL};
+		return empty;
+	}
+
+	return filter;
+}
+
+/**
+ * Tries to factor the kernel as `kernel[i * size + j] == column[i] * row[j]` using
+ * the element at (`pivot_y`, `pivot_x`) as the pivot. The factorization is accepted
+ * only if it reproduces every element of the kernel exactly, so the two-pass
+ * application sums the same products as the direct one.
+ */
+static bool try_separable_pivot(const struct filter *filter, int pivot_y,
+								int pivot_x, double *row, double *column) {
+	const double *kernel = filter->kernel;
+	int size = filter->size;
+	double pivot = kernel[pivot_y * size + pivot_x];
+
+	for (int i = 0; i < size; i++) {
+		column[i] = kernel[i * size + pivot_x];
+		row[i] = kernel[pivot_y * size + i] / pivot;
+	}
 
+	for (int i = 0; i < size; i++) {
 		for (int j = 0; j < size; j++) {
-			filter.kernel[i][j] = values[i][j];
+			if (column[i] * row[j] != kernel[i * size + j]) {
+				return false;
+			}
 		}
 	}
 
-	return filter;
+	return true;
 }
 
-void free_filter(struct filter *filter) {
+// Finds the row and column factors of a rank-1 kernel.
+static int find_separable_factors(struct filter *filter) {
+	double *row = malloc(filter->size * sizeof(double));
+	double *column = malloc(filter->size * sizeof(double));
+	if (row == NULL || column == NULL) {
+		free(row);
+		free(column);
+		return -1;
+	}
+
+	// A rank-1 kernel is reproduced by any non-zero pivot in exact arithmetic, but
+	// in floating point only some pivots give exact factors (e.g. the corner `1` of
+	// `gaus_blur` gives integer ones), so all of them are tried in turn.
+	for (int i = 0; i < filter->size && !filter->separable; i++) {
+		for (int j = 0; j < filter->size && !filter->separable; j++) {
+			if (filter->kernel[i * filter->size + j] != 0.0 &&
+				try_separable_pivot(filter, i, j, row, column)) {
+				filter->separable = true;
+			}
+		}
+	}
+
+	if (!filter->separable) {
+		free(row);
+		free(column);
+		return 0;
+	}
+
+	filter->row = row;
+	filter->column = column;
+
+	return 0;
+}
+
+/**
+ * Checks that `(sum * multiplier + offset) >> shift`, truncated to [0, 255], gives
+ * the same value as the floating-point formula `(int)(factor * sum + bias)` for
+ * every sum in [`min_sum`, `max_sum`].
+ */
+static bool verify_fixed_point(const struct filter *filter, int64_t min_sum,
+							   int64_t max_sum, int64_t multiplier, int64_t offset,
+							   int shift) {
+	for (int64_t sum = min_sum; sum <= max_sum; sum++) {
+		int expected =
+			min(max((int)(filter->factor * (double)sum + filter->bias), 0), 255);
+		int64_t actual = min(max((sum * multiplier + offset) >> shift, 0), 255);
+
+		if (actual != expected) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Enables the integer path if all kernel values are small integers and a
+// multiply-shift that reproduces the floating-point result exactly is found.
+static int find_fixed_point_params(struct filter *filter) {
+	int64_t min_sum = 0, max_sum = 0;
+
+	for (int i = 0; i < filter->size * filter->size; i++) {
+		double value = filter->kernel[i];
+
+		if (!(fabs(value) <= INT16_MAX) || value != floor(value)) {
+			return 0;
+		}
+
+		min_sum += min((int64_t)value, 0) * 255;
+		max_sum += max((int64_t)value, 0) * 255;
+	}
+
+	int64_t max_abs_sum = max(-min_sum, max_sum);
+	if (max_abs_sum > FIXED_POINT_MAX_SUM) {
+		return 0;
+	}
+
+	// The largest shift for which the products still fit into `int32_t` gives the
+	// most precise multiplier; rounding the scaled factor and bias either way covers
+	// the cases where the floating-point result sits exactly on an integer.
+	for (int shift = FIXED_POINT_MAX_SHIFT; shift >= 0; shift--) {
+		double scale = ldexp(1.0, shift);
+		double multipliers[] = {ceil(filter->factor * scale),
+								floor(filter->factor * scale)};
+		double offsets[] = {floor(filter->bias * scale), ceil(filter->bias * scale)};
+
+		// Any of the candidate pairs may be picked, so all of them have to fit
+		if (fmax(fabs(multipliers[0]), fabs(multipliers[1])) * (double)max_abs_sum +
+				fmax(fabs(offsets[0]), fabs(offsets[1])) >=
+			(double)INT32_MAX) {
+			continue;
+		}
+
+		for (int m = 0; m < 2 && !filter->fixed_point; m++) {
+			for (int o = 0; o < 2 && !filter->fixed_point; o++) {
+				if (verify_fixed_point(filter, min_sum, max_sum,
+									   (int64_t)multipliers[m], (int64_t)offsets[o],
+									   shift)) {
+					filter->fixed_multiplier = (int32_t)multipliers[m];
+					filter->fixed_offset = (int32_t)offsets[o];
+					filter->fixed_shift = shift;
+					filter->fixed_point = true;
+				}
+			}
+		}
+
+		// Only the most precise shift is tried: if it is not exact, coarser ones
+		// are not either.
+		break;
+	}
+
+	if (filter->fixed_point) {
+		filter->fixed_kernel =
+			(int32_t *)((char *)filter->kernel + fixed_kernel_offset(filter->size));
+
+		for (int i = 0; i < filter->size * filter->size; i++) {
+			filter->fixed_kernel[i] = (int32_t)filter->kernel[i];
+		}
+
+		for (int i = 0; i < filter->num_taps; i++) {
+			filter->taps[i].fixed_weight = (int32_t)filter->taps[i].weight;
+		}
+	}
+
+	return 0;
+}
+
+// Collects the non-zero kernel values in row-major order.
+static int build_taps(struct filter *filter) {
+	filter->taps = malloc(filter->size * filter->size * sizeof(struct filter_tap));
+	if (filter->taps == NULL) {
+		return -1;
+	}
+
 	for (int i = 0; i < filter->size; i++) {
-		free(filter->kernel[i]);
+		for (int j = 0; j < filter->size; j++) {
+			double value = filter->kernel[i * filter->size + j];
+
+			if (value != 0.0) {
+				struct filter_tap tap = {.dy = i - filter->size / 2,
+										 .dx = j - filter->size / 2,
+										 .weight = value,
+										 .fixed_weight = 0};
+				filter->taps[filter->num_taps++] = tap;
+			}
+		}
+	}
+
+	filter->sparse = filter->num_taps <=
+					 SPARSE_DENSITY_THRESHOLD * filter->size * filter->size;
+
+	return 0;
+}
+
+// Returns whether the kernel value at the offset `(dx, dy)` from its center is
+// non-zero.
+static bool has_tap(const struct filter *filter, int dx, int dy) {
+	int center = filter->size / 2;
+
+	return abs(dx) <= center && abs(dy) <= center &&
+		   filter->kernel[(dy + center) * filter->size + dx + center] != 0.0;
+}
+
+// Counts the taps of the slide by `(dx, dy)` and stores them in `taps` unless it is
+// `NULL`. The window gains the kernel values whose successor along the step is
+// zero and loses the ones one step behind those whose predecessor is zero.
+static int build_slide(const struct filter *filter, int dx, int dy,
+					   struct filter_tap *taps) {
+	int count = 0;
+
+	for (int i = 0; i < filter->num_taps; i++) {
+		const struct filter_tap *tap = &filter->taps[i];
+
+		if (!has_tap(filter, tap->dx + dx, tap->dy + dy)) {
+			if (taps != NULL) {
+				struct filter_tap entering = {.dy = tap->dy,
+											  .dx = tap->dx,
+											  .weight = tap->weight,
+											  .fixed_weight = tap->fixed_weight};
+				taps[count] = entering;
+			}
+			count++;
+		}
+
+		if (!has_tap(filter, tap->dx - dx, tap->dy - dy)) {
+			if (taps != NULL) {
+				struct filter_tap leaving = {.dy = tap->dy - dy,
+											 .dx = tap->dx - dx,
+											 .weight = -tap->weight,
+											 .fixed_weight = -tap->fixed_weight};
+				taps[count] = leaving;
+			}
+			count++;
+		}
+	}
+
+	return count;
+}
+
+// Fills `slide` with the taps of the slide by `(dx, dy)`.
+static int init_slide(const struct filter *filter, int dx, int dy,
+					  struct filter_slide *slide) {
+	slide->dx = dx;
+	slide->dy = dy;
+	slide->num_taps = build_slide(filter, dx, dy, NULL);
+	slide->taps = malloc(max(slide->num_taps, 1) * sizeof(struct filter_tap));
+	if (slide->taps == NULL) {
+		return -1;
+	}
+
+	build_slide(filter, dx, dy, slide->taps);
+
+	return 0;
+}
+
+// Enables the running sums of sparse fixed-point kernels (so the sums are exact
+// integers) whose non-zero values are all the same if sliding them along some short
+// step changes fewer than half of their values.
+static int find_line_slides(struct filter *filter) {
+	if (!filter->sparse || !filter->fixed_point || filter->num_taps == 0) {
+		return 0;
+	}
+
+	for (int i = 0; i < filter->num_taps; i++) {
+		if (filter->taps[i].weight != filter->taps[0].weight) {
+			return 0;
+		}
+	}
+
+	int best_dx = 1, best_dy = 0;
+	int best_count = build_slide(filter, best_dx, best_dy, NULL);
+
+	for (int dy = 0; dy <= LINE_MAX_STEP; dy++) {
+		for (int dx = -LINE_MAX_STEP; dx <= LINE_MAX_STEP; dx++) {
+			if (dy == 0 && dx <= 0) {
+				continue;
+			}
+
+			int count = build_slide(filter, dx, dy, NULL);
+			if (count < best_count ||
+				(count == best_count && abs(dx) + dy < abs(best_dx) + best_dy)) {
+				best_count = count;
+				best_dx = dx;
+				best_dy = dy;
+			}
+		}
+	}
+
+	if (2 * best_count >= filter->num_taps) {
+		return 0;
+	}
+
+	const int steps[NUM_LINE_SLIDES][2] = {{best_dx, best_dy}, {1, 0}, {0, 1}};
+	for (int i = 0; i < NUM_LINE_SLIDES; i++) {
+		if (init_slide(filter, steps[i][0], steps[i][1], &filter->slides[i]) != 0) {
+			return -1;
+		}
+	}
+
+	filter->line = true;
+
+	return 0;
+}
+
+// Recognizes a kernel with a single non-zero value and tabulates the output of
+// each input value, computed like `sequential_application()` does, so looking the
+// shifted pixels up gives exactly its result.
+static void find_shift(struct filter *filter) {
+	if (filter->num_taps != 1) {
+		return;
+	}
+
+	filter->shift = true;
+	filter->shift_copy = true;
+	filter->shift_table =
+		(unsigned char *)filter->kernel + shift_table_offset(filter->size);
+
+	for (int value = 0; value < 256; value++) {
+		double sum = filter->taps[0].weight * value;
+		int result = min(max((int)(filter->factor * sum + filter->bias), 0), 255);
+
+		filter->shift_table[value] = (unsigned char)result;
+		filter->shift_copy = filter->shift_copy && result == value;
 	}
-	free((void *)filter->kernel);
+}
+
+// Computes the numerical rank of the kernel by Gaussian elimination with full
+// pivoting; pivots below `FILTER_RANK_EPSILON` times the largest value count as
+// zero.
+static int find_rank(struct filter *filter) {
+	int size = filter->size;
+	double *matrix = malloc((size_t)size * size * sizeof(double));
+	if (matrix == NULL) {
+		return -1;
+	}
+
+	double largest = 0.0;
+	for (int i = 0; i < size * size; i++) {
+		matrix[i] = filter->kernel[i];
+		largest = max(largest, fabs(matrix[i]));
+	}
+
+	filter->rank = 0;
+	for (int step = 0; step < size; step++) {
+		int pivot_y = step, pivot_x = step;
+
+		for (int i = step; i < size; i++) {
+			for (int j = step; j < size; j++) {
+				if (fabs(matrix[i * size + j]) >
+					fabs(matrix[pivot_y * size + pivot_x])) {
+					pivot_y = i;
+					pivot_x = j;
+				}
+			}
+		}
+
+		double pivot = matrix[pivot_y * size + pivot_x];
+		if (fabs(pivot) <= FILTER_RANK_EPSILON * largest) {
+			break;
+		}
+
+		// Moves the pivot to `(step, step)`, then eliminates the rows below it
+		for (int j = 0; j < size; j++) {
+			double tmp = matrix[step * size + j];
+			matrix[step * size + j] = matrix[pivot_y * size + j];
+			matrix[pivot_y * size + j] = tmp;
+		}
+		for (int i = 0; i < size; i++) {
+			double tmp = matrix[i * size + step];
+			matrix[i * size + step] = matrix[i * size + pivot_x];
+			matrix[i * size + pivot_x] = tmp;
+		}
+
+		for (int i = step + 1; i < size; i++) {
+			double ratio = matrix[i * size + step] / pivot;
+
+			for (int j = step; j < size; j++) {
+				matrix[i * size + j] -= ratio * matrix[step * size + j];
+			}
+		}
+
+		filter->rank++;
+	}
+
+	free(matrix);
+	return 0;
+}
+
+// Releases the taps of the slides of a line filter.
+static void free_slides(struct filter *filter) {
+	for (int i = 0; i < NUM_LINE_SLIDES; i++) {
+		free(filter->slides[i].taps);
+		filter->slides[i].taps = NULL;
+		filter->slides[i].num_taps = 0;
+	}
+
+	filter->line = false;
+}
+
+// Fills the single-precision copy and computes the sum and the symmetry of the
+// kernel values. A kernel of equal integer values is a box: its products with the
+// pixels are exact, so running sums give the same result as the direct loop.
+static void analyze_kernel(struct filter *filter) {
+	int length = filter->size * filter->size;
+
+	filter->float_kernel =
+		(float *)((char *)filter->kernel + float_kernel_offset(filter->size));
+	filter->sum = 0.0;
+	filter->symmetric = true;
+	filter->box = filter->kernel[0] != 0.0 &&
+				  fabs(filter->kernel[0]) <= INT16_MAX &&
+				  filter->kernel[0] == floor(filter->kernel[0]);
+
+	for (int i = 0; i < length; i++) {
+		filter->float_kernel[i] = (float)filter->kernel[i];
+		filter->sum += filter->kernel[i];
+
+		if (filter->kernel[i] != filter->kernel[length - 1 - i]) {
+			filter->symmetric = false;
+		}
+
+		if (filter->kernel[i] != filter->kernel[0]) {
+			filter->box = false;
+		}
+	}
+}
+
+int prepare_filter(struct filter *filter) {
+	free(filter->row);
+	free(filter->column);
+	free(filter->taps);
+	free_slides(filter);
+	filter->separable = false;
+	filter->row = NULL;
+	filter->column = NULL;
+	filter->taps = NULL;
+	filter->num_taps = 0;
+	filter->sparse = false;
+	filter->fixed_point = false;
+	filter->fixed_kernel = NULL;
+	filter->shift = false;
+	filter->shift_table = NULL;
+	filter->shift_copy = false;
+
+	analyze_kernel(filter);
+
+	if (build_taps(filter) != 0 || find_separable_factors(filter) != 0 ||
+		find_rank(filter) != 0 || find_fixed_point_params(filter) != 0) {
+		return -1;
+	}
+
+	find_shift(filter);
+
+	return find_line_slides(filter);
+}
+
+void free_filter(struct filter *filter) {
+	free(filter->kernel);
+	free(filter->row);
+	free(filter->column);
+	free(filter->taps);
+	free_slides(filter);
 }
 
 struct filter compose_filters_from_params(int size1, double factor1, double bias1,
@@ -87,24 +657,13 @@ struct filter compose_filters_from_params(int size1, double factor1, double bias
 										  const double kernel2[size2][size2]) {
 	int new_size = size1 + size2 - 1;
 
-	double **kernel = (double **)malloc(new_size * sizeof(double *));
+	double *kernel = allocate_kernel(new_size);
 	if (kernel == NULL) {
-		struct filter empty = {0, 0.0, 0.0, NULL};
+		struct filter empty = {.kernel = NULL};
 		return empty;
 	}
 
 	for (int i = 0; i < new_size; i++) {
-		kernel[i] = malloc(new_size * sizeof(double));
-		if (kernel[i] == NULL) {
-			for (int j = 0; j < i; j++) {
-				free(kernel[j]);
-			}
-			free((void *)kernel);
-
-			struct filter empty = {0, 0.0, 0.0, NULL};
-			return empty;
-		}
-
 		for (int j = 0; j < new_size; j++) {
 
 			for (int fi = 0; fi < size1; fi++) {
@@ -113,18 +672,149 @@ struct filter compose_filters_from_params(int size1, double factor1, double bias
 					int j2 = j - fj;
 
 					if (i2 >= 0 && i2 < size2 && j2 >= 0 && j2 < size2) {
-						kernel[i][j] += kernel1[fi][fj] * kernel2[i2][j2];
+						kernel[i * new_size + j] +=
+							kernel1[fi][fj] * kernel2[i2][j2];
 					}
 				}
 			}
 		}
 	}
 
+	// The bias of the first filter is spread over all taps of the second one
+	double sum2 = 0.0;
+	for (int i = 0; i < size2; i++) {
+		for (int j = 0; j < size2; j++) {
+			sum2 += kernel2[i][j];
+		}
+	}
+
 	double new_factor = factor1 * factor2;
-	double new_bias = bias1 * factor2 + bias2;
+	double new_bias = bias1 * factor2 * sum2 + bias2;
 
 	struct filter composed = {
 		.size = new_size, .factor = new_factor, .bias = new_bias, .kernel = kernel};
 
+	if (prepare_filter(&composed) != 0) {
+		free_filter(&composed);
+
+		struct filter empty = {.kernel = NULL};
+		return empty;
+	}
+
 	return composed;
 }
+
+struct filter compose_filters(const struct filter *first,
+							  const struct filter *second) {
+	return compose_filters_from_params(
+		first->size, first->factor, first->bias,
+		(const double(*)[first->size])first->kernel, second->size, second->factor,
+		second->bias, (const double(*)[second->size])second->kernel);
+}
+
+bool filter_output_in_range(const struct filter *filter) {
+	double lowest = filter->bias, highest = filter->bias;
+
+	for (int i = 0; i < filter->size * filter->size; i++) {
+		double weight = filter->factor * filter->kernel[i] * 255.0;
+
+		if (weight < 0) {
+			lowest += weight;
+		} else {
+			highest += weight;
+		}
+	}
+
+	// Values in (-1, 256) are truncated to `[0, 255]` without clamping
+	return lowest > -1.0 && highest < 256.0;
+}
+
+double filter_gain(const struct filter *filter) {
+	double gain = 0.0;
+
+	for (int i = 0; i < filter->size * filter->size; i++) {
+		gain += fabs(filter->factor * filter->kernel[i]);
+	}
+
+	return gain;
+}
+
+static const char *const engine_names[NUM_FILTER_ENGINES] = {
+	[FILTER_ENGINE_AUTO] = "auto",
+	[FILTER_ENGINE_DIRECT] = "direct",
+	[FILTER_ENGINE_FFT] = "fft",
+	[FILTER_ENGINE_SHIFT] = "shift",
+	[FILTER_ENGINE_BOX] = "box",
+	[FILTER_ENGINE_LINE] = "line",
+	[FILTER_ENGINE_SEPARABLE] = "separable",
+	[FILTER_ENGINE_FIXED_POINT] = "fixed",
+	[FILTER_ENGINE_SPARSE] = "sparse",
+	[FILTER_ENGINE_GENERIC] = "generic",
+};
+
+const char *filter_engine_name(enum filter_engine engine) {
+	return engine_names[engine];
+}
+
+bool parse_filter_engine(const char *name, enum filter_engine *engine) {
+	for (int i = 0; i < NUM_FILTER_ENGINES; i++) {
+		if (strcmp(name, engine_names[i]) == 0) {
+			*engine = (enum filter_engine)i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static const char *const border_names[NUM_BORDER_MODES] = {
+	[BORDER_WRAP] = "wrap",
+	[BORDER_CLAMP] = "clamp",
+	[BORDER_MIRROR] = "mirror",
+	[BORDER_CONSTANT] = "constant",
+};
+
+const char *border_mode_name(enum border_mode border) {
+	return border_names[border];
+}
+
+bool parse_border_mode(const char *name, enum border_mode *border) {
+	for (int i = 0; i < NUM_BORDER_MODES; i++) {
+		if (strcmp(name, border_names[i]) == 0) {
+			*border = (enum border_mode)i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void describe_filter(const struct filter *filter, char *buffer, size_t size) {
+	int length = snprintf(buffer, size, "%dx%d, %d tap%s, rank %d", filter->size,
+						  filter->size, filter->num_taps,
+						  filter->num_taps == 1 ? "" : "s", filter->rank);
+
+	const char *traits[] = {
+		filter->shift_copy && filter->taps[0].dx == 0 && filter->taps[0].dy == 0
+			? "identity"
+			: NULL,
+		filter->shift ? "shift" : NULL,
+		filter->box ? "box" : NULL,
+		filter->line ? "line" : NULL,
+		filter->separable ? "separable" : NULL,
+		filter->sparse ? "sparse" : NULL,
+		filter->symmetric ? "symmetric" : NULL,
+		filter->fixed_point ? "integer" : NULL,
+	};
+
+	for (size_t i = 0; i < sizeof(traits) / sizeof(traits[0]); i++) {
+		if (traits[i] != NULL && length >= 0 && (size_t)length < size) {
+			length += snprintf(buffer + length, size - length, ", %s", traits[i]);
+		}
+	}
+
+	if (filter->border != BORDER_WRAP && length >= 0 && (size_t)length < size) {
+		snprintf(buffer + length, size - length, ", %s border",
+				 border_mode_name(filter->border));
+	}
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #define ID_SIZE 3
@@ -30,7 +32,22 @@
 #define EMBOSS_FACTOR 1.0
 #define EMBOSS_BIAS 128.0
 
-#define NUM_OF_FILTERS 9
+#define BOX_BLUR_RADIUS 20 // Default radius, the kernel is (2 * radius + 1) wide
+#define BOX_BLUR_BIAS 0.0
+
+#define MOTION_BLUR_LENGTH 9 // Default length of the "motion" filter in pixels
+#define MOTION_BLUR_ANGLE (-45.0) // Default direction in degrees, that of `mbl`
+#define MOTION_BLUR_MAX_PERIOD 16 // Largest denominator of the rasterized slope
+
+#define NUM_OF_FILTERS 11
+
+#define SPARSE_DENSITY_THRESHOLD 0.5 // Max share of non-zero values (sparse)
+#define FIXED_POINT_MAX_SUM (1 << 20) // Largest kernel sum over 8-bit pixels
+#define FIXED_POINT_MAX_SHIFT 30
+#define FILTER_ALIGNMENT 64 // Cache line size, alignment of the kernel copies
+#define FILTER_RANK_EPSILON 1e-9 // Relative size of pivots treated as zero
+#define LINE_MAX_STEP MOTION_BLUR_MAX_PERIOD // Largest step of a filter slide
+#define NUM_LINE_SLIDES 3
 
 /**
  * Represents metadata about a filter, including its name and description.
@@ -45,20 +62,177 @@ typedef struct {
 
 extern const FilterInfo filters_info[];
 
+/**
+ * Selects how a filter is applied by the optimized modes. The automatic choices
+ * resolve to one of the specific engines (see `choose_engine()`), which can also be
+ * forced, e.g. for benchmarking.
+ *
+ * @param FILTER_ENGINE_AUTO The engine the cost model expects to be the fastest,
+ * FFT-based only for kernels of integer values.
+ * @param FILTER_ENGINE_DIRECT The fastest engine that is not FFT-based.
+ * @param FILTER_ENGINE_FFT FFT-based convolution.
+ * @param FILTER_ENGINE_SHIFT Copying the shifted input through a lookup table, for
+ * `shift` filters.
+ * @param FILTER_ENGINE_BOX Running sums or summed-area tables of a `box` filter.
+ * @param FILTER_ENGINE_LINE Running sums of a `line` filter.
+ * @param FILTER_ENGINE_SEPARABLE Two 1D passes over the factors of a `separable`
+ * filter.
+ * @param FILTER_ENGINE_FIXED_POINT Integer arithmetic, for `fixed_point` filters.
+ * @param FILTER_ENGINE_SPARSE Floating point over the non-zero taps.
+ * @param FILTER_ENGINE_GENERIC Floating point over the whole kernel.
+ */
+enum filter_engine {
+	FILTER_ENGINE_AUTO,
+	FILTER_ENGINE_DIRECT,
+	FILTER_ENGINE_FFT,
+	FILTER_ENGINE_SHIFT,
+	FILTER_ENGINE_BOX,
+	FILTER_ENGINE_LINE,
+	FILTER_ENGINE_SEPARABLE,
+	FILTER_ENGINE_FIXED_POINT,
+	FILTER_ENGINE_SPARSE,
+	FILTER_ENGINE_GENERIC
+};
+
+#define NUM_FILTER_ENGINES (FILTER_ENGINE_GENERIC + 1)
+
+/**
+ * Selects which pixel a tap falling outside the image reads, for an image
+ * `a b c` of one row.
+ *
+ * @param BORDER_WRAP The pixel on the opposite side of the image: `b c | a b c | a
+ * b`.
+ * @param BORDER_CLAMP The nearest pixel of the image: `a a | a b c | c c`.
+ * @param BORDER_MIRROR The pixel mirrored at the border, edge pixels included:
+ * `b a | a b c | c b`.
+ * @param BORDER_CONSTANT A pixel of value `BORDER_CONSTANT_VALUE` in all channels.
+ */
+enum border_mode { BORDER_WRAP, BORDER_CLAMP, BORDER_MIRROR, BORDER_CONSTANT };
+
+#define NUM_BORDER_MODES (BORDER_CONSTANT + 1)
+#define BORDER_CONSTANT_VALUE 0 // Value of the pixels outside in `BORDER_CONSTANT`
+
+/**
+ * Represents one non-zero kernel value as an offset from the output pixel.
+ *
+ * @param dy Vertical offset of the input pixel (`filterY - size / 2`).
+ * @param dx Horizontal offset of the input pixel (`filterX - size / 2`).
+ * @param weight The kernel value.
+ * @param fixed_weight The kernel value as an integer (only meaningful if the filter
+ * is `fixed_point`).
+ */
+struct filter_tap {
+	int dy;
+	int dx;
+	double weight;
+	int32_t fixed_weight;
+};
+
+/**
+ * Describes how the sum of a line filter changes between two output pixels that are
+ * `(dx, dy)` apart: the sum at `(x, y)` is the one at `(x - dx, y - dy)` plus the
+ * products of the `num_taps` taps, which carry the kernel values entering the
+ * window and the negated ones leaving it.
+ *
+ * @param dx Horizontal distance between the two pixels.
+ * @param dy Vertical distance between the two pixels (`dy > 0` or `dx > 0`, so the
+ * earlier pixel comes first in row-major order).
+ * @param num_taps Number of elements in `taps`.
+ * @param taps The taps updating the sum.
+ */
+struct filter_slide {
+	int dx;
+	int dy;
+	int num_taps;
+	struct filter_tap *taps;
+};
+
 /**
  * Represents a convolution filter with its size, scaling factor, bias, and kernel.
  *
  * @param size Size of the filter kernel (e.g., 3 for a 3x3 kernel).
  * @param factor Scaling factor applied to the convolution result.
  * @param bias Bias added to the convolution result.
- * @param kernel Pointer to a dynamically allocated 2D array representing the filter
- * kernel.
+ * @param kernel The kernel values in row-major order (`kernel[i * size + j]`).
+ * The kernel and its shadow copies share a single allocation, each of them starting
+ * at a `FILTER_ALIGNMENT` boundary.
+ * @param float_kernel Single-precision copy of `kernel`.
+ * @param fixed_kernel Integer copy of `kernel` if the filter is `fixed_point`,
+ * `NULL` otherwise.
+ * @param sum Sum of the kernel values.
+ * @param symmetric Whether the kernel does not change when rotated by 180 degrees,
+ * so convolution and correlation with it give the same result.
+ * @param box Whether all kernel values are the same integer, so the filter can be
+ * applied with running sums or summed-area tables at a cost per pixel independent
+ * of its size (see `box_block()`).
+ * @param line Whether the filter is `fixed_point` and `sparse`, all its non-zero
+ * kernel values are the same and sliding the kernel by a short step changes fewer
+ * than half of them, so it can be applied with running sums along that step (e.g.
+ * motion blurs).
+ * @param slides For line filters, the cheapest slide of all steps of at most
+ * `LINE_MAX_STEP` pixels, the one along rows (`(1, 0)`) and the one along columns
+ * (`(0, 1)`), in this order.
+ * @param separable Whether the kernel is an outer product of two 1D vectors
+ * (`kernel[i * size + j] == column[i] * row[j]`), so it can be applied in two 1D
+ * passes.
+ * @param row Horizontal factor of a separable kernel (`size` values), `NULL`
+ * otherwise.
+ * @param column Vertical factor of a separable kernel (`size` values), `NULL`
+ * otherwise.
+ * @param taps The non-zero kernel values in row-major order, so skipping the zero
+ * ones does not change the order in which the products are summed.
+ * @param num_taps Number of elements in `taps`, i.e. of non-zero kernel values.
+ * @param sparse Whether at most `SPARSE_DENSITY_THRESHOLD` of the kernel values are
+ * non-zero, so iterating `taps` beats the dense 2D loop.
+ * @param fixed_point Whether the kernel holds small integers and the result can be
+ * computed with integer arithmetic from `fixed_kernel` (or the `fixed_weight` of the
+ * taps) as `(sum * fixed_multiplier + fixed_offset) >> fixed_shift`, giving exactly
+ * the same values as `factor * sum + bias`.
+ * @param fixed_multiplier Fixed-point representation of `factor`.
+ * @param fixed_offset Fixed-point representation of `bias`.
+ * @param fixed_shift Number of fractional bits of `fixed_multiplier` and
+ * `fixed_offset`.
+ * @param shift Whether the kernel has a single non-zero value, so each output pixel
+ * only depends on the input pixel at the offset of `taps[0]` and is looked up in
+ * `shift_table`.
+ * @param shift_table For shift filters, the output value of each input value
+ * (`(int)(factor * weight * value + bias)` clamped to [0, 255]), `NULL` otherwise.
+ * It shares the allocation of `kernel`.
+ * @param shift_copy Whether `shift_table` maps each value to itself, so the output
+ * is a plain copy of the shifted input (e.g. `id`).
+ * @param rank Numerical rank of the kernel matrix: 1 for separable kernels, small
+ * for sums of a few separable ones.
+ * @param engine How the filter is applied (`FILTER_ENGINE_AUTO` by default).
+ * @param border What the taps outside the image read (`BORDER_WRAP` by default).
  */
 struct filter {
 	int size;
 	double factor;
 	double bias;
-	double **kernel;
+	double *kernel;
+	float *float_kernel;
+	int32_t *fixed_kernel;
+	double sum;
+	bool symmetric;
+	bool box;
+	bool line;
+	struct filter_slide slides[NUM_LINE_SLIDES];
+	bool separable;
+	double *row;
+	double *column;
+	struct filter_tap *taps;
+	int num_taps;
+	bool sparse;
+	bool fixed_point;
+	int32_t fixed_multiplier;
+	int32_t fixed_offset;
+	int fixed_shift;
+	bool shift;
+	unsigned char *shift_table;
+	bool shift_copy;
+	int rank;
+	enum filter_engine engine;
+	enum border_mode border;
 };
 
 extern const double id[3][3];
@@ -84,6 +258,59 @@ extern const double emboss[5][5];
 struct filter create_filter(int size, double factor, double bias,
 							const double values[size][size]);
 
+/**
+ * Creates a box blur filter, which averages the `(2 * radius + 1)` x
+ * `(2 * radius + 1)` pixels around each output pixel.
+ *
+ * @param radius Radius of the box (`BOX_BLUR_RADIUS` by default).
+ *
+ * @return A `struct filter` with all kernel values set to `1`. If memory allocation
+ * fails, returns an empty filter `{0, 0.0, 0.0, NULL}`.
+ */
+struct filter create_box_filter(int radius);
+
+/**
+ * Creates a motion blur filter, which averages `length` pixels along a line through
+ * each output pixel. The line is rasterized along its major axis with the slope
+ * rounded to the nearest fraction `p / q` with `q <= MOTION_BLUR_MAX_PERIOD`, so the
+ * pattern of its pixels repeats every `q` pixels and the filter can be applied
+ * with running sums (`filter.line`) at a cost per pixel independent of `length`.
+ *
+ * @param length Number of pixels on the line (`MOTION_BLUR_LENGTH` by default).
+ * @param angle Direction of the line in degrees, counter-clockwise from the x axis
+ * (`MOTION_BLUR_ANGLE` by default).
+ *
+ * @return A `struct filter` of size `length` (rounded up to an odd number) with the
+ * kernel values on the line set to `1`. If memory allocation fails, returns an
+ * empty filter `{0, 0.0, 0.0, NULL}`.
+ */
+struct filter create_motion_blur_filter(int length, double angle);
+
+/**
+ * Allocates the aligned block holding the kernel of a `size` x `size` filter and its
+ * shadow copies, with all values set to zero.
+ *
+ * @param size Size of the filter kernel.
+ *
+ * @return Pointer to the kernel values, to be stored in `filter.kernel` and released
+ * with `free_filter()`. Returns `NULL` if memory allocation fails.
+ */
+double *allocate_kernel(int size);
+
+/**
+ * Precomputes the data derived from the filter kernel: the shadow copies, the sum
+ * and symmetry of the values, the list of non-zero taps, the 1D factors of a
+ * separable kernel, the rank of the kernel, the integer form of a kernel that can
+ * be applied in fixed point and the lookup table of a shift. It is called by
+ * `create_filter()` and `compose_filters_from_params()` and must be called again
+ * after the kernel values have been modified in place.
+ *
+ * @param filter Pointer to the `struct filter` to analyze.
+ *
+ * @return `0` on success, `-1` if memory allocation fails.
+ */
+int prepare_filter(struct filter *filter);
+
 /**
  * Frees the memory allocated for a filter's kernel.
  *
@@ -111,3 +338,86 @@ struct filter compose_filters_from_params(int size1, double factor1, double bias
 										  const double kernel1[size1][size1],
 										  int size2, double factor2, double bias2,
 										  const double kernel2[size2][size2]);
+
+/**
+ * Composes two filters into a single filter whose kernel is the convolution of
+ * their kernels (see `compose_filters_from_params()`).
+ *
+ * @param first The filter applied first.
+ * @param second The filter applied second.
+ *
+ * @return The composed filter, or an empty filter if memory allocation fails.
+ */
+struct filter compose_filters(const struct filter *first,
+							  const struct filter *second);
+
+/**
+ * Checks whether the filter maps any image into `[0, 255]` without clamping. Then
+ * applying a following filter to its output or to its unrounded values, i.e. with
+ * the composition of both filters, only differs by rounding.
+ *
+ * @param filter The filter to check.
+ *
+ * @return `true` if no output value of the filter is clamped.
+ */
+bool filter_output_in_range(const struct filter *filter);
+
+/**
+ * Computes by how much the filter scales differences of its input at most, i.e. the
+ * sum of the absolute kernel values times the factor. Rounding differences of the
+ * input of a filter with a gain of at most 1 do not grow in its output.
+ *
+ * @param filter The filter.
+ *
+ * @return The gain of the filter.
+ */
+double filter_gain(const struct filter *filter);
+
+/**
+ * Returns the name of an engine as accepted by `--engine=` (e.g. `"fixed"`).
+ *
+ * @param engine The engine.
+ *
+ * @return The name of the engine.
+ */
+const char *filter_engine_name(enum filter_engine engine);
+
+/**
+ * Looks up an engine by the name `filter_engine_name()` returns for it.
+ *
+ * @param name The name of the engine.
+ * @param engine Receives the engine.
+ *
+ * @return `true` if the name is known.
+ */
+bool parse_filter_engine(const char *name, enum filter_engine *engine);
+
+/**
+ * Returns the name of a border mode as accepted by `--border=` (e.g. `"mirror"`).
+ *
+ * @param border The border mode.
+ *
+ * @return The name of the border mode.
+ */
+const char *border_mode_name(enum border_mode border);
+
+/**
+ * Looks up a border mode by the name `border_mode_name()` returns for it.
+ *
+ * @param name The name of the border mode.
+ * @param border Receives the border mode.
+ *
+ * @return `true` if the name is known.
+ */
+bool parse_border_mode(const char *name, enum border_mode *border);
+
+/**
+ * Writes a short description of the structure of the kernel found by
+ * `prepare_filter()`, e.g. `5x5, 25 taps, rank 1, separable, symmetric, integer`,
+ * followed by the border mode unless it is `BORDER_WRAP` (e.g. `, mirror border`).
+ *
+ * @param filter The filter.
+ * @param buffer Receives the description.
+ * @param size Size of `buffer` in bytes; longer descriptions are truncated.
+ */
+void describe_filter(const struct filter *filter, char *buffer, size_t size);
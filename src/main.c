@@ -1,26 +1,244 @@
+#include "convolution/autotune.h"
+#include "convolution/chain.h"
+#include "convolution/dispatch.h"
 #include "convolution/parallel_dispatch.h"
+#include "convolution/stream.h"
 #include "filters/filter.h"
 #include "queue_mode/queue_dispatch.h"
 #include "queue_mode/threads.h"
 #include "utils/args.h"
+#include "utils/thread_pool.h"
 
 #include <errno.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #define PATH_PREFIX_LEN 7	  // Length "images/"
 #define UNDERSCORE_COUNT 2	  // Number of underscores
 #define NULL_TERMINATOR_LEN 1 // Terminating null character '\0'
 #define DIR_ACCESS_RIGHTS 0755
 
+// Adapts the sequential modes to the signature of the parallel ones
+static int sequential_pass(struct image_rgb *input_image,
+						   struct image_rgb *output_image, int width, int height,
+						   struct filter filter, int num_threads) {
+	(void)num_threads;
+	sequential_application(input_image, output_image, width, height, filter);
+	return 0;
+}
+
+// Tile size of the tile mode given on the command line, `0` if sized automatically
+static int requested_tile_width = 0;
+static int requested_tile_height = 0;
+
+static int tile_pass(struct image_rgb *input_image, struct image_rgb *output_image,
+					 int width, int height, struct filter filter, int num_threads) {
+	return parallel_tile(input_image, output_image, width, height, filter,
+						 num_threads, requested_tile_width, requested_tile_height);
+}
+
+// Block size of the block mode chosen by the autotuner, `0` for that of
+// `parallel_block()`
+static int requested_block_width = 0;
+static int requested_block_height = 0;
+
+static int block_pass(struct image_rgb *input_image, struct image_rgb *output_image,
+					  int width, int height, struct filter filter, int num_threads) {
+	if (requested_block_width == 0) {
+		return parallel_block(input_image, output_image, width, height, filter,
+							  num_threads);
+	}
+
+	return parallel_block_sized(input_image, output_image, width, height, filter,
+								num_threads, requested_block_width,
+								requested_block_height);
+}
+
+static int sequential_fast_pass(struct image_rgb *input_image,
+								struct image_rgb *output_image, int width,
+								int height, struct filter filter, int num_threads) {
+	(void)num_threads;
+	sequential_fast_application(input_image, output_image, width, height, filter);
+	return 0;
+}
+
+/**
+ * Returns the function applying a filter to a whole image in the given mode, or
+ * `NULL` if the mode is unknown.
+ */
+static chain_pass_fn mode_pass(const char *mode) {
+	if (strcmp(mode, "row") == 0) {
+		return parallel_row;
+	} else if (strcmp(mode, "column") == 0) {
+		return parallel_column;
+	} else if (strcmp(mode, "block") == 0) {
+		return block_pass;
+	} else if (strcmp(mode, "pixel") == 0) {
+		return parallel_pixel;
+	} else if (strcmp(mode, "tile") == 0) {
+		return tile_pass;
+	} else if (strcmp(mode, "seq") == 0) {
+		return sequential_pass;
+	} else if (strcmp(mode, "seq-fast") == 0) {
+		return sequential_fast_pass;
+	} else if (strcmp(mode, "stream") == 0) {
+		return stream_application;
+	}
+
+	return NULL;
+}
+
+/**
+ * Computes the size of the blocks the parallel mode (or `seq-fast`, which applies
+ * the filter to the whole image at once) splits the image into.
+ */
+static void mode_block_size(const char *mode, const struct filter *filter,
+							int width, int height, int num_threads,
+							int *block_width, int *block_height) {
+	*block_width = width;
+	*block_height = height;
+
+	if (strcmp(mode, "row") == 0) {
+		*block_height = 1;
+	} else if (strcmp(mode, "column") == 0) {
+		*block_width = 1;
+	} else if (strcmp(mode, "pixel") == 0) {
+		*block_width = 1;
+		*block_height = 1;
+	} else if (strcmp(mode, "block") == 0 && requested_block_width > 0) {
+		*block_width = min(requested_block_width, width);
+		*block_height = min(requested_block_height, height);
+	} else if (strcmp(mode, "block") == 0) {
+		*block_width = (width + num_threads - 1) / num_threads;
+		*block_height = (height + num_threads - 1) / num_threads;
+	} else if (strcmp(mode, "tile") == 0) {
+		chain_tile_size(filter, 1, width, block_width, block_height);
+		if (requested_tile_width > 0) {
+			*block_width = min(requested_tile_width, width);
+			*block_height = min(requested_tile_height, height);
+		}
+	} else if (strcmp(mode, "stream") == 0) {
+		*block_height = min(stream_strip_rows(filter), height);
+	}
+}
+
+/**
+ * Prints the scheduling policy of the parallel modes and the size of its chunks for
+ * an image of `num_units` work units, e.g. `Schedule: dynamic, 1 unit(s) per
+ * claim`.
+ */
+static void print_schedule(const program_args *args, int num_units) {
+	int chunk_size = schedule_chunk_size(args->schedule, args->chunk_size,
+										 num_units, args->threads_num);
+	const char *name = schedule_policy_name(args->schedule);
+
+	switch (args->schedule) {
+		case SCHEDULE_STATIC:
+			printf("Schedule: %s, %d units per thread\n", name,
+				   (num_units + args->threads_num - 1) / args->threads_num);
+			break;
+		case SCHEDULE_DYNAMIC:
+			printf("Schedule: %s, %d unit(s) per claim\n", name, chunk_size);
+			break;
+		case SCHEDULE_GUIDED:
+			printf("Schedule: %s, at least %d unit(s) per claim\n", name,
+				   chunk_size);
+			break;
+		default:
+			printf("Schedule: %s, %d unit(s) per chunk\n", name, chunk_size);
+			break;
+	}
+}
+
+/**
+ * Prints the placement of the threads of the parallel modes, e.g.
+ * `Affinity: compact, threads on CPUs 0 1 2 3`.
+ */
+static void print_affinity(const program_args *args) {
+	printf("Affinity: %s", affinity_policy_name(args->affinity));
+
+	if (thread_pool_cpu(0) < 0) {
+		printf(", threads not pinned\n");
+		return;
+	}
+
+	printf(", threads on CPUs");
+	for (int i = 0; i < args->threads_num; i++) {
+		printf(" %d", thread_pool_cpu(i));
+	}
+	printf("\n");
+}
+
 /**
- * Loads the input image, applies the specified filter using the selected execution
- * mode, and saves the resulting image.
+ * Replaces `--mode=auto` with the mode, number of threads and blocks the autotuner
+ * finds fastest on this machine (see `autotune()`) for the most costly filter of
+ * the chain, and prints them, e.g.
+ * `Autotune: block 64x64, 4 thread(s), ... (from profile '...')`.
  */
-static int default_mode(program_args args, struct filter image_filter) {
+static int tune_mode(program_args *args, const struct filter *filters,
+					 int num_filters, int width, int height) {
+	const struct filter *filter = &filters[0];
+	for (int i = 1; i < num_filters; i++) {
+		if (estimate_filter_cost(&filters[i], width, height) >
+			estimate_filter_cost(filter, width, height)) {
+			filter = &filters[i];
+		}
+	}
+
+	int max_threads = args->threads_num;
+	if (max_threads == 0) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		max_threads = (int)min(max(cpus, 1), THREAD_POOL_MAX_WORKERS + 1);
+	}
+
+	char default_profile[MAX_PATH_LEN];
+	const char *profile = args->profile_path;
+	if (profile == NULL &&
+		autotune_default_profile(default_profile, sizeof(default_profile)) == 0) {
+		profile = default_profile;
+	}
+
+	struct autotune_config config;
+	bool cached;
+	if (autotune(profile, filter, width, height, max_threads, &config, &cached) !=
+		0) {
+		error("Failed to tune the parallel modes.\n");
+		return -1;
+	}
+
+	args->mode = config.mode;
+	args->threads_num = config.num_threads;
+	requested_block_width = config.block_width;
+	requested_block_height = config.block_height;
+
+	printf("Autotune: %s", config.mode);
+	if (config.block_width > 0) {
+		printf(" %dx%d", config.block_width, config.block_height);
+	}
+	printf(", %d thread(s), %.6f s on a synthetic image", config.num_threads,
+		   config.seconds);
+	if (profile == NULL) {
+		printf(" (tuned, no profile)\n");
+	} else {
+		printf(" (%s profile '%s')\n", cached ? "from" : "tuned,", profile);
+	}
+
+	return 0;
+}
+
+/**
+ * Loads the input image, applies the specified filters using the selected execution
+ * mode, and saves the resulting image. A chain of several filters is applied as
+ * planned by `plan_chain()`, with separate passes only in the reference mode. The
+ * stream mode filters the loaded image in place, one filter after another, so it
+ * allocates no other image.
+ */
+static int default_mode(program_args args, const struct filter *filters,
+						char *const *names, int num_filters) {
 	int width, height, channels;
 	unsigned char *image = NULL;
-	struct image_rgb channel_image = {NULL, NULL, NULL};
-	struct image_rgb result_channel_image = {NULL, NULL, NULL};
+	struct image_rgb channel_image = {NULL, NULL, NULL, 0, 0, NULL};
+	struct image_rgb result_channel_image = {NULL, NULL, NULL, 0, 0, NULL};
 	unsigned char *result_image = NULL;
 	char *output_file_path = NULL;
 
@@ -31,21 +249,102 @@ static int default_mode(program_args args, struct filter image_filter) {
 		goto cleanup_and_err;
 	}
 
-	// Initialize RGB channels
-	channel_image = initialize_image_rgb(width, height);
-	if (channel_image.red == NULL || channel_image.green == NULL ||
-		channel_image.blue == NULL) {
-		error("Memory allocation error for channel_image.\n");
+	// The output keeps the name of the requested mode
+	const char *mode_name = args.mode;
+	if (strcmp(args.mode, "auto") == 0 &&
+		tune_mode(&args, filters, num_filters, width, height) != 0) {
+		goto cleanup_and_err;
+	}
+	if (strcmp(args.mode, "seq") != 0 && strcmp(args.mode, "seq-fast") != 0) {
+		print_affinity(&args);
+	}
+
+	// The tile and stream modes read and write interleaved pixels, deinterleaving
+	// tile by tile or row by row; the other modes filter planes split from the image
+	bool streaming = strcmp(args.mode, "stream") == 0;
+	bool interleaved = strcmp(args.mode, "tile") == 0 || streaming;
+
+	if (!streaming) {
+		result_image = malloc((size_t)width * (size_t)height * 3);
+		if (!result_image) {
+			error("Memory allocation error for result_image.\n");
+			goto cleanup_and_err;
+		}
+	}
+
+	if (!interleaved) {
+		// The halos of the channels hold the border for every filter of the chain
+		int halo = 0;
+		for (int i = 0; i < num_filters; i++) {
+			halo = max(halo, filters[i].size / 2);
+		}
+
+		// Initialize RGB channels
+		channel_image = initialize_padded_image_rgb(width, height, halo);
+		if (channel_image.red == NULL || channel_image.green == NULL ||
+			channel_image.blue == NULL) {
+			error("Memory allocation error for channel_image.\n");
+			goto cleanup_and_err;
+		}
+
+		if (parallel_split(image, &channel_image, width, height,
+						   args.threads_num) != 0) {
+			goto cleanup_and_err;
+		}
+
+		// Initialize result channels
+		result_channel_image = initialize_padded_image_rgb(width, height, halo);
+		if (result_channel_image.red == NULL ||
+			result_channel_image.green == NULL ||
+			result_channel_image.blue == NULL) {
+			error("Memory allocation error for result_channel_image.\n");
+			goto cleanup_and_err;
+		}
+
+		// The pages of the output are placed with the threads that write them
+		if (args.affinity != AFFINITY_NONE &&
+			parallel_first_touch(&result_channel_image, width, height,
+								 args.threads_num) != 0) {
+			goto cleanup_and_err;
+		}
+	}
+
+	chain_pass_fn pass = mode_pass(args.mode);
+	if (pass == NULL) {
+		error("Unknown mode name: %s\n", args.mode);
 		goto cleanup_and_err;
 	}
 
-	split_image_into_rgb_channels(image, channel_image, width, height);
+	// The reference mode ignores the engines
+	if (strcmp(args.mode, "seq") != 0) {
+		for (int i = 0; i < num_filters; i++) {
+			int block_width, block_height;
+			mode_block_size(args.mode, &filters[i], width, height, args.threads_num,
+							&block_width, &block_height);
+			print_dispatch(names[i], &filters[i], block_width, block_height);
+		}
+	}
 
-	// Initialize result channels
-	result_channel_image = initialize_image_rgb(width, height);
-	if (result_channel_image.red == NULL || result_channel_image.green == NULL ||
-		result_channel_image.blue == NULL) {
-		error("Memory allocation error for result_channel_image.\n");
+	if (pass == parallel_pixel || pass == parallel_row || pass == parallel_column ||
+		pass == block_pass) {
+		int block_width, block_height;
+		mode_block_size(args.mode, &filters[0], width, height, args.threads_num,
+						&block_width, &block_height);
+		print_schedule(&args, parallel_num_units(width, height, block_width,
+												 block_height));
+	}
+
+	struct chain_plan plan;
+	if (num_filters > 1 && !streaming) {
+		if (plan_chain(filters, num_filters, width, height,
+					   strcmp(args.mode, "seq") == 0, &plan) != 0) {
+			goto cleanup_and_err;
+		}
+		print_chain_plan(names, &plan);
+	}
+
+	// The workers of the pool are started before the convolution is timed
+	if (thread_pool_reserve(args.threads_num - 1) != 0) {
 		goto cleanup_and_err;
 	}
 
@@ -57,24 +356,26 @@ static int default_mode(program_args args, struct filter image_filter) {
 	}
 
 	int return_value = 0;
-	if (strcmp(args.mode, "row") == 0) {
-		return_value = parallel_row(&channel_image, &result_channel_image, width,
-									height, image_filter, args.threads_num);
-	} else if (strcmp(args.mode, "column") == 0) {
-		return_value = parallel_column(&channel_image, &result_channel_image, width,
-									   height, image_filter, args.threads_num);
-	} else if (strcmp(args.mode, "block") == 0) {
-		return_value = parallel_block(&channel_image, &result_channel_image, width,
-									  height, image_filter, args.threads_num);
-	} else if (strcmp(args.mode, "pixel") == 0) {
-		return_value = parallel_pixel(&channel_image, &result_channel_image, width,
-									  height, image_filter, args.threads_num);
-	} else if (strcmp(args.mode, "seq") == 0) {
-		sequential_application(&channel_image, &result_channel_image, width, height,
-							   image_filter);
+	if (streaming) {
+		for (int i = 0; i < num_filters && return_value == 0; i++) {
+			return_value = stream_application_interleaved(
+				image, image, width, height, filters[i], args.threads_num);
+		}
+	} else if (interleaved && num_filters > 1) {
+		return_value = apply_chain_plan_interleaved(image, result_image, width,
+													height, filters, &plan,
+													args.threads_num);
+	} else if (interleaved) {
+		return_value = chain_application_interleaved(
+			image, result_image, width, height, filters, 1, requested_tile_width,
+			requested_tile_height, args.threads_num);
+	} else if (num_filters > 1) {
+		return_value =
+			apply_chain_plan(&channel_image, &result_channel_image, width, height,
+							 filters, &plan, pass, args.threads_num);
 	} else {
-		error("Unknown mode name: %s\n", args.mode);
-		goto cleanup_and_err;
+		return_value = pass(&channel_image, &result_channel_image, width, height,
+							filters[0], args.threads_num);
 	}
 
 	double end_time = get_time_in_seconds();
@@ -84,33 +385,30 @@ static int default_mode(program_args args, struct filter image_filter) {
 	}
 
 	if (return_value != 0) {
-		error("Failed to create thread.\n");
+		error("Failed to apply the filter.\n");
 		goto cleanup_and_err;
 	}
 
 	// Assemble and save result
-	result_image = malloc((size_t)width * (size_t)height * 3);
-	if (!result_image) {
-		error("Memory allocation error for result_image.\n");
+	if (!interleaved && parallel_assemble(result_image, &result_channel_image, width,
+										  height, args.threads_num) != 0) {
 		goto cleanup_and_err;
 	}
 
-	assemble_image_from_rgb_channels(result_image, result_channel_image, width,
-									 height);
-
 	const char *file_name = extract_filename(args.img_path);
 	output_file_path =
 		malloc(PATH_PREFIX_LEN + UNDERSCORE_COUNT + strlen(file_name) +
-			   strlen(args.mode) + strlen(args.filter_name) + NULL_TERMINATOR_LEN);
+			   strlen(mode_name) + strlen(args.filter_name) + NULL_TERMINATOR_LEN);
 	if (!output_file_path) {
 		error("Memory allocation error for output_file_path.\n");
 		goto cleanup_and_err;
 	}
 
-	sprintf(output_file_path, "images/%s_%s_%s", args.filter_name, args.mode,
+	sprintf(output_file_path, "images/%s_%s_%s", args.filter_name, mode_name,
 			file_name);
 
-	stbi_write_bmp(output_file_path, width, height, 3, result_image);
+	stbi_write_bmp(output_file_path, width, height, 3,
+				   streaming ? image : result_image);
 
 	printf("The convolution took %.6f. The final image is located at '%s'\n",
 		   (end_time - start_time), output_file_path);
@@ -173,6 +471,11 @@ static int queue_mode(program_args args, struct filter image_filter) {
 		.output_q = &output_queue,
 	};
 
+	// The workers of all the images share one pool, started once
+	if (thread_pool_reserve(args.threads_num - 1) != 0) {
+		goto cleanup_and_err;
+	}
+
 	double start_time = get_time_in_seconds();
 	if (start_time == -1) {
 		error("Error in clock_gettime().\n");
@@ -209,68 +512,172 @@ cleanup_and_err:
 }
 
 /**
- * Parses command-line arguments, loads the requested filter, and runs the
- * convolution either in default mode or queue mode based on user input.
+ * Creates the filter with the given name (one of `filters_info`), using the filter
+ * parameters of the command line. Returns a filter with a `NULL` kernel if the name
+ * is unknown or memory allocation fails.
  */
-int main(int argc, char *argv[]) {
-	program_args args = {NULL, NULL, NULL, 1, 0, 0, 0, 0, 0};
-	if (!parse_args(argc, argv, &args)) {
-		return -1;
-	}
-
-	// Create filter
-	struct filter image_filter = {0, 0, 0, NULL};
+static struct filter create_named_filter(const char *name, program_args args) {
+	struct filter image_filter = {.kernel = NULL};
 
-	if (strcmp(args.filter_name, "id") == 0) {
+	if (strcmp(name, "id") == 0) {
 		image_filter = create_filter(ID_SIZE, ID_FACTOR, ID_BIAS, id);
-	} else if (strcmp(args.filter_name, "fbl") == 0) {
+	} else if (strcmp(name, "fbl") == 0) {
 		image_filter = create_filter(FAST_BLUR_SIZE, FAST_BLUR_FACTOR,
 									 FAST_BLUR_BIAS, fast_blur);
-	} else if (strcmp(args.filter_name, "bl") == 0) {
+	} else if (strcmp(name, "bl") == 0) {
 		image_filter = create_filter(BLUR_SIZE, BLUR_FACTOR, BLUR_BIAS, blur);
-	} else if (strcmp(args.filter_name, "gbl") == 0) {
+	} else if (strcmp(name, "gbl") == 0) {
 		image_filter = create_filter(GAUS_BLUR_SIZE, GAUS_BLUR_FACTOR,
 									 GAUS_BLUR_BIAS, gaus_blur);
-	} else if (strcmp(args.filter_name, "mbl") == 0) {
+	} else if (strcmp(name, "mbl") == 0) {
 		image_filter = create_filter(MOTION_BLUR_SIZE, MOTION_BLUR_FACTOR,
 									 MOTION_BLUR_BIAS, motion_blur);
-	} else if (strcmp(args.filter_name, "ed") == 0) {
+	} else if (strcmp(name, "ed") == 0) {
 		image_filter = create_filter(EDGE_DETECTION_SIZE, EDGE_DETECTION_FACTOR,
 									 EDGE_DETECTION_BIAS, edge_detection);
-	} else if (strcmp(args.filter_name, "em") == 0) {
+	} else if (strcmp(name, "em") == 0) {
 		image_filter =
 			create_filter(EMBOSS_SIZE, EMBOSS_FACTOR, EMBOSS_BIAS, emboss);
-	} else if (strcmp(args.filter_name, "bl+gbl") == 0) {
-		image_filter = compose_filters_from_params(
-			BLUR_SIZE, BLUR_FACTOR, BLUR_BIAS, blur, GAUS_BLUR_SIZE,
-			GAUS_BLUR_FACTOR, GAUS_BLUR_BIAS, gaus_blur);
-	} else if (strcmp(args.filter_name, "fbl+mbl") == 0) {
-		image_filter = compose_filters_from_params(
-			FAST_BLUR_SIZE, FAST_BLUR_FACTOR, FAST_BLUR_BIAS, fast_blur,
-			MOTION_BLUR_SIZE, MOTION_BLUR_FACTOR, MOTION_BLUR_BIAS, motion_blur);
+	} else if (strcmp(name, "box") == 0) {
+		image_filter = create_box_filter(args.radius);
+	} else if (strcmp(name, "motion") == 0) {
+		image_filter = create_motion_blur_filter(args.length, args.angle);
 	} else {
-		error("Unknown filter name: %s\n", args.filter_name);
-		if (image_filter.kernel != NULL) {
-			free_filter(&image_filter);
-		}
+		error("Unknown filter name: %s\n", name);
+		return image_filter;
 	}
 
 	if (image_filter.kernel == NULL) {
 		error("Memory allocation error for filter.\n");
+		return image_filter;
+	}
+
+	image_filter.engine = args.engine;
+	image_filter.border = args.border;
+	if (!engine_applies(&image_filter, args.engine)) {
+		error("The %s engine cannot apply the filter %s.\n",
+			  filter_engine_name(args.engine), name);
+		free_filter(&image_filter);
+		image_filter.kernel = NULL;
+	}
+
+	return image_filter;
+}
+
+/**
+ * Composes a chain of filters into a single one for the queue mode, which applies
+ * one filter per image.
+ */
+static struct filter compose_chain(const struct filter *filters, int num_filters) {
+	struct filter composed = filters[0];
+
+	for (int i = 1; i < num_filters; i++) {
+		struct filter next = compose_filters(&composed, &filters[i]);
+
+		if (i > 1) {
+			free_filter(&composed);
+		}
+		if (next.kernel == NULL) {
+			error("Memory allocation error for filter.\n");
+			return next;
+		}
+
+		composed = next;
+	}
+
+	composed.engine = filters[0].engine;
+	composed.border = filters[0].border;
+	return composed;
+}
+
+/**
+ * Parses command-line arguments, loads the requested filters, and runs the
+ * convolution either in default mode or queue mode based on user input. The filter
+ * name may be a chain of names joined by `+` (e.g. `bl+gbl+ed`).
+ */
+int main(int argc, char *argv[]) {
+	program_args args = {NULL, NULL, NULL, 1, 0, 0, 0, 0, 0, FILTER_ENGINE_AUTO,
+						 BOX_BLUR_RADIUS, MOTION_BLUR_LENGTH, MOTION_BLUR_ANGLE,
+						 0, 0, SCHEDULE_DYNAMIC, 0, AFFINITY_NONE, NULL,
+						 BORDER_WRAP};
+	if (!parse_args(argc, argv, &args)) {
+		return -1;
+	}
+
+	requested_tile_width = args.tile_width;
+	requested_tile_height = args.tile_height;
+	set_parallel_schedule(args.schedule, args.chunk_size);
+
+	// Split the chain into the names of its filters
+	char *chain = strdup(args.filter_name);
+	if (chain == NULL) {
+		error("Memory allocation error for filter name.\n");
 		return -1;
 	}
 
-	if (strcmp(args.mode, "queue") == 0) {
-		if (queue_mode(args, image_filter) != 0) {
+	char *names[CHAIN_MAX_FILTERS];
+	int num_filters = 0;
+	for (char *name = strtok(chain, "+"); name != NULL; name = strtok(NULL, "+")) {
+		if (num_filters == CHAIN_MAX_FILTERS) {
+			error("A chain has at most %d filters.\n", CHAIN_MAX_FILTERS);
+			free(chain);
 			return -1;
 		}
-	} else {
-		if (default_mode(args, image_filter) != 0) {
-			return -1;
+		names[num_filters++] = name;
+	}
+
+	if (num_filters == 0) {
+		error("Unknown filter name: %s\n", args.filter_name);
+	}
+
+	// Create filters
+	struct filter filters[CHAIN_MAX_FILTERS];
+	int created = 0;
+
+	while (created < num_filters) {
+		filters[created] = create_named_filter(names[created], args);
+		if (filters[created].kernel == NULL) {
+			break;
 		}
+		created++;
 	}
 
-	free_filter(&image_filter);
+	int status = num_filters > 0 && created == num_filters ? 0 : -1;
 
-	return 0;
+	// The composed kernel of a chain reads the border around the input of the chain
+	// only, which equals applying its filters in turn with wrapping borders only
+	if (status == 0 && strcmp(args.mode, "queue") == 0 && num_filters > 1 &&
+		args.border != BORDER_WRAP) {
+		error("The queue mode applies chains with --border=wrap only.\n");
+		status = -1;
+	}
+
+	if (status == 0 && args.affinity != AFFINITY_NONE &&
+		thread_pool_set_affinity(args.affinity) != 0) {
+		status = -1;
+	}
+	if (status == 0 && strcmp(args.mode, "queue") == 0) {
+		print_affinity(&args);
+	}
+
+	if (status == 0 && strcmp(args.mode, "queue") == 0) {
+		struct filter image_filter = compose_chain(filters, num_filters);
+
+		if (image_filter.kernel == NULL || queue_mode(args, image_filter) != 0) {
+			status = -1;
+		}
+		if (num_filters > 1 && image_filter.kernel != NULL) {
+			free_filter(&image_filter);
+		}
+	} else if (status == 0) {
+		status = default_mode(args, filters, names, num_filters);
+	}
+
+	for (int i = 0; i < created; i++) {
+		free_filter(&filters[i]);
+	}
+	free(chain);
+	thread_pool_shutdown();
+
+	return status;
 }
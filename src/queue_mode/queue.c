@@ -34,7 +34,7 @@ void queue_destroy(struct img_queue *img_q) {
 	while (current) {
 		img_info_node_t *next = current->next;
 
-		free_image_rgb(&current->image);
+		stbi_image_free(current->pixels);
 		free(current);
 
 		current = next;
@@ -46,7 +46,7 @@ void queue_destroy(struct img_queue *img_q) {
 	pthread_cond_destroy(&img_q->cond_not_empty);
 }
 
-int queue_push(img_queue *img_q, struct image_rgb img, int width, int height,
+int queue_push(img_queue *img_q, unsigned char *pixels, int width, int height,
 			   char *filename) {
 	pthread_mutex_lock(&img_q->push_mutex);
 
@@ -63,35 +63,19 @@ int queue_push(img_queue *img_q, struct image_rgb img, int width, int height,
 		return -1;
 	}
 
-	node->image = img;
+	node->pixels = pixels;
 	node->filename = filename;
 	node->next = NULL;
 
-	// Load and split image
+	// Load image, kept interleaved for the worker to deinterleave tile by tile
 	if (img_q->input_queue && filename) {
 		int channels;
-		unsigned char *image_data =
-			stbi_load(filename, &width, &height, &channels, 3);
-		if (!image_data) {
+		node->pixels = stbi_load(filename, &width, &height, &channels, 3);
+		if (!node->pixels) {
 			error("Failed to load image: %s\n", filename);
 			free(node);
 			return -1;
 		}
-
-		// Initialize RGB channels
-		struct image_rgb channel_image = initialize_image_rgb(width, height);
-		if (channel_image.red == NULL || channel_image.green == NULL ||
-			channel_image.blue == NULL) {
-			error("Failed to initialize image rgb for %s.\n", filename);
-			free(node);
-			stbi_image_free(image_data);
-			return -1;
-		}
-
-		split_image_into_rgb_channels(image_data, channel_image, width, height);
-
-		node->image = channel_image;
-		stbi_image_free(image_data);
 	}
 
 	node->width = width;
@@ -12,14 +12,15 @@
 /**
  * Stores image data, metadata and pointer to next node in the linked list.
  *
- * @param image RGB channels of the image (`struct image_rgb`).
+ * @param pixels Interleaved (`RGBRGB...`) pixels of the image, as stb_image loads
+ * and writes them.
  * @param filename Name of the source file (or NULL for termination signal).
  * @param width Width of the image.
  * @param height Height of the image.
  * @param next Pointer to the next node in the queue.
  */
 typedef struct queue_img_info {
-	struct image_rgb image;
+	unsigned char *pixels;
 	char *filename;
 	int width;
 	int height;
@@ -72,12 +73,12 @@ int queue_init(struct img_queue *img_q, size_t max_mem, bool input_queue);
 void queue_destroy(struct img_queue *img_q);
 
 /**
- * Creates and pushes an `img_info_node_t` to the queue, downloading and splitting
- * image data if it is an input queue. Blocks the thread if the queue's memory usage
+ * Creates and pushes an `img_info_node_t` to the queue, loading the image data if
+ * it is an input queue. Blocks the thread if the queue's memory usage
  * exceeds the limit until space becomes available.
  *
  * @param img_q Pointer to the queue.
- * @param img RGB image data to enqueue (`struct image_rgb`).
+ * @param pixels Interleaved pixels to enqueue, `NULL` if it is an input queue.
  * @param width Width of the image.
  * @param height Height of the image.
  * @param filename Path to image file or NULL for termination signal.
@@ -85,8 +86,8 @@ void queue_destroy(struct img_queue *img_q);
  * @return `0` on success, `-1` on memory allocation failure or image load
  * error.
  */
-int queue_push(struct img_queue *img_q, struct image_rgb img, int width, int height,
-			   char *filename);
+int queue_push(struct img_queue *img_q, unsigned char *pixels, int width,
+			   int height, char *filename);
 
 /**
  * Removes `img_info_node_t` from the queue. Blocks the thread if the queue is empty
@@ -11,7 +11,6 @@ atomic_bool output_termination_sent =
 void *reader_thread(void *arg) {
 	qthreads_info *info = (qthreads_info *)arg;
 
-	struct image_rgb dummy_img = {NULL, NULL, NULL};
 	int width, height, channels;
 	double start_time, end_time;
 	size_t index;
@@ -41,7 +40,7 @@ void *reader_thread(void *arg) {
 			continue;
 		}
 
-		if (queue_push(info->input_q, dummy_img, width, height, path) != 0) {
+		if (queue_push(info->input_q, NULL, width, height, path) != 0) {
 			error("READER: Failed to push '%s' into input queue.\n", path);
 			continue;
 		}
@@ -60,7 +59,7 @@ void *reader_thread(void *arg) {
 	if (atomic_load(&finished_reader_threads) == info->pargs->readers_num &&
 		!atomic_exchange(&input_termination_sent, true)) {
 		for (uint8_t i = 0; i < info->pargs->workers_num; i++) {
-			queue_push(info->input_q, dummy_img, 0, 0, NULL);
+			queue_push(info->input_q, NULL, 0, 0, NULL);
 		}
 	}
 
@@ -89,24 +88,34 @@ void *worker_thread(void *arg) {
 			break;
 		}
 
-		struct image_rgb result_channel_image =
-			initialize_image_rgb(out_node->width, out_node->height);
-		if (!result_channel_image.red || !result_channel_image.green ||
-			!result_channel_image.blue) {
-			error("WORKER: Memory allocation error for result_channel_image.\n");
-			free_image_rgb(&out_node->image);
+		unsigned char *result_image =
+			malloc((size_t)out_node->width * (size_t)out_node->height * 3);
+		if (!result_image) {
+			error("WORKER: Memory allocation error for result_image.\n");
+			stbi_image_free(out_node->pixels);
 			free(out_node);
 			continue;
 		}
 
-		parallel_row(&out_node->image, &result_channel_image, out_node->width,
-					 out_node->height, *info->img_filter, info->pargs->threads_num);
+		// The tiles are deinterleaved into the scratch buffers of the threads, so
+		// the image is never split into channels
+		if (chain_application_interleaved(out_node->pixels, result_image,
+										  out_node->width, out_node->height,
+										  info->img_filter, 1, 0, 0,
+										  info->pargs->threads_num) != 0) {
+			error("WORKER: Failed to apply the filter to '%s'.\n",
+				  out_node->filename);
+			stbi_image_free(out_node->pixels);
+			free(result_image);
+			free(out_node);
+			continue;
+		}
 
-		if (queue_push(info->output_q, result_channel_image, out_node->width,
+		if (queue_push(info->output_q, result_image, out_node->width,
 					   out_node->height, out_node->filename) != 0) {
 			error("WORKER: Failed to push processed image to output queue.\n");
-			free_image_rgb(&out_node->image);
-			free_image_rgb(&result_channel_image);
+			stbi_image_free(out_node->pixels);
+			free(result_image);
 			free(out_node);
 			break;
 		}
@@ -114,24 +123,23 @@ void *worker_thread(void *arg) {
 		end_time = get_time_in_seconds();
 		if (end_time == -1) {
 			error("Error in clock_gettime().\n");
-			free_image_rgb(&out_node->image);
+			stbi_image_free(out_node->pixels);
 			free(out_node);
 			break;
 		}
 		printf("WORKER: '%s' -> output queue in %.6f.\n", out_node->filename,
 			   end_time - start_time);
 
-		free_image_rgb(&out_node->image);
+		stbi_image_free(out_node->pixels);
 		free(out_node);
 	}
 	atomic_fetch_add(&finished_worker_threads, 1);
 
 	// Sending termination signals by the last thread
-	struct image_rgb dummy_img = {NULL, NULL, NULL};
 	if (atomic_load(&finished_worker_threads) == info->pargs->workers_num &&
 		!atomic_exchange(&output_termination_sent, true)) {
 		for (uint8_t i = 0; i < info->pargs->writers_num; i++) {
-			queue_push(info->output_q, dummy_img, 0, 0, NULL);
+			queue_push(info->output_q, NULL, 0, 0, NULL);
 		}
 	}
 
@@ -160,27 +168,14 @@ void *writer_thread(void *arg) {
 			break;
 		}
 
-		unsigned char *result_image =
-			malloc((size_t)out_node->width * (size_t)out_node->height * 3);
-		if (!result_image) {
-			error("WRITER: Memory allocation failed for output image\n");
-			free_image_rgb(&out_node->image);
-			free(out_node);
-			break;
-		}
-
-		assemble_image_from_rgb_channels(result_image, out_node->image,
-										 out_node->width, out_node->height);
-
 		char out_path[MAX_PATH_LEN];
 		snprintf(out_path, sizeof(out_path), "%s/%s", QUEUE_DIR_NAME,
 				 extract_filename(out_node->filename));
 
 		if (!stbi_write_bmp(out_path, out_node->width, out_node->height, 3,
-							result_image)) {
+							out_node->pixels)) {
 			error("WRITER: Failed to save image '%s'\n", out_path);
-			free(result_image);
-			free_image_rgb(&out_node->image);
+			free(out_node->pixels);
 			free(out_node);
 			continue;
 		}
@@ -188,16 +183,14 @@ void *writer_thread(void *arg) {
 		end_time = get_time_in_seconds();
 		if (end_time == -1) {
 			error("Error in clock_gettime().\n");
-			free(result_image);
-			free_image_rgb(&out_node->image);
+			free(out_node->pixels);
 			free(out_node);
 			break;
 		}
 		printf("WRITER: '%s' -> saved in %.6f.\n", out_node->filename,
 			   end_time - start_time);
 
-		free(result_image);
-		free_image_rgb(&out_node->image);
+		free(out_node->pixels);
 		free(out_node);
 	}
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../convolution/chain.h"
 #include "../convolution/parallel_dispatch.h"
 #include "../utils/args.h"
 #include "queue.h"
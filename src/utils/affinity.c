@@ -0,0 +1,170 @@
+#define _GNU_SOURCE // sched_getaffinity(), pthread_setaffinity_np()
+
+#include "affinity.h"
+#include "utils.h"
+
+#include <sched.h>
+
+#define TOPOLOGY_SYSFS_DIR "/sys/devices/system/cpu"
+
+// CPUs the process could run on before any thread was pinned
+static cpu_set_t process_cpus;
+static bool process_cpus_known;
+static pthread_once_t process_cpus_once = PTHREAD_ONCE_INIT;
+
+static void detect_process_cpus(void) {
+	process_cpus_known =
+		sched_getaffinity(0, sizeof(process_cpus), &process_cpus) == 0;
+}
+
+/**
+ * Location of a CPU in the machine.
+ *
+ * @param cpu Number of the CPU.
+ * @param package Physical package (socket) of the CPU.
+ * @param core_id Identifier of the core of the CPU.
+ * @param core Rank of the core of the CPU within its package.
+ * @param sibling Rank of the CPU among the hardware threads of its core.
+ */
+struct cpu_location {
+	int cpu;
+	int package;
+	int core_id;
+	int core;
+	int sibling;
+};
+
+static const char *const affinity_names[] = {
+	[AFFINITY_NONE] = "none",
+	[AFFINITY_COMPACT] = "compact",
+	[AFFINITY_SCATTER] = "scatter",
+};
+
+const char *affinity_policy_name(enum affinity_policy policy) {
+	return affinity_names[policy];
+}
+
+bool parse_affinity_policy(const char *name, enum affinity_policy *policy) {
+	for (int i = 0; i < NUM_AFFINITY_POLICIES; i++) {
+		if (strcmp(name, affinity_names[i]) == 0) {
+			*policy = (enum affinity_policy)i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// Reads a topology attribute of a CPU (e.g. `core_id`), or returns `fallback`
+static int read_topology_id(int cpu, const char *name, int fallback) {
+	char path[128];
+	snprintf(path, sizeof(path), TOPOLOGY_SYSFS_DIR "/cpu%d/topology/%s", cpu, name);
+
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		return fallback;
+	}
+
+	int id;
+	if (fscanf(file, "%d", &id) != 1) {
+		id = fallback;
+	}
+	fclose(file);
+
+	return id;
+}
+
+// Orders CPUs by package, core id and number, so that siblings are adjacent
+static int compare_compact(const void *a, const void *b) {
+	const struct cpu_location *x = a, *y = b;
+
+	if (x->package != y->package) {
+		return x->package - y->package;
+	}
+	if (x->core_id != y->core_id) {
+		return x->core_id - y->core_id;
+	}
+	return x->cpu - y->cpu;
+}
+
+// Orders CPUs by sibling rank, core rank and package, so that packages alternate
+static int compare_scatter(const void *a, const void *b) {
+	const struct cpu_location *x = a, *y = b;
+
+	if (x->sibling != y->sibling) {
+		return x->sibling - y->sibling;
+	}
+	if (x->core != y->core) {
+		return x->core - y->core;
+	}
+	if (x->package != y->package) {
+		return x->package - y->package;
+	}
+	return x->cpu - y->cpu;
+}
+
+int affinity_cpu_order(enum affinity_policy policy, int *cpus, int max_cpus) {
+	pthread_once(&process_cpus_once, detect_process_cpus);
+	if (!process_cpus_known) {
+		return 0;
+	}
+
+	struct cpu_location locations[AFFINITY_MAX_CPUS];
+	int count = 0;
+
+	for (int cpu = 0; cpu < CPU_SETSIZE && count < AFFINITY_MAX_CPUS; cpu++) {
+		if (CPU_ISSET(cpu, &process_cpus)) {
+			locations[count++] = (struct cpu_location){
+				.cpu = cpu,
+				.package = read_topology_id(cpu, "physical_package_id", 0),
+				.core_id = read_topology_id(cpu, "core_id", cpu),
+			};
+		}
+	}
+
+	// Ranks the cores within their package and the siblings within their core
+	qsort(locations, count, sizeof(struct cpu_location), compare_compact);
+	for (int i = 0; i < count; i++) {
+		struct cpu_location *location = &locations[i];
+		const struct cpu_location *previous = i > 0 ? &locations[i - 1] : NULL;
+
+		if (previous == NULL || location->package != previous->package) {
+			location->core = 0;
+		} else if (location->core_id == previous->core_id) {
+			location->core = previous->core;
+			location->sibling = previous->sibling + 1;
+		} else {
+			location->core = previous->core + 1;
+		}
+	}
+
+	if (policy == AFFINITY_SCATTER) {
+		qsort(locations, count, sizeof(struct cpu_location), compare_scatter);
+	}
+
+	count = min(count, max_cpus);
+	for (int i = 0; i < count; i++) {
+		cpus[i] = locations[i].cpu;
+	}
+
+	return count;
+}
+
+int pin_thread(pthread_t thread, int cpu) {
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+
+	return pthread_setaffinity_np(thread, sizeof(set), &set) == 0 ? 0 : -1;
+}
+
+int unpin_thread(pthread_t thread) {
+	pthread_once(&process_cpus_once, detect_process_cpus);
+	if (!process_cpus_known) {
+		return -1;
+	}
+
+	return pthread_setaffinity_np(thread, sizeof(process_cpus), &process_cpus) == 0
+			   ? 0
+			   : -1;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#define AFFINITY_MAX_CPUS 1024 // Most CPUs threads are placed on
+
+/**
+ * Policies placing the threads of the pool on the CPUs the process may run on.
+ *
+ * - `AFFINITY_NONE`: the threads are not pinned, the scheduler moves them freely.
+ * - `AFFINITY_COMPACT`: consecutive threads are pinned as close as possible, to
+ * the hardware threads of one core, then to the cores of one package.
+ * - `AFFINITY_SCATTER`: consecutive threads are pinned as far apart as possible, to
+ * the packages in turn, then to cores without a busy hardware thread.
+ */
+enum affinity_policy {
+	AFFINITY_NONE,
+	AFFINITY_COMPACT,
+	AFFINITY_SCATTER,
+	NUM_AFFINITY_POLICIES,
+};
+
+/**
+ * Returns a printable name of an affinity policy (e.g. "compact").
+ *
+ * @param policy The policy.
+ */
+const char *affinity_policy_name(enum affinity_policy policy);
+
+/**
+ * Finds the affinity policy with the given name.
+ *
+ * @param name Name of the policy, as given by `affinity_policy_name()`.
+ * @param policy Receives the policy.
+ *
+ * @return `true` if the name is known.
+ */
+bool parse_affinity_policy(const char *name, enum affinity_policy *policy);
+
+/**
+ * Lists the CPUs the process may run on in the order threads are placed on them by
+ * a policy, from the package and core of each CPU in sysfs. The i-th thread goes to
+ * `cpus[i % count]`.
+ *
+ * @param policy The policy, not `AFFINITY_NONE`.
+ * @param cpus Receives the CPUs.
+ * @param max_cpus Most CPUs `cpus` can hold.
+ *
+ * @return The number of CPUs, `0` if they cannot be detected.
+ */
+int affinity_cpu_order(enum affinity_policy policy, int *cpus, int max_cpus);
+
+/**
+ * Pins a thread to a single CPU.
+ *
+ * @param thread The thread.
+ * @param cpu The CPU.
+ *
+ * @return `0` on success, `-1` if the thread cannot be pinned.
+ */
+int pin_thread(pthread_t thread, int cpu);
+
+/**
+ * Lets a thread run on all the CPUs the process could run on before any thread was
+ * pinned by `pin_thread()`.
+ *
+ * @param thread The thread.
+ *
+ * @return `0` on success, `-1` if the affinity of the thread cannot be set.
+ */
+int unpin_thread(pthread_t thread);
@@ -6,6 +6,16 @@
 #define NUM_OF_IMAGES_PREFIX_LEN 6 // lenght of '--num='
 #define QUEUE_ARGS_PREFIX_LEN                                                       \
 	10 // lenght of '--readers=', '--workers=', '--writers=' or '--mem_lim='
+#define ENGINE_PREFIX_LEN 9		   // lenght of '--engine='
+#define RADIUS_PREFIX_LEN 9		   // lenght of '--radius='
+#define LENGTH_PREFIX_LEN 9		   // lenght of '--length='
+#define ANGLE_PREFIX_LEN 8		   // lenght of '--angle='
+#define TILE_PREFIX_LEN 7		   // lenght of '--tile='
+#define SCHEDULE_PREFIX_LEN 11	   // lenght of '--schedule='
+#define CHUNK_PREFIX_LEN 8		   // lenght of '--chunk='
+#define AFFINITY_PREFIX_LEN 11	   // lenght of '--affinity='
+#define PROFILE_PREFIX_LEN 10	   // lenght of '--profile='
+#define BORDER_PREFIX_LEN 9		   // lenght of '--border='
 #define NUM_OF_ARGS_FOR_QUEUE_MOD 5
 #define INITIAL_INDEX_FOR_QUEUE_MOD 5
 #define CHECK_NUMBER(num, str)                                                      \
@@ -22,11 +32,62 @@ bool parse_args(int argc, char *argv[], program_args *args) {
 		"  --workers=<num>        Number of worker threads.\n"
 		"  --writers=<num>        Number of writer threads.\n"
 		"  --mem_lim=<MiB>        Memory limit for queues in MiB (e.g., 10).\n\n";
+	char *optional_options =
+		"Optional arguments (after all others):\n"
+		"  --engine=<engine>      Convolution engine:\n"
+		"                         'auto'   - the engine expected to be the "
+		"fastest (default),\n"
+		"                         'direct' - the fastest spatial engine,\n"
+		"                         'fft'    - always FFT-based convolution,\n"
+		"                         'shift', 'box', 'line', 'separable', "
+		"'fixed', 'sparse',\n"
+		"                         'generic' - force a specific engine.\n"
+		"                         (Ignored if --mode=seq)\n"
+		"  --radius=<num>         Radius of the 'box' filter (default 20).\n"
+		"  --length=<num>         Length of the 'motion' filter (default 9).\n"
+		"  --angle=<degrees>      Direction of the 'motion' filter (default "
+		"-45).\n"
+		"  --tile=<W>x<H>         Tile size of --mode=tile (default: sized "
+		"to the L2 cache).\n"
+		"  --schedule=<policy>    Distribution of the blocks of --mode=pixel, "
+		"row, column\n"
+		"                         and block among the threads:\n"
+		"                         'static'   - one contiguous range per "
+		"thread,\n"
+		"                         'dynamic'  - chunks claimed from a shared "
+		"counter (default),\n"
+		"                         'guided'   - claims shrinking from 1/threads "
+		"of the rest\n"
+		"                                      down to a chunk,\n"
+		"                         'stealing' - per-thread deques of "
+		"contiguous chunks,\n"
+		"                                      stolen by idle threads.\n"
+		"  --chunk=<num>          Work units per chunk of --schedule (default: 1, "
+		"32 chunks\n"
+		"                         per thread for 'stealing').\n"
+		"  --affinity=<policy>    Placement of the threads on the CPUs:\n"
+		"                         'none'    - not pinned (default),\n"
+		"                         'compact' - pinned to neighbouring CPUs,\n"
+		"                         'scatter' - pinned across packages and "
+		"cores.\n"
+		"                         Pinned threads first touch their rows of "
+		"the images.\n"
+		"  --profile=<path>       Profile of --mode=auto (default: "
+		"image-convolution/\n"
+		"                         autotune.profile in $XDG_CACHE_HOME or "
+		"~/.cache).\n"
+		"  --border=<mode>        What the filters read outside the image:\n"
+		"                         'wrap'     - the opposite side (default),\n"
+		"                         'clamp'    - the nearest edge pixel,\n"
+		"                         'mirror'   - the image mirrored at its "
+		"edges,\n"
+		"                         'constant' - black.\n\n";
 
 	if (argc < 4) {
 		error(
 			"Usage:\n"
-			"  %s <image_path | --default-image> <filter_name> --mode=seq\n"
+			"  %s <image_path | --default-image> <filter_name> "
+			"--mode=<seq | seq-fast>\n"
 			"  %s <image_path | --default-image> <filter_name> "
 			"--mode=<parallel_mode> --thread=<num>\n"
 			"  %s <image_path | --default-image> <filter_name> --mode=queue "
@@ -37,19 +98,37 @@ bool parse_args(int argc, char *argv[], program_args *args) {
 			"Options:\n"
 			"  <image_path>           Path to the input image file.\n"
 			"  --default-image        Use a predefined default image.\n"
-			"  <filter_name>          Name of the filter to apply ().\n"
+			"  <filter_name>          Name of the filter to apply, or a chain "
+			"of names joined\n"
+			"                         by '+' (planned and printed, composed "
+			"in queue mode).\n"
 			"  --mode=<mode>          Execution mode:\n"
 			"                         'seq'     - sequential processing,\n"
+			"                         'seq-fast' - optimized sequential "
+			"processing,\n"
 			"                         'row'     - parallel by rows,\n"
 			"                         'column'  - parallel by columns,\n"
 			"                         'block'   - parallel by blocks,\n"
 			"                         'pixel'   - parallel by pixels,\n"
+			"                         'tile'    - parallel by tiles sized to "
+			"the L2 cache,\n"
+			"                         'stream'  - parallel by bands of rows, "
+			"in place through\n"
+			"                                     a window of rows,\n"
+			"                         'auto'    - the fastest of 'row', "
+			"'column', 'block' and\n"
+			"                                     'pixel', threads and blocks "
+			"on this machine,\n"
 			"                         'queue'   - queue-based parallel processing.\n"
 			"  --thread=<num>         Number of threads to use for parallel "
 			"convolution.\n"
-			"                         (Ignored if --mode=seq)\n\n",
+			"                         (Ignored if --mode=seq or "
+			"--mode=seq-fast, most threads\n"
+			"                         tried by --mode=auto, all CPUs if "
+			"omitted)\n\n",
 			argv[0], argv[0], argv[0]);
 		error("%s", queue_options);
+		error("%s", optional_options);
 		error("Available Filters:\n");
 		for (int i = 0; i < NUM_OF_FILTERS; i++) {
 			error("  %-22s %s\n", filters_info[i].name, filters_info[i].description);
@@ -68,8 +147,27 @@ bool parse_args(int argc, char *argv[], program_args *args) {
 	args->mode = argv[3] + MODE_PREFIX_LEN;
 
 	int res_int = 0;
+	int next_arg = 4;
+	bool sequential =
+		strcmp(args->mode, "seq") == 0 || strcmp(args->mode, "seq-fast") == 0;
+	args->engine = FILTER_ENGINE_AUTO;
+	args->radius = BOX_BLUR_RADIUS;
+	args->length = MOTION_BLUR_LENGTH;
+	args->angle = MOTION_BLUR_ANGLE;
+	args->tile_width = 0;
+	args->tile_height = 0;
+	args->schedule = SCHEDULE_DYNAMIC;
+	args->chunk_size = 0;
+	args->affinity = AFFINITY_NONE;
+	args->profile_path = NULL;
+	args->border = BORDER_WRAP;
 
-	if (strcmp(args->mode, "seq") != 0) {
+	// The autotuner tries up to all CPUs unless a number of threads is given
+	if (strcmp(args->mode, "auto") == 0 &&
+		(argc == next_arg ||
+		 strncmp(argv[next_arg], "--thread=", THREAD_PREFIX_LEN) != 0)) {
+		args->threads_num = 0;
+	} else if (!sequential) {
 		if (strncmp(argv[4], "--thread=", THREAD_PREFIX_LEN) != 0) {
 			error("Missing --thread argument\n");
 			return false;
@@ -77,6 +175,7 @@ bool parse_args(int argc, char *argv[], program_args *args) {
 		res_int = atoi(argv[4] + THREAD_PREFIX_LEN);
 		CHECK_NUMBER(res_int, "threads")
 		args->threads_num = res_int;
+		next_arg = 5;
 	}
 
 	if (strcmp(args->mode, "queue") == 0) {
@@ -119,6 +218,81 @@ bool parse_args(int argc, char *argv[], program_args *args) {
 				return false;
 			}
 		}
+
+		next_arg = INITIAL_INDEX_FOR_QUEUE_MOD + NUM_OF_ARGS_FOR_QUEUE_MOD;
+	}
+
+	for (int i = next_arg; i < argc; i++) {
+		if (strncmp(argv[i], "--engine=", ENGINE_PREFIX_LEN) == 0) {
+			const char *engine = argv[i] + ENGINE_PREFIX_LEN;
+
+			if (!parse_filter_engine(engine, &args->engine)) {
+				error("Unknown engine name: %s\n", engine);
+				return false;
+			}
+
+		} else if (strncmp(argv[i], "--radius=", RADIUS_PREFIX_LEN) == 0) {
+			res_int = atoi(argv[i] + RADIUS_PREFIX_LEN);
+			CHECK_NUMBER(res_int, "radius")
+			args->radius = res_int;
+
+		} else if (strncmp(argv[i], "--length=", LENGTH_PREFIX_LEN) == 0) {
+			res_int = atoi(argv[i] + LENGTH_PREFIX_LEN);
+			CHECK_NUMBER(res_int, "length")
+			args->length = res_int;
+
+		} else if (strncmp(argv[i], "--angle=", ANGLE_PREFIX_LEN) == 0) {
+			args->angle = atof(argv[i] + ANGLE_PREFIX_LEN);
+
+		} else if (strncmp(argv[i], "--tile=", TILE_PREFIX_LEN) == 0) {
+			if (sscanf(argv[i] + TILE_PREFIX_LEN, "%dx%d", &args->tile_width,
+					   &args->tile_height) != 2 ||
+				args->tile_width <= 0 || args->tile_height <= 0) {
+				error("Invalid tile size, required <width>x<height> > 0.\n");
+				return false;
+			}
+
+		} else if (strncmp(argv[i], "--schedule=", SCHEDULE_PREFIX_LEN) == 0) {
+			const char *schedule = argv[i] + SCHEDULE_PREFIX_LEN;
+
+			if (!parse_schedule_policy(schedule, &args->schedule)) {
+				error("Unknown scheduling policy: %s\n", schedule);
+				return false;
+			}
+
+		} else if (strncmp(argv[i], "--chunk=", CHUNK_PREFIX_LEN) == 0) {
+			res_int = atoi(argv[i] + CHUNK_PREFIX_LEN);
+			CHECK_NUMBER(res_int, "units per chunk")
+			args->chunk_size = res_int;
+
+		} else if (strncmp(argv[i], "--affinity=", AFFINITY_PREFIX_LEN) == 0) {
+			const char *affinity = argv[i] + AFFINITY_PREFIX_LEN;
+
+			if (!parse_affinity_policy(affinity, &args->affinity)) {
+				error("Unknown affinity policy: %s\n", affinity);
+				return false;
+			}
+
+		} else if (strncmp(argv[i], "--profile=", PROFILE_PREFIX_LEN) == 0) {
+			args->profile_path = argv[i] + PROFILE_PREFIX_LEN;
+
+		} else if (strncmp(argv[i], "--border=", BORDER_PREFIX_LEN) == 0) {
+			const char *border = argv[i] + BORDER_PREFIX_LEN;
+
+			if (!parse_border_mode(border, &args->border)) {
+				error("Unknown border mode: %s\n", border);
+				return false;
+			}
+
+		} else if (sequential &&
+				   strncmp(argv[i], "--thread=", THREAD_PREFIX_LEN) == 0) {
+			// The number of threads is ignored in the sequential modes
+		} else {
+			error("Invalid argument '%s'.\n\n", argv[i]);
+			error("%s", optional_options);
+
+			return false;
+		}
 	}
 
 	return true;
@@ -1,6 +1,8 @@
 #pragma once
 
+#include "../convolution/filter_application.h"
 #include "../filters/filter.h"
+#include "affinity.h"
 #include "utils.h"
 #include <dirent.h>
 #include <stdarg.h>
@@ -16,16 +18,42 @@
  *
  * @param image_path Path to the input image file or "images/cat.bmp" if
  * --default-image is specified.
- * @param filter_name Name of the filter to apply.
- * @param mode Execution mode ("seq", "row", "column", "block", "pixel" or "queue").
+ * @param filter_name Name of the filter to apply, or names of filters joined by
+ * `+` to apply a chain.
+ * @param mode Execution mode ("seq", "seq-fast", "row", "column", "block", "pixel",
+ * "tile", "stream", "auto" or "queue").
  * @param threads_num Number of threads to use for parallel convolution (ignored for
- * "seq").
+ * "seq" and "seq-fast"), the most threads tried in "auto" mode, where `0` stands
+ * for all CPUs.
  * @param img_count Number of images to process in "queue" mode.
  * @param readers_num Number of reader threads in "queue" mode.
  * @param workers_num Number of worker threads in "queue" mode.
  * @param writers_num Number of writer threads in "queue" mode.
  * @param memory_lim Memory limit for queues in bytes (converted from MiB) in "queue"
  * mode.
+ * @param engine Convolution engine selected with the optional `--engine=` argument
+ * (`FILTER_ENGINE_AUTO` by default).
+ * @param radius Radius of the "box" filter set with the optional `--radius=`
+ * argument (`BOX_BLUR_RADIUS` by default).
+ * @param length Length of the "motion" filter set with the optional `--length=`
+ * argument (`MOTION_BLUR_LENGTH` by default).
+ * @param angle Direction of the "motion" filter in degrees set with the optional
+ * `--angle=` argument (`MOTION_BLUR_ANGLE` by default).
+ * @param tile_width Width of the tiles of "tile" mode set with the optional
+ * `--tile=` argument (`0` by default, sized to the L2 cache).
+ * @param tile_height Height of the tiles of "tile" mode (`0` by default).
+ * @param schedule Scheduling policy of the "pixel", "row", "column" and "block"
+ * modes set with the optional `--schedule=` argument (`SCHEDULE_DYNAMIC` by
+ * default).
+ * @param chunk_size Number of work units of a chunk of the scheduling policy set
+ * with the optional `--chunk=` argument (`0` by default, see
+ * `schedule_chunk_size()`).
+ * @param affinity Policy pinning the threads to CPUs set with the optional
+ * `--affinity=` argument (`AFFINITY_NONE` by default).
+ * @param profile_path Profile of the autotuner of "auto" mode set with the optional
+ * `--profile=` argument (`NULL` by default, see `autotune_default_profile()`).
+ * @param border What the filters read outside the image, set with the optional
+ * `--border=` argument (`BORDER_WRAP` by default).
  */
 typedef struct {
 	const char *img_path;
@@ -38,6 +66,18 @@ typedef struct {
 	uint8_t workers_num;
 	uint8_t writers_num;
 	size_t memory_lim;
+
+	enum filter_engine engine;
+	int radius;
+	int length;
+	double angle;
+	int tile_width;
+	int tile_height;
+	enum schedule_policy schedule;
+	int chunk_size;
+	enum affinity_policy affinity;
+	const char *profile_path;
+	enum border_mode border;
 } program_args;
 
 /**
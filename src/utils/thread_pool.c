@@ -0,0 +1,345 @@
+#include "thread_pool.h"
+#include "utils.h"
+
+#include <sched.h>
+#include <stdint.h>
+#include <unistd.h>
+
+/**
+ * A queue of tasks, guarded by the mutex of the pool. `num_queued` mirrors its
+ * length so that idle threads can poll it without taking the lock.
+ *
+ * @param head First task of the queue.
+ * @param tail Last task of the queue.
+ * @param num_queued Number of queued tasks.
+ */
+struct task_queue {
+	struct pool_task *head;
+	struct pool_task *tail;
+	atomic_int num_queued;
+};
+
+/**
+ * State of the process-wide pool. The queues and the workers are guarded by
+ * `mutex`.
+ *
+ * @param mutex Mutex guarding the pool.
+ * @param work_available Signaled when a task is queued or the pool stops.
+ * @param group_done Broadcast when the last task of a group finishes.
+ * @param shared Queue of the tasks any thread may run.
+ * @param own Queues of the tasks only one worker runs (see `thread_pool_run()`).
+ * @param workers The worker threads.
+ * @param num_workers Number of worker threads.
+ * @param stopping Whether the workers exit once their queues are empty.
+ * @param spin_iterations Polls of an idle thread before it parks, `0` on a single
+ * CPU, where polling would only delay the thread that queues the work.
+ * @param affinity Policy the threads are pinned by.
+ * @param cpus CPUs of the threads, in the order of `affinity_cpu_order()`.
+ * @param num_cpus Number of CPUs in `cpus`.
+ */
+static struct {
+	pthread_mutex_t mutex;
+	pthread_cond_t work_available;
+	pthread_cond_t group_done;
+	struct task_queue shared;
+	struct task_queue own[THREAD_POOL_MAX_WORKERS];
+	pthread_t workers[THREAD_POOL_MAX_WORKERS];
+	int num_workers;
+	bool stopping;
+	int spin_iterations;
+	enum affinity_policy affinity;
+	int cpus[AFFINITY_MAX_CPUS];
+	int num_cpus;
+} pool = {
+	.mutex = PTHREAD_MUTEX_INITIALIZER,
+	.work_available = PTHREAD_COND_INITIALIZER,
+	.group_done = PTHREAD_COND_INITIALIZER,
+};
+
+static pthread_once_t spin_once = PTHREAD_ONCE_INIT;
+
+// Index of the worker running on this thread, `-1` outside of the pool
+static _Thread_local int current_worker = -1;
+
+static void detect_spin_iterations(void) {
+	pool.spin_iterations =
+		sysconf(_SC_NPROCESSORS_ONLN) > 1 ? THREAD_POOL_SPIN_ITERATIONS : 0;
+}
+
+// Hints the CPU that the thread is polling
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#else
+	sched_yield();
+#endif
+}
+
+// Removes the first task of a queue, which must not be empty. The mutex is held.
+static struct pool_task *pop_locked(struct task_queue *queue) {
+	struct pool_task *task = queue->head;
+
+	queue->head = task->next;
+	if (queue->head == NULL) {
+		queue->tail = NULL;
+	}
+	atomic_fetch_sub(&queue->num_queued, 1);
+
+	return task;
+}
+
+// Removes the first task of a queue, or returns `NULL` if it is empty
+static struct pool_task *try_pop(struct task_queue *queue) {
+	if (atomic_load(&queue->num_queued) == 0) {
+		return NULL;
+	}
+
+	pthread_mutex_lock(&pool.mutex);
+	struct pool_task *task = queue->head != NULL ? pop_locked(queue) : NULL;
+	pthread_mutex_unlock(&pool.mutex);
+
+	return task;
+}
+
+// Removes the first task of the own queue of a worker, then of the shared one
+static struct pool_task *try_pop_for(int worker) {
+	struct pool_task *task = try_pop(&pool.own[worker]);
+	return task != NULL ? task : try_pop(&pool.shared);
+}
+
+// Appends a task to a queue and wakes the workers. The mutex is held.
+static void push_locked(struct task_queue *queue, struct pool_task *task) {
+	if (queue->tail != NULL) {
+		queue->tail->next = task;
+	} else {
+		queue->head = task;
+	}
+	queue->tail = task;
+	atomic_fetch_add(&queue->num_queued, 1);
+
+	// Any worker runs a shared task, an own task needs its worker to wake up
+	if (queue == &pool.shared) {
+		pthread_cond_signal(&pool.work_available);
+	} else {
+		pthread_cond_broadcast(&pool.work_available);
+	}
+}
+
+// Pins a thread to the CPU of the `index`-th thread of the pool, or unpins it
+// without an affinity policy. The mutex is held.
+static int pin_locked(pthread_t thread, int index) {
+	if (pool.affinity == AFFINITY_NONE) {
+		return unpin_thread(thread);
+	}
+
+	if (pin_thread(thread, pool.cpus[index % pool.num_cpus]) != 0) {
+		error("Failed to pin a thread to CPU %d\n",
+			  pool.cpus[index % pool.num_cpus]);
+		return -1;
+	}
+
+	return 0;
+}
+
+static void run_task(struct pool_task *task) {
+	// The task may be gone once its group is done
+	struct task_group *group = task->group;
+
+	task->function(task->arg);
+
+	if (atomic_fetch_sub(&group->pending, 1) == 1) {
+		pthread_mutex_lock(&pool.mutex);
+		pthread_cond_broadcast(&pool.group_done);
+		pthread_mutex_unlock(&pool.mutex);
+	}
+}
+
+static void *worker_loop(void *arg) {
+	int index = (int)(intptr_t)arg;
+	struct task_queue *own = &pool.own[index];
+
+	current_worker = index;
+
+	while (true) {
+		struct pool_task *task = NULL;
+
+		for (int i = 0; i < pool.spin_iterations && task == NULL; i++) {
+			task = try_pop_for(index);
+			if (task == NULL) {
+				cpu_relax();
+			}
+		}
+
+		if (task == NULL) {
+			pthread_mutex_lock(&pool.mutex);
+			while (own->head == NULL && pool.shared.head == NULL && !pool.stopping) {
+				pthread_cond_wait(&pool.work_available, &pool.mutex);
+			}
+
+			if (own->head == NULL && pool.shared.head == NULL) {
+				pthread_mutex_unlock(&pool.mutex);
+				break;
+			}
+
+			task = pop_locked(own->head != NULL ? own : &pool.shared);
+			pthread_mutex_unlock(&pool.mutex);
+		}
+
+		run_task(task);
+	}
+
+	return NULL;
+}
+
+void task_group_init(struct task_group *group) {
+	atomic_init(&group->pending, 0);
+}
+
+int thread_pool_reserve(int num_workers) {
+	num_workers = min(num_workers, THREAD_POOL_MAX_WORKERS);
+
+	pthread_once(&spin_once, detect_spin_iterations);
+
+	pthread_mutex_lock(&pool.mutex);
+	while (pool.num_workers < num_workers) {
+		if (pthread_create(&pool.workers[pool.num_workers], NULL, worker_loop,
+						   (void *)(intptr_t)pool.num_workers) != 0) {
+			pthread_mutex_unlock(&pool.mutex);
+			error("Failed to create a thread\n");
+			return -1;
+		}
+		pool.num_workers++;
+
+		if (pool.affinity != AFFINITY_NONE &&
+			pin_locked(pool.workers[pool.num_workers - 1], pool.num_workers) != 0) {
+			pthread_mutex_unlock(&pool.mutex);
+			return -1;
+		}
+	}
+	pthread_mutex_unlock(&pool.mutex);
+
+	return 0;
+}
+
+// Queues a task of a group in the shared queue or the own queue of a worker
+static void submit_to(struct task_queue *queue, struct task_group *group,
+					  struct pool_task *task) {
+	atomic_fetch_add(&group->pending, 1);
+	task->group = group;
+	task->next = NULL;
+
+	pthread_mutex_lock(&pool.mutex);
+	push_locked(queue, task);
+	pthread_mutex_unlock(&pool.mutex);
+}
+
+void thread_pool_submit(struct task_group *group, struct pool_task *task) {
+	submit_to(&pool.shared, group, task);
+}
+
+void thread_pool_wait(struct task_group *group) {
+	int spins = 0;
+
+	while (atomic_load(&group->pending) > 0) {
+		struct pool_task *task = try_pop(&pool.shared);
+
+		if (task != NULL) {
+			run_task(task);
+			spins = 0;
+		} else if (spins < pool.spin_iterations) {
+			cpu_relax();
+			spins++;
+		} else {
+			// Parks until a group is done, the tasks of this one run elsewhere
+			pthread_mutex_lock(&pool.mutex);
+			while (atomic_load(&group->pending) > 0 && pool.shared.head == NULL) {
+				pthread_cond_wait(&pool.group_done, &pool.mutex);
+			}
+			pthread_mutex_unlock(&pool.mutex);
+			spins = 0;
+		}
+	}
+}
+
+int thread_pool_run(void *(*function)(void *), void *args, size_t arg_size,
+					int count) {
+	if (count <= 0) {
+		return 0;
+	}
+
+	if (thread_pool_reserve(count - 1) != 0) {
+		return -1;
+	}
+
+	struct pool_task tasks[count];
+	struct task_group group;
+	task_group_init(&group);
+
+	// Pinned threads keep their share of the work from one run to the next, nested
+	// runs share their tasks so that waiting threads can help
+	bool affine = pool.affinity != AFFINITY_NONE && current_worker < 0;
+
+	for (int i = 1; i < count; i++) {
+		tasks[i].function = function;
+		tasks[i].arg = (char *)args + i * arg_size;
+		submit_to(affine ? &pool.own[i - 1] : &pool.shared, &group, &tasks[i]);
+	}
+
+	function(args);
+	thread_pool_wait(&group);
+
+	return 0;
+}
+
+int thread_pool_set_affinity(enum affinity_policy policy) {
+	int status = 0;
+
+	pthread_mutex_lock(&pool.mutex);
+	pool.affinity = policy;
+	pool.num_cpus = 0;
+
+	if (policy != AFFINITY_NONE) {
+		pool.num_cpus = affinity_cpu_order(policy, pool.cpus, AFFINITY_MAX_CPUS);
+		if (pool.num_cpus == 0) {
+			error("Failed to detect the CPUs to pin the threads to\n");
+			pool.affinity = AFFINITY_NONE;
+			status = -1;
+		}
+	}
+
+	// The calling thread runs the first argument of every run
+	status |= pin_locked(pthread_self(), 0);
+	for (int i = 0; i < pool.num_workers; i++) {
+		status |= pin_locked(pool.workers[i], i + 1);
+	}
+	pthread_mutex_unlock(&pool.mutex);
+
+	return status != 0 ? -1 : 0;
+}
+
+int thread_pool_cpu(int index) {
+	pthread_mutex_lock(&pool.mutex);
+	int cpu = pool.affinity != AFFINITY_NONE && pool.num_cpus > 0
+				  ? pool.cpus[index % pool.num_cpus]
+				  : -1;
+	pthread_mutex_unlock(&pool.mutex);
+
+	return cpu;
+}
+
+void thread_pool_shutdown(void) {
+	pthread_mutex_lock(&pool.mutex);
+	pool.stopping = true;
+	pthread_cond_broadcast(&pool.work_available);
+	int num_workers = pool.num_workers;
+	pthread_mutex_unlock(&pool.mutex);
+
+	for (int i = 0; i < num_workers; i++) {
+		pthread_join(pool.workers[i], NULL);
+	}
+
+	pthread_mutex_lock(&pool.mutex);
+	pool.num_workers = 0;
+	pool.stopping = false;
+	pthread_mutex_unlock(&pool.mutex);
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "affinity.h"
+
+#define THREAD_POOL_MAX_WORKERS 256	   // Most workers the pool grows to
+#define THREAD_POOL_SPIN_ITERATIONS 2048 // Polls of an idle thread before it parks
+
+/**
+ * Counts the tasks submitted together that have not finished yet, so that their
+ * submitter can wait for them (see `thread_pool_wait()`).
+ *
+ * @param pending Number of unfinished tasks.
+ */
+struct task_group {
+	atomic_int pending;
+};
+
+/**
+ * A task run by the pool, `function(arg)`. The submitter owns the task, which must
+ * stay valid until its group has been waited for, so submitting never allocates.
+ *
+ * @param function The function to run. Its return value is ignored.
+ * @param arg Argument passed to the function.
+ * @param group The group the task belongs to.
+ * @param next Next task in the queue of the pool.
+ */
+struct pool_task {
+	void *(*function)(void *);
+	void *arg;
+	struct task_group *group;
+	struct pool_task *next;
+};
+
+/**
+ * Initializes an empty group of tasks.
+ *
+ * @param group Pointer to the group.
+ */
+void task_group_init(struct task_group *group);
+
+/**
+ * Makes sure the process-wide pool has at least `num_workers` worker threads,
+ * starting it if needed. Workers are never stopped before `thread_pool_shutdown()`.
+ *
+ * @param num_workers Number of workers, at most `THREAD_POOL_MAX_WORKERS`.
+ *
+ * @return `0` on success, `-1` if thread creation fails.
+ */
+int thread_pool_reserve(int num_workers);
+
+/**
+ * Queues a task to be run by a worker of the pool, or by a thread waiting in
+ * `thread_pool_wait()`.
+ *
+ * @param group The group the task is added to.
+ * @param task The task, with `function` and `arg` set.
+ */
+void thread_pool_submit(struct task_group *group, struct pool_task *task);
+
+/**
+ * Waits until all the tasks of a group have finished. Meanwhile the calling thread
+ * runs queued tasks itself, so tasks may submit and wait for tasks of their own,
+ * then polls for `THREAD_POOL_SPIN_ITERATIONS` rounds (none on a single CPU) before
+ * it parks.
+ *
+ * @param group The group.
+ */
+void thread_pool_wait(struct task_group *group);
+
+/**
+ * Runs `function` on `count` arguments, `count - 1` of them on workers of the pool
+ * and one on the calling thread, and waits until all of them have finished, like
+ * creating and joining `count` threads. With an affinity policy (see
+ * `thread_pool_set_affinity()`), a run called outside of the pool gives the i-th
+ * argument to the (i-1)-th worker, so that the same thread, on the same CPU,
+ * processes the same share of the work in every run.
+ *
+ * @param function The function to run.
+ * @param args Array of `count` arguments of `arg_size` bytes each.
+ * @param arg_size Size of one argument in bytes, `0` to pass `args` to all runs.
+ * @param count Number of runs, at most `THREAD_POOL_MAX_WORKERS + 1`.
+ *
+ * @return `0` on success, `-1` if thread creation fails.
+ */
+int thread_pool_run(void *(*function)(void *), void *args, size_t arg_size,
+					int count);
+
+/**
+ * Pins the calling thread and the workers of the pool, current and future, to CPUs
+ * by a policy: the calling thread goes to the first CPU of `affinity_cpu_order()`
+ * and the i-th worker to the (i+1)-th. `AFFINITY_NONE` unpins them. Must not be
+ * called while runs are in progress.
+ *
+ * @param policy The policy.
+ *
+ * @return `0` on success, `-1` if the CPUs cannot be detected or a thread cannot be
+ * pinned.
+ */
+int thread_pool_set_affinity(enum affinity_policy policy);
+
+/**
+ * Returns the CPU of the thread running the `index`-th argument of a
+ * `thread_pool_run()` called outside of the pool.
+ *
+ * @param index Index of the argument.
+ *
+ * @return The CPU, or `-1` if the threads are not pinned.
+ */
+int thread_pool_cpu(int index);
+
+/**
+ * Stops and joins the workers of the pool once the queued tasks have run. The pool
+ * is started again by the next `thread_pool_reserve()` or `thread_pool_run()`.
+ */
+void thread_pool_shutdown(void);
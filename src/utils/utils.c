@@ -1,39 +1,58 @@
 #include "utils.h"
 
+#include <pthread.h>
+#include <unistd.h>
+
 #define NANOSECONDS_IN_SECOND 1e9
+#define CACHE_SYSFS_DIR "/sys/devices/system/cpu/cpu0/cache"
+#define CACHE_MAX_INDEX 8 // Cache descriptions (`index<N>`) looked at in sysfs
 
 struct image_rgb initialize_image_rgb(int width, int height) {
-	struct image_rgb channel_image;
-
-	channel_image.red = malloc((size_t)width * (size_t)height);
-	channel_image.green = malloc((size_t)width * (size_t)height);
-	channel_image.blue = malloc((size_t)width * (size_t)height);
+	return initialize_padded_image_rgb(width, height, 0);
+}
 
-	if (channel_image.red == NULL || channel_image.green == NULL ||
-		channel_image.blue == NULL) {
-		free_image_rgb(&channel_image);
+struct image_rgb initialize_padded_image_rgb(int width, int height, int halo) {
+	size_t left = image_stride(halo);
+	size_t stride = image_stride(left + width + halo);
+	size_t plane_size = stride * ((size_t)height + 2 * halo);
 
-		struct image_rgb empty = {NULL, NULL, NULL};
+	// `aligned_alloc()` requires a multiple of the alignment, which `stride` is
+	unsigned char *data =
+		aligned_alloc(CACHE_LINE_SIZE, max(3 * plane_size, CACHE_LINE_SIZE));
+	if (data == NULL) {
+		struct image_rgb empty = {NULL, NULL, NULL, 0, 0, NULL};
 		return empty;
 	}
 
+	size_t origin = (size_t)halo * stride + left;
+	struct image_rgb channel_image = {data + origin,
+									  data + plane_size + origin,
+									  data + 2 * plane_size + origin,
+									  stride,
+									  halo,
+									  data};
+
 	return channel_image;
 }
 
 void free_image_rgb(struct image_rgb *image) {
-	free(image->red);
-	free(image->green);
-	free(image->blue);
+	free(image->data);
+	*image = (struct image_rgb){NULL, NULL, NULL, 0, 0, NULL};
 }
 
 void split_image_into_rgb_channels(const unsigned char *image,
 								   struct image_rgb channel_image, int width,
 								   int height) {
 
-	for (size_t i = 0; i < (size_t)width * (size_t)height; i++) {
-		channel_image.red[i] = image[i * 3 + 0];
-		channel_image.green[i] = image[i * 3 + 1];
-		channel_image.blue[i] = image[i * 3 + 2];
+	for (size_t y = 0; y < (size_t)height; y++) {
+		const unsigned char *pixels = image + y * width * 3;
+		size_t row = y * channel_image.stride;
+
+		for (size_t x = 0; x < (size_t)width; x++) {
+			channel_image.red[row + x] = pixels[x * 3 + 0];
+			channel_image.green[row + x] = pixels[x * 3 + 1];
+			channel_image.blue[row + x] = pixels[x * 3 + 2];
+		}
 	}
 }
 
@@ -41,10 +60,15 @@ void assemble_image_from_rgb_channels(unsigned char *image,
 									  struct image_rgb channel_image, int width,
 									  int height) {
 
-	for (size_t i = 0; i < (size_t)width * (size_t)height; i++) {
-		image[i * 3 + 0] = channel_image.red[i];
-		image[i * 3 + 1] = channel_image.green[i];
-		image[i * 3 + 2] = channel_image.blue[i];
+	for (size_t y = 0; y < (size_t)height; y++) {
+		unsigned char *pixels = image + y * width * 3;
+		size_t row = y * channel_image.stride;
+
+		for (size_t x = 0; x < (size_t)width; x++) {
+			pixels[x * 3 + 0] = channel_image.red[row + x];
+			pixels[x * 3 + 1] = channel_image.green[row + x];
+			pixels[x * 3 + 2] = channel_image.blue[row + x];
+		}
 	}
 }
 
@@ -56,3 +80,73 @@ double get_time_in_seconds(void) {
 
 	return (double)time.tv_sec + (double)time.tv_nsec / NANOSECONDS_IN_SECOND;
 }
+
+// Reads the first line of a sysfs attribute of cache `index` into `buffer`.
+static bool read_cache_attribute(int index, const char *name, char *buffer,
+								 size_t size) {
+	char path[128];
+	snprintf(path, sizeof(path), CACHE_SYSFS_DIR "/index%d/%s", index, name);
+
+	FILE *file = fopen(path, "r");
+	if (file == NULL) {
+		return false;
+	}
+
+	bool read = fgets(buffer, (int)size, file) != NULL;
+	fclose(file);
+
+	return read;
+}
+
+// Finds the size of the level-2 data or unified cache in sysfs (e.g. `2048K`).
+static size_t sysfs_l2_cache_size(void) {
+	char level[16], type[32], size[32];
+
+	for (int i = 0; i < CACHE_MAX_INDEX; i++) {
+		if (!read_cache_attribute(i, "level", level, sizeof(level)) ||
+			!read_cache_attribute(i, "type", type, sizeof(type)) ||
+			!read_cache_attribute(i, "size", size, sizeof(size))) {
+			continue;
+		}
+
+		if (atoi(level) != 2 || strncmp(type, "Instruction", 11) == 0) {
+			continue;
+		}
+
+		char *unit = NULL;
+		size_t bytes = strtoul(size, &unit, 10);
+
+		if (*unit == 'K') {
+			bytes *= 1024;
+		} else if (*unit == 'M') {
+			bytes *= 1024 * 1024;
+		}
+
+		return bytes;
+	}
+
+	return 0;
+}
+
+static size_t detected_l2_cache_size = DEFAULT_L2_CACHE_SIZE;
+static pthread_once_t l2_cache_size_once = PTHREAD_ONCE_INIT;
+
+static void detect_l2_cache_size(void) {
+	size_t size = sysfs_l2_cache_size();
+
+#ifdef _SC_LEVEL2_CACHE_SIZE
+	if (size == 0) {
+		long result = sysconf(_SC_LEVEL2_CACHE_SIZE);
+		size = result > 0 ? (size_t)result : 0;
+	}
+#endif
+
+	if (size > 0) {
+		detected_l2_cache_size = size;
+	}
+}
+
+size_t l2_cache_size(void) {
+	pthread_once(&l2_cache_size_once, detect_l2_cache_size);
+	return detected_l2_cache_size;
+}
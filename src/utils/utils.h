@@ -10,23 +10,47 @@
 #define max(a, b) ((a) > (b) ? (a) : (b))
 #define error(...) (fprintf(stderr, __VA_ARGS__))
 #define BYTES_IN_MEBIBYTE (1024.0 * 1024.0)
+#define DEFAULT_L2_CACHE_SIZE (1024 * 1024) // Used if the size cannot be detected
+#define CACHE_LINE_SIZE 64					// Bytes of a cache line
 
 /**
- * Represents an image split into its red, green, and blue channels.
+ * Represents an image split into its red, green, and blue channels. The channels
+ * share one allocation and their rows start on cache lines: pixel `(x, y)` of a
+ * channel is at index `y * stride + x`, where `x` and `y` may reach into the halo
+ * of an image allocated with `initialize_padded_image_rgb()`.
  *
  * @param red Pointer to the red channel data.
  * @param green Pointer to the green channel data.
  * @param blue Pointer to the blue channel data.
+ * @param stride Distance between the rows of each channel, a multiple of
+ * `CACHE_LINE_SIZE`.
+ * @param halo Width of the halo around each channel, `0` for images allocated
+ * with `initialize_image_rgb()`.
+ * @param data The allocation holding the channels, `NULL` if the channels are not
+ * owned by the image.
  */
 struct image_rgb {
 	unsigned char *red;
 	unsigned char *green;
 	unsigned char *blue;
+	size_t stride;
+	int halo;
+	unsigned char *data;
 };
 
+/**
+ * Computes the stride of the rows of images of the given width, the width rounded
+ * up to a multiple of `CACHE_LINE_SIZE`.
+ *
+ * @param width Width of the image, including any halo.
+ */
+static inline size_t image_stride(size_t width) {
+	return (width + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+}
+
 /**
  * Allocates memory for the red, green, and blue channels of an image with the
- * specified dimensions.
+ * specified dimensions, in one allocation whose rows start on cache lines.
  *
  * @param width Width of the image.
  * @param height Height of the image.
@@ -37,7 +61,24 @@ struct image_rgb {
 struct image_rgb initialize_image_rgb(int width, int height);
 
 /**
- * Frees the memory allocated for the red, green, and blue channels of an image.
+ * Allocates an image like `initialize_image_rgb()` with a halo of `halo` pixels on
+ * every side of each channel, so that pixels `(x, y)` with `-halo <= x < width +
+ * halo` and `-halo <= y < height + halo` can be addressed. The left halo is rounded
+ * up to a cache line, so the rows of the image itself still start on cache lines.
+ * The halo is not initialized, see `fill_border()`.
+ *
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param halo Width of the halo.
+ *
+ * @return A `struct image_rgb` with allocated memory for each channel. If allocation
+ * fails, all pointers are set to `NULL`.
+ */
+struct image_rgb initialize_padded_image_rgb(int width, int height, int halo);
+
+/**
+ * Frees the memory allocated for the red, green, and blue channels of an image and
+ * resets its pointers.
  *
  * @param image Pointer to the `struct image_rgb` whose memory needs to be freed.
  */
@@ -73,3 +114,12 @@ void assemble_image_from_rgb_channels(unsigned char *image,
  * @return The current time in seconds as a double. Returns `-1` if an error occurs.
  */
 double get_time_in_seconds(void);
+
+/**
+ * Detects the size of the level-2 data cache of the first CPU, from sysfs or else
+ * from `sysconf()`. The size is detected once and cached.
+ *
+ * @return The size of the cache in bytes, `DEFAULT_L2_CACHE_SIZE` if it cannot be
+ * detected.
+ */
+size_t l2_cache_size(void);
@@ -0,0 +1,76 @@
+#include "work_deque.h"
+
+#include <stdlib.h>
+
+// The memory orders follow Lê et al., "Correct and Efficient Work-Stealing for Weak
+// Memory Models" (PPoPP 2013), for a buffer that never grows.
+
+int work_deque_init(struct work_deque *deque, long capacity) {
+	atomic_init(&deque->top, 0);
+	atomic_init(&deque->bottom, 0);
+	deque->capacity = capacity > 0 ? capacity : 1;
+	deque->items = malloc(deque->capacity * sizeof(atomic_int));
+
+	return deque->items != NULL ? 0 : -1;
+}
+
+void work_deque_free(struct work_deque *deque) {
+	free(deque->items);
+	deque->items = NULL;
+}
+
+void work_deque_push(struct work_deque *deque, int item) {
+	long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+
+	atomic_store_explicit(&deque->items[bottom % deque->capacity], item,
+						  memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+}
+
+int work_deque_take(struct work_deque *deque) {
+	long bottom = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+	atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+	atomic_thread_fence(memory_order_seq_cst);
+	long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+	if (top > bottom) {
+		atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+		return WORK_DEQUE_EMPTY;
+	}
+
+	int item = atomic_load_explicit(&deque->items[bottom % deque->capacity],
+									memory_order_relaxed);
+
+	// The last item may be stolen at the same time
+	if (top == bottom) {
+		if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+													 memory_order_seq_cst,
+													 memory_order_relaxed)) {
+			item = WORK_DEQUE_EMPTY;
+		}
+		atomic_store_explicit(&deque->bottom, bottom + 1, memory_order_relaxed);
+	}
+
+	return item;
+}
+
+int work_deque_steal(struct work_deque *deque) {
+	long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+	atomic_thread_fence(memory_order_seq_cst);
+	long bottom = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+
+	if (top >= bottom) {
+		return WORK_DEQUE_EMPTY;
+	}
+
+	int item = atomic_load_explicit(&deque->items[top % deque->capacity],
+									memory_order_relaxed);
+	if (!atomic_compare_exchange_strong_explicit(&deque->top, &top, top + 1,
+												 memory_order_seq_cst,
+												 memory_order_relaxed)) {
+		return WORK_DEQUE_ABORT;
+	}
+
+	return item;
+}
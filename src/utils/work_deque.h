@@ -0,0 +1,70 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#define WORK_DEQUE_EMPTY -1 // Returned when the deque holds no item
+#define WORK_DEQUE_ABORT -2 // Returned when a steal lost a race and may be retried
+#define WORK_DEQUE_ALIGNMENT 64 // Cache line the ends of a deque are placed on
+
+/**
+ * A Chase-Lev work-stealing deque of non-negative items with a fixed capacity. Its
+ * owner pushes and takes items at the bottom, other threads steal them from the top,
+ * so the owner and the thieves only contend for the last item. The two ends lie on
+ * separate cache lines.
+ *
+ * @param top Index of the oldest item, advanced by steals.
+ * @param bottom Index after the newest item, moved by the owner.
+ * @param items Circular buffer of `capacity` items.
+ * @param capacity Most items the deque holds at a time.
+ */
+struct work_deque {
+	_Alignas(WORK_DEQUE_ALIGNMENT) atomic_long top;
+	_Alignas(WORK_DEQUE_ALIGNMENT) atomic_long bottom;
+	atomic_int *items;
+	long capacity;
+};
+
+/**
+ * Allocates an empty deque.
+ *
+ * @param deque Pointer to the deque.
+ * @param capacity Most items the deque holds at a time.
+ *
+ * @return `0` on success, `-1` if memory allocation fails.
+ */
+int work_deque_init(struct work_deque *deque, long capacity);
+
+/**
+ * Frees the items of a deque.
+ *
+ * @param deque Pointer to the deque.
+ */
+void work_deque_free(struct work_deque *deque);
+
+/**
+ * Pushes an item at the bottom of the deque. Only its owner may push, and the deque
+ * must not be full.
+ *
+ * @param deque Pointer to the deque.
+ * @param item The item, not negative.
+ */
+void work_deque_push(struct work_deque *deque, int item);
+
+/**
+ * Takes the newest item from the bottom of the deque. Only its owner may take.
+ *
+ * @param deque Pointer to the deque.
+ *
+ * @return The item, or `WORK_DEQUE_EMPTY`.
+ */
+int work_deque_take(struct work_deque *deque);
+
+/**
+ * Steals the oldest item from the top of the deque. Any thread may steal.
+ *
+ * @param deque Pointer to the deque.
+ *
+ * @return The item, `WORK_DEQUE_EMPTY`, or `WORK_DEQUE_ABORT` if another thread took
+ * the item first.
+ */
+int work_deque_steal(struct work_deque *deque);
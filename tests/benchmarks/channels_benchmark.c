@@ -0,0 +1,147 @@
+#include "../../src/convolution/parallel_dispatch.h"
+#include "../../src/convolution/simd.h"
+
+#include <math.h>
+
+#define DEFAULT_WIDTH 4000
+#define DEFAULT_HEIGHT 3000
+#define DEFAULT_THREADS 4
+#define NUM_RUNS 10
+#define BYTES_IN_GIGABYTE 1e9
+
+/**
+ * Measures the throughput of splitting interleaved RGB images into channels and
+ * assembling them back, with the scalar and vectorized kernels and in parallel, and
+ * compares it to `memcpy()` of the same number of bytes. The throughput counts the
+ * bytes of the interleaved image, the best of `NUM_RUNS` runs.
+ *
+ * Usage: channels_benchmark [<width> <height> <threads>]
+ */
+
+// The operations measured, one of which is selected by `kind`
+enum operation_kind { OP_MEMCPY, OP_SPLIT, OP_ASSEMBLE };
+
+struct operation {
+	const char *name;
+	enum operation_kind kind;
+	enum simd_level level;
+	int num_threads; // `0` for the kernel on the calling thread
+};
+
+static void run_operation(const struct operation *operation, unsigned char *pixels,
+						  unsigned char *copy, struct image_rgb *channel_image,
+						  int width, int height) {
+	size_t num_pixels = (size_t)width * (size_t)height;
+
+	switch (operation->kind) {
+		case OP_MEMCPY:
+			memcpy(copy, pixels, 3 * num_pixels);
+			break;
+		case OP_SPLIT:
+			if (operation->num_threads > 0) {
+				parallel_split(pixels, channel_image, width, height,
+							   operation->num_threads);
+			} else {
+				deinterleave_fn deinterleave = get_deinterleave(operation->level);
+
+				for (size_t y = 0; y < (size_t)height; y++) {
+					size_t row = y * channel_image->stride;
+
+					deinterleave(pixels + 3 * y * width, channel_image->red + row,
+								 channel_image->green + row,
+								 channel_image->blue + row, width);
+				}
+			}
+			break;
+		case OP_ASSEMBLE:
+			if (operation->num_threads > 0) {
+				parallel_assemble(copy, channel_image, width, height,
+								  operation->num_threads);
+			} else {
+				interleave_fn interleave = get_interleave(operation->level);
+
+				for (size_t y = 0; y < (size_t)height; y++) {
+					size_t row = y * channel_image->stride;
+
+					interleave(channel_image->red + row, channel_image->green + row,
+							   channel_image->blue + row, copy + 3 * y * width,
+							   width);
+				}
+			}
+			break;
+	}
+}
+
+int main(int argc, char *argv[]) {
+	int width = DEFAULT_WIDTH, height = DEFAULT_HEIGHT;
+	int num_threads = DEFAULT_THREADS;
+
+	if (argc == 4) {
+		width = atoi(argv[1]);
+		height = atoi(argv[2]);
+		num_threads = atoi(argv[3]);
+	}
+
+	if (width <= 0 || height <= 0 || num_threads <= 0) {
+		error("Usage: %s [<width> <height> <threads>]\n", argv[0]);
+		return 1;
+	}
+
+	size_t image_size = (size_t)width * (size_t)height * 3;
+	unsigned char *pixels = malloc(image_size);
+	unsigned char *copy = malloc(image_size);
+	struct image_rgb channel_image = initialize_image_rgb(width, height);
+
+	if (pixels == NULL || copy == NULL || channel_image.red == NULL) {
+		error("Memory allocation error for the images.\n");
+		free(pixels);
+		free(copy);
+		free_image_rgb(&channel_image);
+		return 1;
+	}
+
+	for (size_t i = 0; i < image_size; i++) {
+		pixels[i] = (unsigned char)(i * 7);
+	}
+
+	enum simd_level level = detect_simd_level();
+	struct operation operations[] = {
+		{"memcpy", OP_MEMCPY, SIMD_NONE, 0},
+		{"split (scalar)", OP_SPLIT, SIMD_NONE, 0},
+		{"split (simd)", OP_SPLIT, level, 0},
+		{"split (parallel)", OP_SPLIT, level, num_threads},
+		{"assemble (scalar)", OP_ASSEMBLE, SIMD_NONE, 0},
+		{"assemble (simd)", OP_ASSEMBLE, level, 0},
+		{"assemble (parallel)", OP_ASSEMBLE, level, num_threads},
+	};
+
+	printf("%d x %d image (%.1f MB), %s kernels, %d threads\n", width, height,
+		   image_size / BYTES_IN_GIGABYTE * 1000.0, simd_level_name(level),
+		   num_threads);
+
+	double memcpy_speed = 0.0;
+	for (size_t i = 0; i < sizeof(operations) / sizeof(operations[0]); i++) {
+		double best = INFINITY;
+
+		for (int run = 0; run < NUM_RUNS; run++) {
+			double start_time = get_time_in_seconds();
+			run_operation(&operations[i], pixels, copy, &channel_image, width,
+						  height);
+			best = min(best, get_time_in_seconds() - start_time);
+		}
+
+		double speed = image_size / best / BYTES_IN_GIGABYTE;
+		if (operations[i].kind == OP_MEMCPY) {
+			memcpy_speed = speed;
+		}
+
+		printf("%-20s %8.2f GB/s  %5.2fx memcpy\n", operations[i].name, speed,
+			   speed / memcpy_speed);
+	}
+
+	free(pixels);
+	free(copy);
+	free_image_rgb(&channel_image);
+
+	return 0;
+}
@@ -20,8 +20,9 @@ OUTPUT_DIR = f"tests/plots/{IMAGE_RESOLUTION[0]}x{IMAGE_RESOLUTION[1]}"
 NUM_RUNS = 40
 THREAD_NUM = 4
 
-PARALLEL_MODES = ["pixel", "row", "column", "block"]
-ALL_MODES = ["seq"] + PARALLEL_MODES
+SEQUENTIAL_MODES = ["seq", "seq-fast"]
+PARALLEL_MODES = ["pixel", "row", "column", "block", "tile"]
+ALL_MODES = SEQUENTIAL_MODES + PARALLEL_MODES
 
 FILTERS = ["id", "bl", "gbl", "mbl", "ed", "em"]
 FILTERS_INFO = [
@@ -49,7 +50,7 @@ def run_program(filter: str, mode: str):
         A NumPy array containing execution times for all runs.
     """
     execution_times = []
-    if mode == "seq":
+    if mode in SEQUENTIAL_MODES:
         command = f"{PROGRAM_PATH} {IMAGE_PATH} {filter} --mode={mode}"
     else:
         command = f"{PROGRAM_PATH} {IMAGE_PATH} {filter} --mode={mode} --thread={THREAD_NUM}"
@@ -132,17 +133,17 @@ def main() -> None:
 
         # Create a plot of the results of individual filters.
 
-        # mode 'seq' is not taken into account
+        # sequential modes are not taken into account
         x_pos = np.arange(len(PARALLEL_MODES))
         filtered_means = [
             results[filter]["means"][i]
             for i, mode in enumerate(ALL_MODES)
-            if mode != "seq"
+            if mode not in SEQUENTIAL_MODES
         ]
         filtered_errors = [
             results[filter]["conf_inter"][i]
             for i, mode in enumerate(ALL_MODES)
-            if mode != "seq"
+            if mode not in SEQUENTIAL_MODES
         ]
 
         plt.bar(
@@ -152,7 +153,7 @@ def main() -> None:
             align="center",
             alpha=0.7,
             capsize=10,
-            color=(["#efa94a", "#47a76a", "#db5856", "#9966cc"]),
+            color=(["#efa94a", "#47a76a", "#db5856", "#9966cc", "#4a90d9"]),
         )
         plt.xticks(x_pos, PARALLEL_MODES)
         plt.ylabel("Execution Time (s)")
@@ -167,7 +168,7 @@ def main() -> None:
 
     # Create a plot of of comparison chart.
 
-    bar_width = 0.15
+    bar_width = 0.12
     x_pos = np.arange(len(FILTERS))
     _, ax = plt.subplots(figsize=(12, 6))
 
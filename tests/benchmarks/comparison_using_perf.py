@@ -15,7 +15,8 @@ OUTPUT_DIR = f"tests/plots/{IMAGE_RESOLUTION[0]}x{IMAGE_RESOLUTION[1]}"
 NUM_RUNS = 40
 THREAD_NUM = 4
 
-MODES = ["seq", "pixel", "row", "column", "block"]
+SEQUENTIAL_MODES = ["seq", "seq-fast"]
+MODES = SEQUENTIAL_MODES + ["pixel", "row", "column", "block", "tile"]
 
 os.makedirs(OUTPUT_DIR, exist_ok=True)
 
@@ -34,7 +35,7 @@ def run_perf_stat(mode: str):
             l1_mis: L1 data cache load misses.
     """
     c_ref, c_mis, l1_mis = [], [], []
-    if mode == "seq":
+    if mode in SEQUENTIAL_MODES:
         command = f"perf stat -e cache-references,cache-misses,L1-dcache-load-misses {PROGRAM_PATH} {IMAGE_PATH} id --mode={mode}"
     else:
         command = f"perf stat -e cache-references,cache-misses,L1-dcache-load-misses {PROGRAM_PATH} {IMAGE_PATH} id --mode={mode} --thread={THREAD_NUM}"
@@ -119,7 +120,9 @@ def main() -> None:
             align="center",
             alpha=0.7,
             capsize=10,
-            color=(["#42aaff", "#efa94a", "#47a76a", "#db5856", "#9966cc"]),
+            color=(
+                ["#42aaff", "#2a6ebb", "#efa94a", "#47a76a", "#db5856", "#9966cc", "#4a90d9"]
+            ),
         )
         plt.xticks(x_pos, MODES)
         plt.ylabel("Count")
@@ -0,0 +1,198 @@
+#include "../../src/convolution/parallel_dispatch.h"
+#include "../../src/utils/thread_pool.h"
+
+#include <linux/perf_event.h>
+#include <math.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define DEFAULT_WIDTH 1000
+#define DEFAULT_HEIGHT 1000
+#define DEFAULT_THREADS 4
+#define NUM_RUNS 5
+#define NUM_COUNTERS 3
+
+/**
+ * Measures how much the threads of `parallel_filter()` share the cache lines of the
+ * output planes in the parallel modes, with single blocks handed out ("shared
+ * lines", where neighbouring blocks of `pixel` and `column` modes write the same
+ * line from different threads) and with line-wide work units ("own lines", see
+ * `set_line_units()`). Reports the best time of `NUM_RUNS` runs and hardware
+ * counters summed over all of them, read with `perf_event_open()`: cache references
+ * and misses, and L1 data cache load misses. Counters the kernel does not allow
+ * (see `/proc/sys/kernel/perf_event_paranoid`) are printed as `n/a`. HITM events,
+ * loads of a line modified by another core, are model-specific and recorded by
+ * `scripts/false_sharing_benchmark.sh` with `perf c2c` instead.
+ *
+ * Usage: false_sharing_benchmark [<width> <height> <threads> [<mode> <own lines>]]
+ */
+
+struct mode {
+	const char *name;
+	int (*function)(struct image_rgb *, struct image_rgb *, int, int, struct filter,
+					int);
+};
+
+static const struct mode modes[] = {
+	{"pixel", parallel_pixel},
+	{"column", parallel_column},
+	{"row", parallel_row},
+	{"block", parallel_block},
+};
+
+static const char *const counter_names[NUM_COUNTERS] = {
+	"cache-references", "cache-misses", "L1-dcache-load-misses"};
+
+// Opens a counter of the calling process and the threads it creates afterwards, or
+// returns `-1` if it is not allowed
+static int open_counter(int index) {
+	struct perf_event_attr attr = {
+		.size = sizeof(struct perf_event_attr),
+		.inherit = 1,
+		.exclude_kernel = 1,
+		.exclude_hv = 1,
+	};
+
+	if (index < 2) {
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.config =
+			index == 0 ? PERF_COUNT_HW_CACHE_REFERENCES : PERF_COUNT_HW_CACHE_MISSES;
+	} else {
+		attr.type = PERF_TYPE_HW_CACHE;
+		attr.config = PERF_COUNT_HW_CACHE_L1D |
+					  (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+					  (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+	}
+
+	return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+static long long read_counter(int fd) {
+	long long value = 0;
+
+	if (fd < 0 || read(fd, &value, sizeof(value)) != sizeof(value)) {
+		return -1;
+	}
+
+	return value;
+}
+
+// Runs a mode `NUM_RUNS` times and prints its best time and counters
+static void run_mode(const struct mode *mode, bool own_lines, const int *counters,
+					 struct image_rgb *input, struct image_rgb *output, int width,
+					 int height, struct filter filter, int num_threads) {
+	long long start[NUM_COUNTERS];
+	for (int i = 0; i < NUM_COUNTERS; i++) {
+		start[i] = read_counter(counters[i]);
+	}
+
+	set_line_units(own_lines);
+
+	double best = INFINITY;
+	for (int run = 0; run < NUM_RUNS; run++) {
+		double start_time = get_time_in_seconds();
+		mode->function(input, output, width, height, filter, num_threads);
+		best = min(best, get_time_in_seconds() - start_time);
+	}
+
+	// The counts of the workers are added to the counters when they exit
+	thread_pool_shutdown();
+
+	printf("%-7s %-13s %9.4f s", mode->name,
+		   own_lines ? "own lines" : "shared lines", best);
+	for (int i = 0; i < NUM_COUNTERS; i++) {
+		long long end = read_counter(counters[i]);
+
+		if (start[i] < 0 || end < 0) {
+			printf(" %22s", "n/a");
+		} else {
+			printf(" %22lld", end - start[i]);
+		}
+	}
+	printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+	int width = DEFAULT_WIDTH, height = DEFAULT_HEIGHT;
+	int num_threads = DEFAULT_THREADS;
+	const char *only_mode = NULL;
+	int only_own_lines = -1;
+
+	if (argc == 4 || argc == 6) {
+		width = atoi(argv[1]);
+		height = atoi(argv[2]);
+		num_threads = atoi(argv[3]);
+	}
+	if (argc == 6) {
+		only_mode = argv[4];
+		only_own_lines = atoi(argv[5]) != 0;
+	}
+
+	if ((argc != 1 && argc != 4 && argc != 6) || width <= 0 || height <= 0 ||
+		num_threads <= 0) {
+		error("Usage: %s [<width> <height> <threads> [<mode> <own lines>]]\n",
+			  argv[0]);
+		return 1;
+	}
+
+	// The counters follow the workers of the pool, which are created afterwards
+	int counters[NUM_COUNTERS];
+	for (int i = 0; i < NUM_COUNTERS; i++) {
+		counters[i] = open_counter(i);
+	}
+
+	struct image_rgb input = initialize_image_rgb(width, height);
+	struct image_rgb output = initialize_image_rgb(width, height);
+	struct filter filter = create_filter(3, FAST_BLUR_FACTOR, FAST_BLUR_BIAS,
+										 fast_blur);
+
+	if (input.red == NULL || output.red == NULL || filter.kernel == NULL) {
+		error("Memory allocation error for the images.\n");
+		free_image_rgb(&input);
+		free_image_rgb(&output);
+		free_filter(&filter);
+		return 1;
+	}
+
+	for (size_t y = 0; y < (size_t)height; y++) {
+		for (size_t x = 0; x < (size_t)width; x++) {
+			size_t i = y * width + x;
+
+			input.red[y * input.stride + x] = (unsigned char)(i * 7);
+			input.green[y * input.stride + x] = (unsigned char)(i * 11);
+			input.blue[y * input.stride + x] = (unsigned char)(i * 13);
+		}
+	}
+
+	printf("%d x %d image, fbl filter, %d threads, best of %d runs\n", width,
+		   height, num_threads, NUM_RUNS);
+	printf("%-7s %-13s %11s", "mode", "units", "time");
+	for (int i = 0; i < NUM_COUNTERS; i++) {
+		printf(" %22s", counter_names[i]);
+	}
+	printf("\n");
+
+	for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+		if (only_mode != NULL && strcmp(only_mode, modes[i].name) != 0) {
+			continue;
+		}
+
+		for (int own_lines = 0; own_lines < 2; own_lines++) {
+			if (only_own_lines < 0 || only_own_lines == own_lines) {
+				run_mode(&modes[i], own_lines, counters, &input, &output, width,
+						 height, filter, num_threads);
+			}
+		}
+	}
+
+	for (int i = 0; i < NUM_COUNTERS; i++) {
+		if (counters[i] >= 0) {
+			close(counters[i]);
+		}
+	}
+	free_image_rgb(&input);
+	free_image_rgb(&output);
+	free_filter(&filter);
+
+	return 0;
+}
@@ -1,8 +1,16 @@
+#include "../src/convolution/chain.h"
+#include "../src/convolution/dispatch.h"
 #include "../src/convolution/filter_application.h"
 #include "../src/convolution/parallel_dispatch.h"
+#include "../src/convolution/stream.h"
 
 #include "utils_for_tests.h"
 
+#define CHAIN_TEST_SIZE_LIMIT 600
+#define CHAIN_TEST_LENGTH 20 // Length of the motion blur in the chain
+#define TILE_TEST_WIDTH 37	 // Tiles that do not divide the image
+#define TILE_TEST_HEIGHT 13
+
 /**
  * A helper function that runs a parallel test for a given parallel implementation
  * (parallel_function). It compares the results of the parallel implementation with
@@ -42,12 +50,7 @@ static void run_test_with_filter(
 			assert(false);
 		}
 	} else {
-		assert_memory_equal(result_seq.red, result_par.red,
-							(size_t)width * (size_t)height);
-		assert_memory_equal(result_seq.green, result_par.green,
-							(size_t)width * (size_t)height);
-		assert_memory_equal(result_seq.blue, result_par.blue,
-							(size_t)width * (size_t)height);
+		assert_true(compare_channels(&result_seq, &result_par, width, height));
 	}
 
 	free_image_rgb(channel_image);
@@ -192,6 +195,643 @@ void test_parallel_block_with_random_image(void **state) {
 	run_test_with_filter(true, parallel_block, &channel_image, width, height, 3);
 }
 
+/**
+ * Tests the parallel modes with every scheduling policy using randomly generated
+ * images, with chunk sizes that do not divide the number of blocks and more threads
+ * than the other tests, so that the threads run out of work at different times.
+ */
+void test_parallel_schedules_with_random_image(void **state) {
+	(void)state;
+
+	struct {
+		enum schedule_policy schedule;
+		int chunk_size;
+		int (*function)(struct image_rgb *, struct image_rgb *, int, int,
+						struct filter, int);
+	} cases[] = {
+		{SCHEDULE_STATIC, 0, parallel_column},
+		{SCHEDULE_DYNAMIC, 7, parallel_pixel},
+		{SCHEDULE_GUIDED, 0, parallel_row},
+		{SCHEDULE_GUIDED, 3, parallel_column},
+		{SCHEDULE_STEALING, 0, parallel_pixel},
+		{SCHEDULE_STEALING, 5, parallel_block},
+	};
+
+	for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		int width = (rand() % UPPER_SIZE_LIMIT);
+		int height = (rand() % UPPER_SIZE_LIMIT);
+		printf("Testing %s schedule with random image size: %d x %d\n",
+			   schedule_policy_name(cases[i].schedule), width, height);
+
+		struct image_rgb channel_image = create_test_image(width, height);
+
+		set_parallel_schedule(cases[i].schedule, cases[i].chunk_size);
+		run_test_with_filter(true, cases[i].function, &channel_image, width, height,
+							 5);
+	}
+
+	set_parallel_schedule(SCHEDULE_DYNAMIC, 0);
+}
+
+/**
+ * Tests the parallel modes handing out single blocks instead of line-wide work
+ * units, with random image sizes.
+ */
+void test_parallel_single_block_units_with_random_image(void **state) {
+	(void)state;
+
+	int (*functions[])(struct image_rgb *, struct image_rgb *, int, int,
+					   struct filter, int) = {parallel_pixel, parallel_column};
+
+	set_line_units(false);
+	for (size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); i++) {
+		int width = (rand() % UPPER_SIZE_LIMIT);
+		int height = (rand() % UPPER_SIZE_LIMIT);
+		printf("Testing single block units with random image size: %d x %d\n",
+			   width, height);
+
+		struct image_rgb channel_image = create_test_image(width, height);
+
+		run_test_with_filter(true, functions[i], &channel_image, width, height, 5);
+	}
+	set_line_units(true);
+}
+
+/**
+ * Tests that the parallel modes leave an empty image alone instead of dividing it
+ * into blocks.
+ */
+void test_parallel_filter_with_empty_image(void **state) {
+	(void)state;
+
+	struct filter filter = create_filter(3, 1.0, 0.0, id);
+	assert_non_null(filter.kernel);
+
+	struct image_rgb image = {NULL, NULL, NULL, 0, 0, NULL};
+
+	assert_int_equal(parallel_row(&image, &image, 0, 0, filter, 3), 0);
+	assert_int_equal(parallel_column(&image, &image, 0, 7, filter, 3), 0);
+	assert_int_equal(parallel_block(&image, &image, 7, 0, filter, 3), 0);
+
+	free_filter(&filter);
+}
+
+// Filter Chain Tests
+
+// Adapt `parallel_tile()` to the signature of the other parallel modes
+static int parallel_tile_sized_to_cache(struct image_rgb *input_image,
+										struct image_rgb *output_image, int width,
+										int height, struct filter filter,
+										int num_threads) {
+	return parallel_tile(input_image, output_image, width, height, filter,
+						 num_threads, 0, 0);
+}
+
+static int parallel_small_tile(struct image_rgb *input_image,
+							   struct image_rgb *output_image, int width, int height,
+							   struct filter filter, int num_threads) {
+	return parallel_tile(input_image, output_image, width, height, filter,
+						 num_threads, TILE_TEST_WIDTH, TILE_TEST_HEIGHT);
+}
+
+/**
+ * Tests the `parallel_tile()` implementation with tiles sized to the L2 cache and
+ * with small tiles using a predefined default image (cat.bmp).
+ */
+void test_parallel_tile_with_default_image(void **state) {
+	(void)state;
+
+	int (*tile_functions[])(struct image_rgb *, struct image_rgb *, int, int,
+							struct filter, int) = {parallel_tile_sized_to_cache,
+												   parallel_small_tile};
+
+	for (int i = 0; i < 2; i++) {
+		int width, height, channels;
+		unsigned char *image =
+			stbi_load("../../images/cat.bmp", &width, &height, &channels, 3);
+		assert_true(image);
+
+		struct image_rgb channel_image =
+			initialize_and_check_image_rgb(width, height);
+		split_image_into_rgb_channels(image, channel_image, width, height);
+
+		run_test_with_filter(false, tile_functions[i], &channel_image, width,
+							 height, 3);
+
+		stbi_image_free(image);
+	}
+}
+
+/**
+ * Tests the `parallel_tile()` implementation with small tiles using a randomly
+ * generated image.
+ */
+void test_parallel_tile_with_random_image(void **state) {
+	(void)state;
+
+	int width = (rand() % UPPER_SIZE_LIMIT), height = (rand() % UPPER_SIZE_LIMIT);
+	printf("Testing with random image size: %d x %d\n", width, height);
+
+	struct image_rgb channel_image = create_test_image(width, height);
+
+	run_test_with_filter(true, parallel_small_tile, &channel_image, width, height,
+						 3);
+}
+
+/**
+ * A helper function that applies a chain of filters (blur, gaus_blur, a box blur, a
+ * motion blur and emboss, so that every engine is used) tile by tile, as a plan of
+ * fused runs and passes, both to the split and the interleaved image, and filter by
+ * filter over whole images with the reference application, and checks that the
+ * results are identical.
+ *
+ * @param channel_image Pointer to the input image's RGB channels.
+ * @param width Width of the image.
+ * @param height Height of the image.
+ * @param num_threads Number of threads to use for parallel processing.
+ */
+static void run_chain_test(struct image_rgb *channel_image, int width, int height,
+						   int num_threads) {
+	struct filter filters[] = {
+		create_filter(BLUR_SIZE, BLUR_FACTOR, BLUR_BIAS, blur),
+		create_filter(GAUS_BLUR_SIZE, GAUS_BLUR_FACTOR, GAUS_BLUR_BIAS, gaus_blur),
+		create_box_filter(2),
+		create_motion_blur_filter(CHAIN_TEST_LENGTH, 30.0),
+		create_filter(EMBOSS_SIZE, EMBOSS_FACTOR, EMBOSS_BIAS, emboss),
+	};
+	int num_filters = sizeof(filters) / sizeof(filters[0]);
+
+	struct image_rgb result_seq = initialize_and_check_image_rgb(width, height);
+	struct image_rgb result_chain = initialize_and_check_image_rgb(width, height);
+	struct image_rgb intermediate = initialize_and_check_image_rgb(width, height);
+
+	// Whole images between the filters
+	sequential_application(channel_image, &result_seq, width, height, filters[0]);
+	for (int i = 1; i < num_filters; i++) {
+		assert_non_null(filters[i].kernel);
+
+		struct image_rgb swap = intermediate;
+		intermediate = result_seq;
+		result_seq = swap;
+
+		sequential_application(&intermediate, &result_seq, width, height,
+							   filters[i]);
+	}
+
+	assert_int_equal(chain_application(channel_image, &result_chain, width, height,
+									   filters, num_filters, num_threads),
+					 0);
+
+	assert_true(compare_channels(&result_seq, &result_chain, width, height));
+
+	// Fused runs between passes, without compositions
+	struct chain_plan plan = {
+		.num_filters = num_filters,
+		.links = {CHAIN_LINK_FUSE, CHAIN_LINK_PASS, CHAIN_LINK_FUSE,
+				  CHAIN_LINK_PASS},
+	};
+	assert_int_equal(apply_chain_plan(channel_image, &result_chain, width, height,
+									  filters, &plan, parallel_row, num_threads),
+					 0);
+
+	assert_true(compare_channels(&result_seq, &result_chain, width, height));
+
+	// The same chain and plan on interleaved pixels, with small tiles that do not
+	// divide the image
+	size_t image_size = (size_t)width * (size_t)height * 3;
+	unsigned char *pixels = malloc(image_size);
+	unsigned char *expected = malloc(image_size);
+	unsigned char *result = malloc(image_size);
+	assert_non_null(pixels);
+	assert_non_null(expected);
+	assert_non_null(result);
+
+	assemble_image_from_rgb_channels(pixels, *channel_image, width, height);
+	assemble_image_from_rgb_channels(expected, result_seq, width, height);
+
+	assert_int_equal(chain_application_interleaved(
+						 pixels, result, width, height, filters, num_filters,
+						 TILE_TEST_WIDTH, TILE_TEST_HEIGHT, num_threads),
+					 0);
+	assert_memory_equal(expected, result, image_size);
+
+	memset(result, 0, image_size);
+	assert_int_equal(apply_chain_plan_interleaved(pixels, result, width, height,
+												  filters, &plan, num_threads),
+					 0);
+	assert_memory_equal(expected, result, image_size);
+
+	free(pixels);
+	free(expected);
+	free(result);
+	free_image_rgb(&result_seq);
+	free_image_rgb(&result_chain);
+	free_image_rgb(&intermediate);
+	for (int i = 0; i < num_filters; i++) {
+		free_filter(&filters[i]);
+	}
+}
+
+/**
+ * Tests the `chain_application()` implementation using a predefined default image
+ * (cat.bmp).
+ */
+void test_filter_chain_with_default_image(void **state) {
+	(void)state;
+
+	int width, height, channels;
+	unsigned char *image =
+		stbi_load("../../images/cat.bmp", &width, &height, &channels, 3);
+	assert_true(image);
+
+	struct image_rgb channel_image = initialize_and_check_image_rgb(width, height);
+	split_image_into_rgb_channels(image, channel_image, width, height);
+
+	run_chain_test(&channel_image, width, height, 3);
+
+	stbi_image_free(image);
+	free_image_rgb(&channel_image);
+}
+
+/**
+ * Tests the `chain_application()` implementation using a randomly generated image,
+ * at least as large as the motion blur of the chain.
+ */
+void test_filter_chain_with_random_image(void **state) {
+	(void)state;
+
+	int width = (rand() % CHAIN_TEST_SIZE_LIMIT) + CHAIN_TEST_LENGTH + 1;
+	int height = (rand() % CHAIN_TEST_SIZE_LIMIT) + CHAIN_TEST_LENGTH + 1;
+	printf("Testing with random image size: %d x %d\n", width, height);
+
+	struct image_rgb channel_image = create_test_image(width, height);
+
+	run_chain_test(&channel_image, width, height, 1);
+	run_chain_test(&channel_image, width, height, 4);
+
+	free_image_rgb(&channel_image);
+}
+
+/**
+ * Tests the `chain_application_interleaved()` implementation on an image smaller
+ * than the motion blur of the chain, which is applied to split copies of the image.
+ */
+void test_interleaved_chain_with_small_image(void **state) {
+	(void)state;
+
+	int width = (rand() % CHAIN_TEST_LENGTH) + 1;
+	int height = (rand() % CHAIN_TEST_LENGTH) + 1;
+	printf("Testing with random image size: %d x %d\n", width, height);
+
+	struct image_rgb channel_image = create_test_image(width, height);
+	struct image_rgb result_seq = initialize_and_check_image_rgb(width, height);
+	struct filter filter = create_motion_blur_filter(CHAIN_TEST_LENGTH, 30.0);
+	assert_non_null(filter.kernel);
+
+	sequential_application(&channel_image, &result_seq, width, height, filter);
+
+	size_t image_size = (size_t)width * (size_t)height * 3;
+	unsigned char *pixels = malloc(image_size);
+	unsigned char *expected = malloc(image_size);
+	unsigned char *result = malloc(image_size);
+	assert_non_null(pixels);
+	assert_non_null(expected);
+	assert_non_null(result);
+
+	assemble_image_from_rgb_channels(pixels, channel_image, width, height);
+	assemble_image_from_rgb_channels(expected, result_seq, width, height);
+
+	assert_int_equal(chain_application_interleaved(pixels, result, width, height,
+												   &filter, 1, 0, 0, 2),
+					 0);
+	assert_memory_equal(expected, result, image_size);
+
+	free(pixels);
+	free(expected);
+	free(result);
+	free_image_rgb(&channel_image);
+	free_image_rgb(&result_seq);
+	free_filter(&filter);
+}
+
+/**
+ * Tests the border modes other than wrapping, which the chains apply filter by
+ * filter, against the reference application over whole images: a single filter in
+ * the block and tile modes and the chain tile by tile, as planned and on
+ * interleaved pixels, reading the image and a copy of it with a halo.
+ */
+void test_parallel_border_modes_with_random_image(void **state) {
+	(void)state;
+
+	int width = (rand() % CHAIN_TEST_SIZE_LIMIT) + CHAIN_TEST_LENGTH + 1;
+	int height = (rand() % CHAIN_TEST_SIZE_LIMIT) + CHAIN_TEST_LENGTH + 1;
+	printf("Testing with random image size: %d x %d\n", width, height);
+
+	struct filter filters[] = {
+		create_filter(BLUR_SIZE, BLUR_FACTOR, BLUR_BIAS, blur),
+		create_motion_blur_filter(CHAIN_TEST_LENGTH, 30.0),
+		create_box_filter(2),
+	};
+	int num_filters = sizeof(filters) / sizeof(filters[0]);
+	int halo = chain_halo(filters, num_filters);
+
+	struct image_rgb channel_image = create_test_image(width, height);
+	struct image_rgb padded = initialize_padded_image_rgb(width, height, halo);
+	struct image_rgb padded_result =
+		initialize_padded_image_rgb(width, height, halo);
+	struct image_rgb expected = initialize_and_check_image_rgb(width, height);
+	struct image_rgb result = initialize_and_check_image_rgb(width, height);
+	struct image_rgb intermediate = initialize_and_check_image_rgb(width, height);
+	assert_non_null(padded.red);
+	assert_non_null(padded_result.red);
+
+	for (size_t y = 0; y < (size_t)height; y++) {
+		memcpy(padded.red + y * padded.stride,
+			   channel_image.red + y * channel_image.stride, width);
+		memcpy(padded.green + y * padded.stride,
+			   channel_image.green + y * channel_image.stride, width);
+		memcpy(padded.blue + y * padded.stride,
+			   channel_image.blue + y * channel_image.stride, width);
+	}
+
+	size_t image_size = (size_t)width * (size_t)height * 3;
+	unsigned char *pixels = malloc(image_size);
+	unsigned char *expected_pixels = malloc(image_size);
+	unsigned char *result_pixels = malloc(image_size);
+	assert_non_null(pixels);
+	assert_non_null(expected_pixels);
+	assert_non_null(result_pixels);
+	assemble_image_from_rgb_channels(pixels, channel_image, width, height);
+
+	for (int border = BORDER_CLAMP; border < NUM_BORDER_MODES; border++) {
+		printf("Testing the %s border\n", border_mode_name(border));
+		for (int i = 0; i < num_filters; i++) {
+			assert_non_null(filters[i].kernel);
+			filters[i].border = border;
+		}
+
+		// A single filter
+		sequential_application(&channel_image, &expected, width, height,
+							   filters[1]);
+
+		assert_int_equal(parallel_block(&channel_image, &result, width, height,
+										filters[1], 4),
+						 0);
+		assert_true(compare_channels(&expected, &result, width, height));
+
+		assert_int_equal(parallel_block(&padded, &result, width, height,
+										filters[1], 4),
+						 0);
+		assert_true(compare_channels(&expected, &result, width, height));
+
+		assert_int_equal(parallel_small_tile(&channel_image, &result, width,
+											 height, filters[1], 4),
+						 0);
+		assert_true(compare_channels(&expected, &result, width, height));
+
+		// The chain, filter by filter over whole images
+		sequential_application(&channel_image, &intermediate, width, height,
+							   filters[0]);
+		sequential_application(&intermediate, &result, width, height, filters[1]);
+		sequential_application(&result, &expected, width, height, filters[2]);
+
+		assert_int_equal(chain_application(&channel_image, &result, width, height,
+										   filters, num_filters, 4),
+						 0);
+		assert_true(compare_channels(&expected, &result, width, height));
+
+		struct chain_plan plan;
+		assert_int_equal(
+			plan_chain(filters, num_filters, width, height, false, &plan), 0);
+		for (int i = 0; i + 1 < num_filters; i++) {
+			assert_int_equal(plan.links[i], CHAIN_LINK_PASS);
+		}
+
+		assert_int_equal(apply_chain_plan(&padded, &padded_result, width, height,
+										  filters, &plan, parallel_row, 4),
+						 0);
+		assert_true(compare_channels(&expected, &padded_result, width, height));
+
+		assemble_image_from_rgb_channels(expected_pixels, expected, width, height);
+
+		assert_int_equal(chain_application_interleaved(
+							 pixels, result_pixels, width, height, filters,
+							 num_filters, TILE_TEST_WIDTH, TILE_TEST_HEIGHT, 4),
+						 0);
+		assert_memory_equal(expected_pixels, result_pixels, image_size);
+
+		memset(result_pixels, 0, image_size);
+		assert_int_equal(apply_chain_plan_interleaved(pixels, result_pixels, width,
+													  height, filters, &plan, 4),
+						 0);
+		assert_memory_equal(expected_pixels, result_pixels, image_size);
+	}
+
+	free(pixels);
+	free(expected_pixels);
+	free(result_pixels);
+	free_image_rgb(&channel_image);
+	free_image_rgb(&padded);
+	free_image_rgb(&padded_result);
+	free_image_rgb(&expected);
+	free_image_rgb(&result);
+	free_image_rgb(&intermediate);
+	for (int i = 0; i < num_filters; i++) {
+		free_filter(&filters[i]);
+	}
+}
+
+/**
+ * Tests the box engine applied from summed-area tables, as the pixel, row and
+ * column modes apply box filters, against `sequential_application()` in every
+ * border mode, for a box smaller than a randomly generated image and one larger
+ * than a small image, so that its taps wrap around the image more than once.
+ */
+void test_parallel_box_sums_with_random_image(void **state) {
+	(void)state;
+
+	int width = (rand() % CHAIN_TEST_SIZE_LIMIT) + 1;
+	int height = (rand() % CHAIN_TEST_SIZE_LIMIT) + 1;
+	int small_width = (rand() % 8) + 1;
+	int small_height = (rand() % 8) + 1;
+	printf("Testing with random image sizes: %d x %d and %d x %d\n", width, height,
+		   small_width, small_height);
+
+	struct {
+		int width;
+		int height;
+		int radius;
+	} cases[] = {
+		{width, height, BOX_BLUR_RADIUS},
+		{small_width, small_height, 6},
+	};
+	chain_pass_fn modes[] = {parallel_pixel, parallel_row, parallel_column};
+
+	for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		int w = cases[i].width, h = cases[i].height;
+		struct filter filter = create_box_filter(cases[i].radius);
+		assert_non_null(filter.kernel);
+		assert_true(box_sums_are_cheaper(&filter, w, 1));
+
+		struct image_rgb channel_image = create_test_image(w, h);
+		struct image_rgb expected = initialize_and_check_image_rgb(w, h);
+		struct image_rgb result = initialize_and_check_image_rgb(w, h);
+
+		for (int border = BORDER_WRAP; border < NUM_BORDER_MODES; border++) {
+			filter.border = border;
+			sequential_application(&channel_image, &expected, w, h, filter);
+
+			for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+				assert_int_equal(
+					modes[m](&channel_image, &result, w, h, filter, 4), 0);
+				assert_true(compare_channels(&expected, &result, w, h));
+			}
+		}
+
+		free_image_rgb(&channel_image);
+		free_image_rgb(&expected);
+		free_image_rgb(&result);
+		free_filter(&filter);
+	}
+}
+
+/**
+ * Tests `stream_application()` and `stream_application_interleaved()`, in place and
+ * into a separate output, against `sequential_application()` for several filters,
+ * border modes and numbers of threads, including more threads than rows, using a
+ * randomly generated image.
+ */
+void test_stream_with_random_image(void **state) {
+	(void)state;
+
+	int width = (rand() % CHAIN_TEST_SIZE_LIMIT) + 1;
+	int height = (rand() % CHAIN_TEST_SIZE_LIMIT) + 1;
+	printf("Testing with random image size: %d x %d\n", width, height);
+
+	struct filter filters[] = {
+		create_filter(GAUS_BLUR_SIZE, GAUS_BLUR_FACTOR, GAUS_BLUR_BIAS, gaus_blur),
+		create_motion_blur_filter(CHAIN_TEST_LENGTH, 30.0),
+		create_box_filter(2),
+		create_filter(EMBOSS_SIZE, EMBOSS_FACTOR, EMBOSS_BIAS, emboss),
+	};
+	int num_filters = sizeof(filters) / sizeof(filters[0]);
+	int thread_counts[] = {1, 4, height + 3};
+
+	struct image_rgb channel_image = create_test_image(width, height);
+	struct image_rgb expected = initialize_and_check_image_rgb(width, height);
+	struct image_rgb result = initialize_and_check_image_rgb(width, height);
+
+	size_t image_size = (size_t)width * (size_t)height * 3;
+	unsigned char *pixels = malloc(image_size);
+	unsigned char *expected_pixels = malloc(image_size);
+	unsigned char *result_pixels = malloc(image_size);
+	assert_non_null(pixels);
+	assert_non_null(expected_pixels);
+	assert_non_null(result_pixels);
+	assemble_image_from_rgb_channels(pixels, channel_image, width, height);
+
+	for (int border = BORDER_WRAP; border < NUM_BORDER_MODES; border++) {
+		for (int i = 0; i < num_filters; i++) {
+			assert_non_null(filters[i].kernel);
+			filters[i].border = border;
+
+			sequential_application(&channel_image, &expected, width, height,
+								   filters[i]);
+			assemble_image_from_rgb_channels(expected_pixels, expected, width,
+											 height);
+
+			for (int t = 0; t < 3; t++) {
+				int num_threads = thread_counts[t];
+
+				assert_int_equal(stream_application(&channel_image, &result, width,
+													height, filters[i],
+													num_threads),
+								 0);
+				assert_true(compare_channels(&expected, &result, width, height));
+
+				// In place, over a copy of the input
+				for (size_t y = 0; y < (size_t)height; y++) {
+					memcpy(result.red + y * result.stride,
+						   channel_image.red + y * channel_image.stride, width);
+					memcpy(result.green + y * result.stride,
+						   channel_image.green + y * channel_image.stride, width);
+					memcpy(result.blue + y * result.stride,
+						   channel_image.blue + y * channel_image.stride, width);
+				}
+				assert_int_equal(stream_application(&result, &result, width,
+													height, filters[i],
+													num_threads),
+								 0);
+				assert_true(compare_channels(&expected, &result, width, height));
+
+				memset(result_pixels, 0, image_size);
+				assert_int_equal(stream_application_interleaved(
+									 pixels, result_pixels, width, height,
+									 filters[i], num_threads),
+								 0);
+				assert_memory_equal(expected_pixels, result_pixels, image_size);
+
+				memcpy(result_pixels, pixels, image_size);
+				assert_int_equal(stream_application_interleaved(
+									 result_pixels, result_pixels, width, height,
+									 filters[i], num_threads),
+								 0);
+				assert_memory_equal(expected_pixels, result_pixels, image_size);
+			}
+		}
+	}
+
+	free(pixels);
+	free(expected_pixels);
+	free(result_pixels);
+	free_image_rgb(&channel_image);
+	free_image_rgb(&expected);
+	free_image_rgb(&result);
+	for (int i = 0; i < num_filters; i++) {
+		free_filter(&filters[i]);
+	}
+}
+
+/**
+ * Tests `parallel_split()` and `parallel_assemble()` against the scalar
+ * `split_image_into_rgb_channels()` and `assemble_image_from_rgb_channels()` using
+ * a randomly generated image.
+ */
+void test_parallel_split_assemble_with_random_image(void **state) {
+	(void)state;
+
+	int width = (rand() % UPPER_SIZE_LIMIT) + 1;
+	int height = (rand() % UPPER_SIZE_LIMIT) + 1;
+	printf("Testing with random image size: %d x %d\n", width, height);
+
+	struct image_rgb channel_image = create_test_image(width, height);
+	struct image_rgb result = initialize_and_check_image_rgb(width, height);
+	size_t num_pixels = (size_t)width * (size_t)height;
+
+	unsigned char *expected = malloc(3 * num_pixels);
+	unsigned char *actual = malloc(3 * num_pixels);
+	assert_non_null(expected);
+	assert_non_null(actual);
+
+	assemble_image_from_rgb_channels(expected, channel_image, width, height);
+
+	for (int num_threads = 1; num_threads <= 4; num_threads += 3) {
+		assert_int_equal(parallel_assemble(actual, &channel_image, width, height,
+										   num_threads),
+						 0);
+		assert_memory_equal(expected, actual, 3 * num_pixels);
+
+		assert_int_equal(
+			parallel_split(actual, &result, width, height, num_threads), 0);
+		assert_true(compare_channels(&channel_image, &result, width, height));
+	}
+
+	free(expected);
+	free(actual);
+	free_image_rgb(&channel_image);
+	free_image_rgb(&result);
+}
+
 int main(void) {
 	// Initialize random number generator with current time
 	srand((unsigned int)time(NULL));
@@ -205,6 +845,18 @@ int main(void) {
 		cmocka_unit_test(test_parallel_column_with_random_image),
 		cmocka_unit_test(test_parallel_block_with_default_image),
 		cmocka_unit_test(test_parallel_block_with_random_image),
+		cmocka_unit_test(test_parallel_schedules_with_random_image),
+		cmocka_unit_test(test_parallel_single_block_units_with_random_image),
+		cmocka_unit_test(test_parallel_filter_with_empty_image),
+		cmocka_unit_test(test_parallel_tile_with_default_image),
+		cmocka_unit_test(test_parallel_tile_with_random_image),
+		cmocka_unit_test(test_filter_chain_with_default_image),
+		cmocka_unit_test(test_filter_chain_with_random_image),
+		cmocka_unit_test(test_interleaved_chain_with_small_image),
+		cmocka_unit_test(test_parallel_border_modes_with_random_image),
+		cmocka_unit_test(test_parallel_box_sums_with_random_image),
+		cmocka_unit_test(test_stream_with_random_image),
+		cmocka_unit_test(test_parallel_split_assemble_with_random_image),
 	};
 
 	return cmocka_run_group_tests_name("Parallel Application Tests", parallel_tests,
@@ -1,9 +1,21 @@
+#include "../src/convolution/border.h"
 #include "../src/convolution/filter_application.h"
 #include "../src/convolution/parallel_dispatch.h"
 
 #include "utils_for_tests.h"
 
 #define MAX_RANDOM_FILTER_SIZE 9
+#define LARGE_KERNEL_SIZE 31
+#define FFT_TEST_SIZE_LIMIT 300 // The reference is slow with large kernels
+#define MAX_BOX_TEST_RADIUS 12
+#define BOX_TEST_SIZE_LIMIT 300 // The reference is slow with large kernels
+#define MOTION_TEST_LENGTH 40
+#define SHIFT_TEST_SIZE 7
+#define ENGINE_TEST_SIZE_LIMIT 600
+#define BORDER_TEST_RADIUS 3
+#define BORDER_TEST_LENGTH 9
+#define BORDER_TEST_SMALL_SIZE 8 // Smaller than the kernels, whose halo wraps
+#define BORDER_TEST_ENGINES 6	 // Engines per filter, the first one automatic
 
 // Filter composition tests
 
@@ -159,12 +171,7 @@ void test_filter_inverse_with_default_image(void **state) {
 	sequential_application(&channel_image, &result1, width, height, filter_right);
 	sequential_application(&result1, &result2, width, height, filter_left);
 
-	assert_memory_equal(channel_image.red, result2.red,
-						(size_t)width * (size_t)height);
-	assert_memory_equal(channel_image.green, result2.green,
-						(size_t)width * (size_t)height);
-	assert_memory_equal(channel_image.blue, result2.blue,
-						(size_t)width * (size_t)height);
+	assert_true(compare_channels(&channel_image, &result2, width, height));
 
 	stbi_image_free(image);
 	free_image_rgb(&channel_image);
@@ -247,10 +254,7 @@ void test_filter_zero_padding_with_default_image(void **state) {
 	sequential_application(&channel_image, &result1, width, height, filter);
 	sequential_application(&channel_image, &result2, width, height, padded_filter);
 
-	assert_memory_equal(result1.red, result2.red, (size_t)width * (size_t)height);
-	assert_memory_equal(result1.green, result2.green,
-						(size_t)width * (size_t)height);
-	assert_memory_equal(result1.blue, result2.blue, (size_t)width * (size_t)height);
+	assert_true(compare_channels(&result1, &result2, width, height));
 
 	stbi_image_free(image);
 	free_image_rgb(&channel_image);
@@ -305,6 +309,850 @@ void test_filter_zero_padding_with_random_image(void **state) {
 	free_filter(&padded_filter);
 }
 
+// Separable Filter Tests
+
+/**
+ * A helper function that applies a separable filter once with the two-pass engine
+ * and once with the direct 2D loop and checks that the results are identical.
+ */
+static void run_separable_test(struct image_rgb *channel_image, int width,
+							   int height) {
+	struct filter filter = create_filter(5, 1.0 / 256.0, 0.0, gaus_blur);
+	assert_non_null(filter.kernel);
+	assert_true(filter.separable);
+	// The integer weights would send the automatic choice to the fixed-point engine
+	filter.engine = FILTER_ENGINE_SEPARABLE;
+
+	struct image_rgb result1 = initialize_and_check_image_rgb(width, height);
+	struct image_rgb result2 = initialize_and_check_image_rgb(width, height);
+
+	sequential_fast_application(channel_image, &result1, width, height, filter);
+	sequential_application(channel_image, &result2, width, height, filter);
+
+	assert_true(compare_channels(&result1, &result2, width, height));
+
+	free_image_rgb(&result1);
+	free_image_rgb(&result2);
+	free_filter(&filter);
+}
+
+/**
+ * Tests the two-pass application of a separable filter (gaus_blur) against the
+ * direct one using a predefined default image (cat.bmp).
+ */
+void test_separable_filter_with_default_image(void **state) {
+	(void)state;
+
+	int width, height, channels;
+	unsigned char *image =
+		stbi_load("../../images/cat.bmp", &width, &height, &channels, 3);
+	assert_true(image);
+
+	struct image_rgb channel_image = initialize_and_check_image_rgb(width, height);
+	split_image_into_rgb_channels(image, channel_image, width, height);
+
+	run_separable_test(&channel_image, width, height);
+
+	stbi_image_free(image);
+	free_image_rgb(&channel_image);
+}
+
+/**
+ * Tests the two-pass application of a separable filter (gaus_blur) against the
+ * direct one using a randomly generated image.
+ */
+void test_separable_filter_with_random_image(void **state) {
+	(void)state;
+
+	int width = (rand() % UPPER_SIZE_LIMIT), height = (rand() % UPPER_SIZE_LIMIT);
+	printf("Testing with random image size: %d x %d\n", width, height);
+
+	struct image_rgb channel_image = create_test_image(width, height);
+
+	run_separable_test(&channel_image, width, height);
+
+	free_image_rgb(&channel_image);
+}
+
+// Fixed-Point Filter Tests
+
+/**
+ * A helper function that applies every integer-coefficient filter once with the
+ * fixed-point engine and once in floating point and checks that the results are
+ * identical.
+ */
+static void run_fixed_point_test(struct image_rgb *channel_image, int width,
+								 int height) {
+	struct filter filters[] = {
+		create_filter(BLUR_SIZE, BLUR_FACTOR, BLUR_BIAS, blur),
+		create_filter(MOTION_BLUR_SIZE, MOTION_BLUR_FACTOR, MOTION_BLUR_BIAS,
+					  motion_blur),
+		create_filter(EDGE_DETECTION_SIZE, EDGE_DETECTION_FACTOR,
+					  EDGE_DETECTION_BIAS, edge_detection),
+		create_filter(EMBOSS_SIZE, EMBOSS_FACTOR, EMBOSS_BIAS, emboss),
+	};
+
+	struct image_rgb result1 = initialize_and_check_image_rgb(width, height);
+	struct image_rgb result2 = initialize_and_check_image_rgb(width, height);
+
+	for (size_t i = 0; i < sizeof(filters) / sizeof(filters[0]); i++) {
+		assert_non_null(filters[i].kernel);
+		assert_true(filters[i].fixed_point);
+
+		sequential_fast_application(channel_image, &result1, width, height,
+									filters[i]);
+		sequential_application(channel_image, &result2, width, height, filters[i]);
+
+		assert_true(compare_channels(&result1, &result2, width, height));
+
+		free_filter(&filters[i]);
+	}
+
+	free_image_rgb(&result1);
+	free_image_rgb(&result2);
+}
+
+/**
+ * Tests the fixed-point application of the integer-coefficient filters against the
+ * floating-point one using a predefined default image (cat.bmp).
+ */
+void test_fixed_point_filters_with_default_image(void **state) {
+	(void)state;
+
+	int width, height, channels;
+	unsigned char *image =
+		stbi_load("../../images/cat.bmp", &width, &height, &channels, 3);
+	assert_true(image);
+
+	struct image_rgb channel_image = initialize_and_check_image_rgb(width, height);
+	split_image_into_rgb_channels(image, channel_image, width, height);
+
+	run_fixed_point_test(&channel_image, width, height);
+
+	stbi_image_free(image);
+	free_image_rgb(&channel_image);
+}
+
+/**
+ * Tests the fixed-point application of the integer-coefficient filters against the
+ * floating-point one using a randomly generated image.
+ */
+void test_fixed_point_filters_with_random_image(void **state) {
+	(void)state;
+
+	int width = (rand() % UPPER_SIZE_LIMIT), height = (rand() % UPPER_SIZE_LIMIT);
+	printf("Testing with random image size: %d x %d\n", width, height);
+
+	struct image_rgb channel_image = create_test_image(width, height);
+
+	run_fixed_point_test(&channel_image, width, height);
+
+	free_image_rgb(&channel_image);
+}
+
+// Sparse Filter Tests
+
+/**
+ * A helper function that applies a sparse floating-point filter (the composition of
+ * fast_blur and motion_blur) once over its non-zero taps and once with the direct 2D
+ * loop and checks that the results are identical.
+ */
+static void run_sparse_test(struct image_rgb *channel_image, int width,
+							int height) {
+	struct filter filter = compose_filters_from_params(
+		FAST_BLUR_SIZE, FAST_BLUR_FACTOR, FAST_BLUR_BIAS, fast_blur,
+		MOTION_BLUR_SIZE, MOTION_BLUR_FACTOR, MOTION_BLUR_BIAS, motion_blur);
+	assert_non_null(filter.kernel);
+	assert_true(filter.sparse);
+	assert_false(filter.fixed_point);
+
+	struct image_rgb result1 = initialize_and_check_image_rgb(width, height);
+	struct image_rgb result2 = initialize_and_check_image_rgb(width, height);
+
+	sequential_fast_application(channel_image, &result1, width, height, filter);
+	sequential_application(channel_image, &result2, width, height, filter);
+
+	assert_true(compare_channels(&result1, &result2, width, height));
+
+	free_image_rgb(&result1);
+	free_image_rgb(&result2);
+	free_filter(&filter);
+}
+
+/**
+ * Tests the sparse application against the direct one using a predefined default
+ * image (cat.bmp).
+ */
+void test_sparse_filter_with_default_image(void **state) {
+	(void)state;
+
+	int width, height, channels;
+	unsigned char *image =
+		stbi_load("../../images/cat.bmp", &width, &height, &channels, 3);
+	assert_true(image);
+
+	struct image_rgb channel_image = initialize_and_check_image_rgb(width, height);
+	split_image_into_rgb_channels(image, channel_image, width, height);
+
+	run_sparse_test(&channel_image, width, height);
+
+	stbi_image_free(image);
+	free_image_rgb(&channel_image);
+}
+
+/**
+ * Tests the sparse application against the direct one using a randomly generated
+ * image.
+ */
+void test_sparse_filter_with_random_image(void **state) {
+	(void)state;
+
+	int width = (rand() % UPPER_SIZE_LIMIT), height = (rand() % UPPER_SIZE_LIMIT);
+	printf("Testing with random image size: %d x %d\n", width, height);
+
+	struct image_rgb channel_image = create_test_image(width, height);
+
+	run_sparse_test(&channel_image, width, height);
+
+	free_image_rgb(&channel_image);
+}
+
+// Optimized Sequential Application Tests
+
+/**
+ * A helper function that applies dense floating-point filters (fast_blur and the
+ * composition of blur and gaus_blur) with the optimized sequential application and
+ * with the reference one and checks that the results are identical.
+ */
+static void run_seq_fast_test(struct image_rgb *channel_image, int width,
+							  int height) {
+	struct filter filters[] = {
+		create_filter(FAST_BLUR_SIZE, FAST_BLUR_FACTOR, FAST_BLUR_BIAS, fast_blur),
+		compose_filters_from_params(BLUR_SIZE, BLUR_FACTOR, BLUR_BIAS, blur,
+									GAUS_BLUR_SIZE, GAUS_BLUR_FACTOR,
+									GAUS_BLUR_BIAS, gaus_blur),
+	};
+
+	struct image_rgb result1 = initialize_and_check_image_rgb(width, height);
+	struct image_rgb result2 = initialize_and_check_image_rgb(width, height);
+
+	for (size_t i = 0; i < sizeof(filters) / sizeof(filters[0]); i++) {
+		assert_non_null(filters[i].kernel);
+		assert_false(filters[i].separable || filters[i].fixed_point ||
+					 filters[i].sparse);
+
+		sequential_fast_application(channel_image, &result1, width, height,
+									filters[i]);
+		sequential_application(channel_image, &result2, width, height, filters[i]);
+
+		assert_true(compare_channels(&result1, &result2, width, height));
+
+		free_filter(&filters[i]);
+	}
+
+	free_image_rgb(&result1);
+	free_image_rgb(&result2);
+}
+
+/**
+ * Tests the optimized sequential application against the reference one using a
+ * predefined default image (cat.bmp).
+ */
+void test_seq_fast_with_default_image(void **state) {
+	(void)state;
+
+	int width, height, channels;
+	unsigned char *image =
+		stbi_load("../../images/cat.bmp", &width, &height, &channels, 3);
+	assert_true(image);
+
+	struct image_rgb channel_image = initialize_and_check_image_rgb(width, height);
+	split_image_into_rgb_channels(image, channel_image, width, height);
+
+	run_seq_fast_test(&channel_image, width, height);
+
+	stbi_image_free(image);
+	free_image_rgb(&channel_image);
+}
+
+/**
+ * Tests the optimized sequential application against the reference one using a
+ * randomly generated image.
+ */
+void test_seq_fast_with_random_image(void **state) {
+	(void)state;
+
+	int width = (rand() % UPPER_SIZE_LIMIT), height = (rand() % UPPER_SIZE_LIMIT);
+	printf("Testing with random image size: %d x %d\n", width, height);
+
+	struct image_rgb channel_image = create_test_image(width, height);
+
+	run_seq_fast_test(&channel_image, width, height);
+
+	free_image_rgb(&channel_image);
+}
+
+// FFT-Based Convolution Tests
+
+/**
+ * A helper function that applies filters with the FFT engine and with the reference
+ * application. Filters with integer kernels must give identical results, the others
+ * may differ by one where a sum lies within rounding error of an integer.
+ */
+static void run_fft_test(struct image_rgb *channel_image, int width, int height) {
+	double large_kernel[LARGE_KERNEL_SIZE][LARGE_KERNEL_SIZE];
+	for (int i = 0; i < LARGE_KERNEL_SIZE; i++) {
+		for (int j = 0; j < LARGE_KERNEL_SIZE; j++) {
+			large_kernel[i][j] = (i * 7 + j * 3) % 5;
+		}
+	}
+
+	struct filter integer_filters[] = {
+		create_filter(GAUS_BLUR_SIZE, GAUS_BLUR_FACTOR, GAUS_BLUR_BIAS, gaus_blur),
+		create_filter(EMBOSS_SIZE, EMBOSS_FACTOR, EMBOSS_BIAS, emboss),
+		create_filter(MOTION_BLUR_SIZE, MOTION_BLUR_FACTOR, MOTION_BLUR_BIAS,
+					  motion_blur),
+		create_filter(LARGE_KERNEL_SIZE, 1.0 / 1860.0, 0.0, large_kernel),
+	};
+	struct filter fast_blur_filter =
+		create_filter(FAST_BLUR_SIZE, FAST_BLUR_FACTOR, FAST_BLUR_BIAS, fast_blur);
+
+	struct image_rgb result1 = initialize_and_check_image_rgb(width, height);
+	struct image_rgb result2 = initialize_and_check_image_rgb(width, height);
+
+	for (size_t i = 0; i < sizeof(integer_filters) / sizeof(integer_filters[0]);
+		 i++) {
+		assert_non_null(integer_filters[i].kernel);
+
+		integer_filters[i].engine = FILTER_ENGINE_FFT;
+		sequential_fast_application(channel_image, &result1, width, height,
+									integer_filters[i]);
+		sequential_application(channel_image, &result2, width, height,
+							   integer_filters[i]);
+
+		assert_true(compare_channels(&result1, &result2, width, height));
+
+		free_filter(&integer_filters[i]);
+	}
+
+	assert_non_null(fast_blur_filter.kernel);
+
+	fast_blur_filter.engine = FILTER_ENGINE_FFT;
+	sequential_fast_application(channel_image, &result1, width, height,
+								fast_blur_filter);
+	sequential_application(channel_image, &result2, width, height,
+						   fast_blur_filter);
+
+	assert_true(compare_channels_with_epsilon(&result1, &result2, width, height));
+	assert_true(compare_channels_with_epsilon(&result2, &result1, width, height));
+
+	free_filter(&fast_blur_filter);
+	free_image_rgb(&result1);
+	free_image_rgb(&result2);
+}
+
+/**
+ * Tests the FFT-based convolution against the reference application using a
+ * predefined default image (cat.bmp).
+ */
+void test_fft_with_default_image(void **state) {
+	(void)state;
+
+	int width, height, channels;
+	unsigned char *image =
+		stbi_load("../../images/cat.bmp", &width, &height, &channels, 3);
+	assert_true(image);
+
+	struct image_rgb channel_image = initialize_and_check_image_rgb(width, height);
+	split_image_into_rgb_channels(image, channel_image, width, height);
+
+	run_fft_test(&channel_image, width, height);
+
+	stbi_image_free(image);
+	free_image_rgb(&channel_image);
+}
+
+/**
+ * Tests the FFT-based convolution against the reference application using a
+ * randomly generated image, which may be smaller than the kernels.
+ */
+void test_fft_with_random_image(void **state) {
+	(void)state;
+
+	int width = (rand() % FFT_TEST_SIZE_LIMIT) + 1;
+	int height = (rand() % FFT_TEST_SIZE_LIMIT) + 1;
+	printf("Testing with random image size: %d x %d\n", width, height);
+
+	struct image_rgb channel_image = create_test_image(width, height);
+
+	run_fft_test(&channel_image, width, height);
+
+	free_image_rgb(&channel_image);
+}
+
+// Box Filter Tests
+
+/**
+ * A helper function that applies box filters of several radii with running sums and
+ * with the reference application and checks that the results are identical.
+ */
+static void run_box_test(struct image_rgb *channel_image, int width, int height) {
+	struct image_rgb result1 = initialize_and_check_image_rgb(width, height);
+	struct image_rgb result2 = initialize_and_check_image_rgb(width, height);
+
+	for (int radius = 1; radius <= MAX_BOX_TEST_RADIUS; radius += 3) {
+		struct filter filter = create_box_filter(radius);
+		assert_non_null(filter.kernel);
+		assert_true(filter.box);
+
+		sequential_fast_application(channel_image, &result1, width, height, filter);
+		sequential_application(channel_image, &result2, width, height, filter);
+
+		assert_true(compare_channels(&result1, &result2, width, height));
+
+		free_filter(&filter);
+	}
+
+	free_image_rgb(&result1);
+	free_image_rgb(&result2);
+}
+
+/**
+ * Tests the box filter against the reference application using a predefined default
+ * image (cat.bmp).
+ */
+void test_box_filter_with_default_image(void **state) {
+	(void)state;
+
+	int width, height, channels;
+	unsigned char *image =
+		stbi_load("../../images/cat.bmp", &width, &height, &channels, 3);
+	assert_true(image);
+
+	struct image_rgb channel_image = initialize_and_check_image_rgb(width, height);
+	split_image_into_rgb_channels(image, channel_image, width, height);
+
+	run_box_test(&channel_image, width, height);
+
+	stbi_image_free(image);
+	free_image_rgb(&channel_image);
+}
+
+/**
+ * Tests the box filter against the reference application using a randomly generated
+ * image.
+ */
+void test_box_filter_with_random_image(void **state) {
+	(void)state;
+
+	int width = (rand() % BOX_TEST_SIZE_LIMIT) + 1;
+	int height = (rand() % BOX_TEST_SIZE_LIMIT) + 1;
+	printf("Testing with random image size: %d x %d\n", width, height);
+
+	struct image_rgb channel_image = create_test_image(width, height);
+
+	run_box_test(&channel_image, width, height);
+
+	free_image_rgb(&channel_image);
+}
+
+// Motion Blur Tests
+
+/**
+ * A helper function that applies motion blurs of several directions with running
+ * sums and with the reference application and checks that the results are
+ * identical.
+ */
+static void run_motion_blur_test(struct image_rgb *channel_image, int width,
+								 int height) {
+	const double angles[] = {0.0, 90.0, -45.0, 30.0, 100.0, 200.0};
+
+	struct image_rgb result1 = initialize_and_check_image_rgb(width, height);
+	struct image_rgb result2 = initialize_and_check_image_rgb(width, height);
+
+	for (size_t i = 0; i < sizeof(angles) / sizeof(angles[0]); i++) {
+		struct filter filter =
+			create_motion_blur_filter(MOTION_TEST_LENGTH - (int)i, angles[i]);
+		assert_non_null(filter.kernel);
+		assert_true(filter.line);
+
+		sequential_fast_application(channel_image, &result1, width, height, filter);
+		sequential_application(channel_image, &result2, width, height, filter);
+
+		assert_true(compare_channels(&result1, &result2, width, height));
+
+		free_filter(&filter);
+	}
+
+	free_image_rgb(&result1);
+	free_image_rgb(&result2);
+}
+
+/**
+ * Tests motion blurs against the reference application using a predefined default
+ * image (cat.bmp).
+ */
+void test_motion_blur_with_default_image(void **state) {
+	(void)state;
+
+	int width, height, channels;
+	unsigned char *image =
+		stbi_load("../../images/cat.bmp", &width, &height, &channels, 3);
+	assert_true(image);
+
+	struct image_rgb channel_image = initialize_and_check_image_rgb(width, height);
+	split_image_into_rgb_channels(image, channel_image, width, height);
+
+	run_motion_blur_test(&channel_image, width, height);
+
+	stbi_image_free(image);
+	free_image_rgb(&channel_image);
+}
+
+/**
+ * Tests motion blurs against the reference application using a randomly generated
+ * image.
+ */
+void test_motion_blur_with_random_image(void **state) {
+	(void)state;
+
+	int width = (rand() % BOX_TEST_SIZE_LIMIT) + 1;
+	int height = (rand() % BOX_TEST_SIZE_LIMIT) + 1;
+	printf("Testing with random image size: %d x %d\n", width, height);
+
+	struct image_rgb channel_image = create_test_image(width, height);
+
+	run_motion_blur_test(&channel_image, width, height);
+
+	free_image_rgb(&channel_image);
+}
+
+// Shift Filter Tests
+
+/**
+ * A helper function that applies kernels with a single non-zero value (plain
+ * shifts, copies scaled by the factor and with a bias that saturates) with the
+ * shift engine and with the reference application and checks that the results are
+ * identical.
+ */
+static void run_shift_test(struct image_rgb *channel_image, int width, int height) {
+	const struct {
+		int y, x;
+		double value, factor, bias;
+	} shifts[] = {
+		{3, 3, 1.0, 1.0, 0.0},
+		{0, 6, 1.0, 1.0, 0.0},
+		{5, 1, 4.0, 0.25, 0.0},
+		{2, 4, 3.0, 0.5, 20.0},
+		{6, 0, -1.0, 1.0, 255.0},
+		{1, 2, 1.0, 2.0, -100.0},
+	};
+
+	struct image_rgb result1 = initialize_and_check_image_rgb(width, height);
+	struct image_rgb result2 = initialize_and_check_image_rgb(width, height);
+
+	for (size_t i = 0; i < sizeof(shifts) / sizeof(shifts[0]); i++) {
+		double kernel[SHIFT_TEST_SIZE][SHIFT_TEST_SIZE] = {{0.0}};
+		kernel[shifts[i].y][shifts[i].x] = shifts[i].value;
+
+		struct filter filter = create_filter(SHIFT_TEST_SIZE, shifts[i].factor,
+											 shifts[i].bias, kernel);
+		assert_non_null(filter.kernel);
+		assert_true(filter.shift);
+
+		sequential_fast_application(channel_image, &result1, width, height, filter);
+		sequential_application(channel_image, &result2, width, height, filter);
+
+		assert_true(compare_channels(&result1, &result2, width, height));
+
+		free_filter(&filter);
+	}
+
+	free_image_rgb(&result1);
+	free_image_rgb(&result2);
+}
+
+/**
+ * Tests the shift engine against the reference application using a predefined
+ * default image (cat.bmp).
+ */
+void test_shift_filter_with_default_image(void **state) {
+	(void)state;
+
+	int width, height, channels;
+	unsigned char *image =
+		stbi_load("../../images/cat.bmp", &width, &height, &channels, 3);
+	assert_true(image);
+
+	struct image_rgb channel_image = initialize_and_check_image_rgb(width, height);
+	split_image_into_rgb_channels(image, channel_image, width, height);
+
+	run_shift_test(&channel_image, width, height);
+
+	stbi_image_free(image);
+	free_image_rgb(&channel_image);
+}
+
+/**
+ * Tests the shift engine against the reference application using a randomly
+ * generated image, which may be smaller than the kernels.
+ */
+void test_shift_filter_with_random_image(void **state) {
+	(void)state;
+
+	int width = (rand() % UPPER_SIZE_LIMIT) + 1;
+	int height = (rand() % UPPER_SIZE_LIMIT) + 1;
+	printf("Testing with random image size: %d x %d\n", width, height);
+
+	struct image_rgb channel_image = create_test_image(width, height);
+
+	run_shift_test(&channel_image, width, height);
+
+	free_image_rgb(&channel_image);
+}
+
+// Forced Engine Tests
+
+/**
+ * A helper function that applies the Gaussian blur, which every engine but the
+ * running sums applies, with each engine forced in turn and checks that the results
+ * are identical to the reference application.
+ */
+static void run_forced_engine_test(struct image_rgb *channel_image, int width,
+								   int height) {
+	const enum filter_engine engines[] = {
+		FILTER_ENGINE_FFT, FILTER_ENGINE_SEPARABLE, FILTER_ENGINE_FIXED_POINT,
+		FILTER_ENGINE_SPARSE, FILTER_ENGINE_GENERIC};
+
+	struct image_rgb result1 = initialize_and_check_image_rgb(width, height);
+	struct image_rgb result2 = initialize_and_check_image_rgb(width, height);
+
+	struct filter filter = create_filter(GAUS_BLUR_SIZE, GAUS_BLUR_FACTOR,
+										 GAUS_BLUR_BIAS, gaus_blur);
+	assert_non_null(filter.kernel);
+
+	sequential_application(channel_image, &result2, width, height, filter);
+
+	for (size_t i = 0; i < sizeof(engines) / sizeof(engines[0]); i++) {
+		printf("Testing the %s engine\n", filter_engine_name(engines[i]));
+		filter.engine = engines[i];
+
+		sequential_fast_application(channel_image, &result1, width, height, filter);
+
+		assert_true(compare_channels(&result1, &result2, width, height));
+	}
+
+	free_filter(&filter);
+	free_image_rgb(&result1);
+	free_image_rgb(&result2);
+}
+
+/**
+ * Tests the forced engines against the reference application using a predefined
+ * default image (cat.bmp).
+ */
+void test_forced_engines_with_default_image(void **state) {
+	(void)state;
+
+	int width, height, channels;
+	unsigned char *image =
+		stbi_load("../../images/cat.bmp", &width, &height, &channels, 3);
+	assert_true(image);
+
+	struct image_rgb channel_image = initialize_and_check_image_rgb(width, height);
+	split_image_into_rgb_channels(image, channel_image, width, height);
+
+	run_forced_engine_test(&channel_image, width, height);
+
+	stbi_image_free(image);
+	free_image_rgb(&channel_image);
+}
+
+/**
+ * Tests the forced engines against the reference application using a randomly
+ * generated image.
+ */
+void test_forced_engines_with_random_image(void **state) {
+	(void)state;
+
+	int width = (rand() % ENGINE_TEST_SIZE_LIMIT) + 1;
+	int height = (rand() % ENGINE_TEST_SIZE_LIMIT) + 1;
+	printf("Testing with random image size: %d x %d\n", width, height);
+
+	struct image_rgb channel_image = create_test_image(width, height);
+
+	run_forced_engine_test(&channel_image, width, height);
+
+	free_image_rgb(&channel_image);
+}
+
+/**
+ * Applies a filter pixel by pixel, reading the taps outside the image with
+ * `border_position()` or as `BORDER_CONSTANT_VALUE`, in the order of the reference
+ * application, so the result is identical to it but independent of the halos.
+ */
+static void border_reference(const struct image_rgb *input, struct image_rgb *output,
+							 int width, int height, const struct filter *filter) {
+	const unsigned char *inputs[] = {input->red, input->green, input->blue};
+	unsigned char *outputs[] = {output->red, output->green, output->blue};
+	int radius = filter->size / 2;
+
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			double sums[3] = {0.0, 0.0, 0.0};
+
+			for (int filterY = 0; filterY < filter->size; filterY++) {
+				for (int filterX = 0; filterX < filter->size; filterX++) {
+					ptrdiff_t imageX = x - radius + filterX;
+					ptrdiff_t imageY = y - radius + filterY;
+					double weight = filter->kernel[filterY * filter->size + filterX];
+					bool outside = imageX < 0 || imageX >= width || imageY < 0 ||
+								   imageY >= height;
+
+					for (int c = 0; c < 3; c++) {
+						int value = BORDER_CONSTANT_VALUE;
+						if (!outside || filter->border != BORDER_CONSTANT) {
+							size_t index =
+								border_position(imageY, height, filter->border) *
+									input->stride +
+								border_position(imageX, width, filter->border);
+							value = inputs[c][index];
+						}
+						sums[c] += value * weight;
+					}
+				}
+			}
+
+			for (int c = 0; c < 3; c++) {
+				outputs[c][y * output->stride + x] = min(
+					max((int)(filter->factor * sums[c] + filter->bias), 0), 255);
+			}
+		}
+	}
+}
+
+/**
+ * A helper function that applies filters taken by different engines in every border
+ * mode, to the image and to a copy of it with a halo, and checks that the results
+ * of the reference application and of the forced engines are identical to those of
+ * `border_reference()`.
+ */
+static void run_border_mode_test(struct image_rgb *channel_image, int width,
+								 int height) {
+	struct {
+		struct filter filter;
+		enum filter_engine engines[BORDER_TEST_ENGINES];
+	} cases[] = {
+		{create_filter(GAUS_BLUR_SIZE, GAUS_BLUR_FACTOR, GAUS_BLUR_BIAS, gaus_blur),
+		 {FILTER_ENGINE_AUTO, FILTER_ENGINE_FFT, FILTER_ENGINE_SEPARABLE,
+		  FILTER_ENGINE_FIXED_POINT, FILTER_ENGINE_SPARSE, FILTER_ENGINE_GENERIC}},
+		{create_box_filter(BORDER_TEST_RADIUS),
+		 {FILTER_ENGINE_AUTO, FILTER_ENGINE_BOX, FILTER_ENGINE_GENERIC}},
+		{create_motion_blur_filter(BORDER_TEST_LENGTH, 30.0),
+		 {FILTER_ENGINE_AUTO, FILTER_ENGINE_LINE, FILTER_ENGINE_SPARSE}},
+		{create_filter(SHIFT_TEST_SIZE, 1.0, 0.0,
+					   (double[SHIFT_TEST_SIZE][SHIFT_TEST_SIZE]){[0][5] = 1.0}),
+		 {FILTER_ENGINE_AUTO, FILTER_ENGINE_SHIFT, FILTER_ENGINE_SPARSE}},
+	};
+
+	struct image_rgb expected = initialize_and_check_image_rgb(width, height);
+	struct image_rgb result = initialize_and_check_image_rgb(width, height);
+
+	for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+		struct filter *filter = &cases[i].filter;
+		assert_non_null(filter->kernel);
+
+		// A copy of the image with a halo, which the engines read directly
+		struct image_rgb padded =
+			initialize_padded_image_rgb(width, height, filter->size / 2);
+		assert_non_null(padded.red);
+		for (size_t y = 0; y < (size_t)height; y++) {
+			memcpy(padded.red + y * padded.stride,
+				   channel_image->red + y * channel_image->stride, width);
+			memcpy(padded.green + y * padded.stride,
+				   channel_image->green + y * channel_image->stride, width);
+			memcpy(padded.blue + y * padded.stride,
+				   channel_image->blue + y * channel_image->stride, width);
+		}
+
+		for (int border = BORDER_WRAP; border < NUM_BORDER_MODES; border++) {
+			printf("Testing the %s border of filter %zu\n",
+				   border_mode_name(border), i);
+			filter->border = border;
+			filter->engine = FILTER_ENGINE_AUTO;
+
+			border_reference(channel_image, &expected, width, height, filter);
+
+			sequential_application(channel_image, &result, width, height, *filter);
+			assert_true(compare_channels(&expected, &result, width, height));
+
+			for (size_t e = 0; e < BORDER_TEST_ENGINES; e++) {
+				if (e > 0 && cases[i].engines[e] == FILTER_ENGINE_AUTO) {
+					break;
+				}
+				filter->engine = cases[i].engines[e];
+
+				sequential_fast_application(channel_image, &result, width, height,
+											*filter);
+				assert_true(compare_channels(&expected, &result, width, height));
+
+				sequential_fast_application(&padded, &result, width, height,
+											*filter);
+				assert_true(compare_channels(&expected, &result, width, height));
+			}
+		}
+
+		free_image_rgb(&padded);
+		free_filter(filter);
+	}
+
+	free_image_rgb(&expected);
+	free_image_rgb(&result);
+}
+
+/**
+ * Tests the border modes against a naive reference using a predefined default image
+ * (cat.bmp).
+ */
+void test_border_modes_with_default_image(void **state) {
+	(void)state;
+
+	int width, height, channels;
+	unsigned char *image =
+		stbi_load("../../images/cat.bmp", &width, &height, &channels, 3);
+	assert_true(image);
+
+	struct image_rgb channel_image = initialize_and_check_image_rgb(width, height);
+	split_image_into_rgb_channels(image, channel_image, width, height);
+
+	run_border_mode_test(&channel_image, width, height);
+
+	stbi_image_free(image);
+	free_image_rgb(&channel_image);
+}
+
+/**
+ * Tests the border modes against a naive reference using randomly generated images,
+ * one of them smaller than the kernels.
+ */
+void test_border_modes_with_random_image(void **state) {
+	(void)state;
+
+	int sizes[] = {ENGINE_TEST_SIZE_LIMIT, BORDER_TEST_SMALL_SIZE};
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		int width = (rand() % sizes[i]) + 1;
+		int height = (rand() % sizes[i]) + 1;
+		printf("Testing with random image size: %d x %d\n", width, height);
+
+		struct image_rgb channel_image = create_test_image(width, height);
+
+		run_border_mode_test(&channel_image, width, height);
+
+		free_image_rgb(&channel_image);
+	}
+}
+
 int main(void) {
 	// Initialize random number generator with current time
 	srand((unsigned int)time(NULL));
@@ -316,6 +1164,26 @@ int main(void) {
 		cmocka_unit_test(test_filter_inverse_with_random_image),
 		cmocka_unit_test(test_filter_zero_padding_with_default_image),
 		cmocka_unit_test(test_filter_zero_padding_with_random_image),
+		cmocka_unit_test(test_separable_filter_with_default_image),
+		cmocka_unit_test(test_separable_filter_with_random_image),
+		cmocka_unit_test(test_fixed_point_filters_with_default_image),
+		cmocka_unit_test(test_fixed_point_filters_with_random_image),
+		cmocka_unit_test(test_sparse_filter_with_default_image),
+		cmocka_unit_test(test_sparse_filter_with_random_image),
+		cmocka_unit_test(test_seq_fast_with_default_image),
+		cmocka_unit_test(test_seq_fast_with_random_image),
+		cmocka_unit_test(test_fft_with_default_image),
+		cmocka_unit_test(test_fft_with_random_image),
+		cmocka_unit_test(test_box_filter_with_default_image),
+		cmocka_unit_test(test_box_filter_with_random_image),
+		cmocka_unit_test(test_motion_blur_with_default_image),
+		cmocka_unit_test(test_motion_blur_with_random_image),
+		cmocka_unit_test(test_shift_filter_with_default_image),
+		cmocka_unit_test(test_shift_filter_with_random_image),
+		cmocka_unit_test(test_forced_engines_with_default_image),
+		cmocka_unit_test(test_forced_engines_with_random_image),
+		cmocka_unit_test(test_border_modes_with_default_image),
+		cmocka_unit_test(test_border_modes_with_random_image),
 	};
 
 	return cmocka_run_group_tests_name("Sequential Application Tests",
@@ -1,9 +1,28 @@
+#include "../src/convolution/autotune.h"
+#include "../src/convolution/border.h"
+#include "../src/convolution/chain.h"
+#include "../src/convolution/dispatch.h"
+#include "../src/convolution/fft.h"
 #include "../src/convolution/filter_application.h"
+#include "../src/convolution/simd.h"
+#include "../src/utils/thread_pool.h"
+#include "../src/utils/work_deque.h"
 
 #include "utils_for_tests.h"
 
 #define IMAGE_WIDTH 2
 #define IMAGE_HEIGHT 2
+#define SIMD_TEST_WIDTH 301 // Not a multiple of the vector width to cover the tail
+#define LARGE_KERNEL_SIZE 31
+#define LINE_TEST_LENGTH 64
+#define POOL_TEST_TASKS 64
+#define POOL_TEST_NESTED 4
+#define DEQUE_TEST_ITEMS 10000
+#define DEQUE_TEST_THREADS 4
+#define AFFINITY_TEST_THREADS 4
+#define AUTOTUNE_TEST_DIR "autotune_test"
+#define AUTOTUNE_TEST_PROFILE AUTOTUNE_TEST_DIR "/autotune.profile"
+#define BORDER_TEST_HALO 7 // Wider than the test image
 
 unsigned char test_image[] = {
 	255, 0, 0,	 0,	  255, 0,  // red green
@@ -25,13 +44,804 @@ void test_create_filter(void **state) {
 
 	for (int i = 0; i < 3; i++) {
 		for (int j = 0; j < 3; j++) {
-			assert_double_equal(filter.kernel[i][j], id[i][j], 1e-6);
+			assert_double_equal(filter.kernel[i * 3 + j], id[i][j], 1e-6);
 		}
 	}
 
 	free_filter(&filter);
 }
 
+/**
+ * Tests that the kernel is stored in a single aligned block together with its shadow
+ * copies and that its metadata is precomputed.
+ */
+void test_filter_storage(void **state) {
+	(void)state;
+
+	struct filter emboss_filter =
+		create_filter(EMBOSS_SIZE, EMBOSS_FACTOR, EMBOSS_BIAS, emboss);
+	assert_non_null(emboss_filter.kernel);
+	assert_int_equal((uintptr_t)emboss_filter.kernel % FILTER_ALIGNMENT, 0);
+	assert_int_equal((uintptr_t)emboss_filter.float_kernel % FILTER_ALIGNMENT, 0);
+	assert_int_equal((uintptr_t)emboss_filter.fixed_kernel % FILTER_ALIGNMENT, 0);
+
+	for (int i = 0; i < EMBOSS_SIZE; i++) {
+		for (int j = 0; j < EMBOSS_SIZE; j++) {
+			int index = i * EMBOSS_SIZE + j;
+			assert_double_equal(emboss_filter.kernel[index], emboss[i][j], 1e-12);
+			assert_double_equal(emboss_filter.float_kernel[index], emboss[i][j],
+								1e-12);
+			assert_int_equal(emboss_filter.fixed_kernel[index], emboss[i][j]);
+		}
+	}
+
+	assert_double_equal(emboss_filter.sum, 0.0, 1e-12);
+	assert_false(emboss_filter.symmetric);
+	assert_int_equal(emboss_filter.num_taps, 20);
+
+	struct filter fast_blur_filter =
+		create_filter(FAST_BLUR_SIZE, FAST_BLUR_FACTOR, FAST_BLUR_BIAS, fast_blur);
+	assert_non_null(fast_blur_filter.kernel);
+	assert_null(fast_blur_filter.fixed_kernel);
+	assert_double_equal(fast_blur_filter.sum, 1.0, 1e-12);
+	assert_true(fast_blur_filter.symmetric);
+
+	free_filter(&emboss_filter);
+	free_filter(&fast_blur_filter);
+}
+
+/**
+ * Tests that `create_box_filter()` creates a normalized kernel of ones and that only
+ * kernels of equal integer values are detected as boxes.
+ */
+void test_box_filter_detection(void **state) {
+	(void)state;
+
+	struct filter box_filter = create_box_filter(BOX_BLUR_RADIUS);
+	assert_non_null(box_filter.kernel);
+	assert_int_equal(box_filter.size, 2 * BOX_BLUR_RADIUS + 1);
+	assert_true(box_filter.box);
+	assert_double_equal(box_filter.factor * box_filter.sum, 1.0, 1e-12);
+
+	struct filter blur_filter =
+		create_filter(BLUR_SIZE, BLUR_FACTOR, BLUR_BIAS, blur);
+	assert_non_null(blur_filter.kernel);
+	assert_false(blur_filter.box);
+
+	const double halves[3][3] = {{0.5, 0.5, 0.5}, {0.5, 0.5, 0.5}, {0.5, 0.5, 0.5}};
+	struct filter halves_filter = create_filter(3, 1.0, 0.0, halves);
+	assert_non_null(halves_filter.kernel);
+	assert_false(halves_filter.box);
+
+	free_filter(&box_filter);
+	free_filter(&blur_filter);
+	free_filter(&halves_filter);
+}
+
+/**
+ * Tests that `create_motion_blur_filter()` rasterizes the line like `motion_blur`
+ * and that line filters slide along their direction with few taps.
+ */
+void test_motion_blur_filter(void **state) {
+	(void)state;
+
+	struct filter default_filter =
+		create_motion_blur_filter(MOTION_BLUR_LENGTH, MOTION_BLUR_ANGLE);
+	assert_non_null(default_filter.kernel);
+	assert_int_equal(default_filter.size, MOTION_BLUR_SIZE);
+	assert_double_equal(default_filter.factor, MOTION_BLUR_FACTOR, 1e-12);
+	for (int i = 0; i < MOTION_BLUR_SIZE; i++) {
+		for (int j = 0; j < MOTION_BLUR_SIZE; j++) {
+			assert_double_equal(default_filter.kernel[i * MOTION_BLUR_SIZE + j],
+								motion_blur[i][j], 0.0);
+		}
+	}
+
+	assert_true(default_filter.line);
+	assert_int_equal(default_filter.slides[0].dx, 1);
+	assert_int_equal(default_filter.slides[0].dy, 1);
+	assert_int_equal(default_filter.slides[0].num_taps, 2);
+
+	struct filter long_filter = create_motion_blur_filter(64, 0.0);
+	assert_non_null(long_filter.kernel);
+	assert_int_equal(long_filter.size, 65);
+	assert_int_equal(long_filter.num_taps, 64);
+	assert_true(long_filter.line);
+	assert_int_equal(long_filter.slides[0].dx, 1);
+	assert_int_equal(long_filter.slides[0].dy, 0);
+	assert_int_equal(long_filter.slides[0].num_taps, 2);
+
+	// A line of slope 1/3 repeats every 3 rows, so 3 taps enter and 3 leave
+	struct filter steep_filter = create_motion_blur_filter(31, 90.0 + 18.435);
+	assert_non_null(steep_filter.kernel);
+	assert_true(steep_filter.line);
+	assert_int_equal(steep_filter.slides[0].dx, 1);
+	assert_int_equal(steep_filter.slides[0].dy, 3);
+	assert_int_equal(steep_filter.slides[0].num_taps, 6);
+
+	struct filter fast_blur_filter =
+		create_filter(FAST_BLUR_SIZE, FAST_BLUR_FACTOR, FAST_BLUR_BIAS, fast_blur);
+	assert_non_null(fast_blur_filter.kernel);
+	assert_false(fast_blur_filter.line);
+
+	free_filter(&default_filter);
+	free_filter(&long_filter);
+	free_filter(&steep_filter);
+	free_filter(&fast_blur_filter);
+}
+
+/**
+ * Tests that `create_filter()` factors rank-1 kernels into a row and a column and
+ * leaves the others non-separable.
+ */
+void test_separable_filter_detection(void **state) {
+	(void)state;
+
+	const double expected_factor[5] = {1, 4, 6, 4, 1};
+
+	struct filter gaus_filter = create_filter(5, 1.0 / 256.0, 0.0, gaus_blur);
+	assert_non_null(gaus_filter.kernel);
+	assert_true(gaus_filter.separable);
+
+	for (int i = 0; i < 5; i++) {
+		assert_double_equal(gaus_filter.row[i], expected_factor[i], 1e-12);
+		assert_double_equal(gaus_filter.column[i], expected_factor[i], 1e-12);
+	}
+
+	struct filter blur_filter = create_filter(5, 1.0 / 13.0, 0.0, blur);
+	assert_non_null(blur_filter.kernel);
+	assert_false(blur_filter.separable);
+	assert_null(blur_filter.row);
+	assert_null(blur_filter.column);
+
+	free_filter(&gaus_filter);
+	free_filter(&blur_filter);
+}
+
+/**
+ * Tests that `create_filter()` collects the non-zero kernel values in row-major
+ * order and marks kernels with few of them as sparse.
+ */
+void test_sparse_filter_taps(void **state) {
+	(void)state;
+
+	struct filter motion_filter =
+		create_filter(MOTION_BLUR_SIZE, MOTION_BLUR_FACTOR, MOTION_BLUR_BIAS,
+					  motion_blur);
+	assert_non_null(motion_filter.kernel);
+	assert_true(motion_filter.sparse);
+	assert_int_equal(motion_filter.num_taps, MOTION_BLUR_SIZE);
+
+	for (int i = 0; i < motion_filter.num_taps; i++) {
+		assert_int_equal(motion_filter.taps[i].dy, i - MOTION_BLUR_SIZE / 2);
+		assert_int_equal(motion_filter.taps[i].dx, i - MOTION_BLUR_SIZE / 2);
+		assert_double_equal(motion_filter.taps[i].weight, 1.0, 1e-12);
+	}
+
+	struct filter blur_filter =
+		create_filter(BLUR_SIZE, BLUR_FACTOR, BLUR_BIAS, blur);
+	assert_non_null(blur_filter.kernel);
+	assert_false(blur_filter.sparse);
+	assert_int_equal(blur_filter.num_taps, 13);
+
+	free_filter(&motion_filter);
+	free_filter(&blur_filter);
+}
+
+/**
+ * Tests that `create_filter()` enables the fixed-point path only for integer kernels
+ * and that its multiply-shift reproduces the floating-point scaling.
+ */
+void test_fixed_point_filter_detection(void **state) {
+	(void)state;
+
+	struct filter blur_filter = create_filter(5, 1.0 / 13.0, 0.0, blur);
+	assert_non_null(blur_filter.kernel);
+	assert_true(blur_filter.fixed_point);
+
+	for (int i = 0; i < blur_filter.num_taps; i++) {
+		assert_int_equal(blur_filter.taps[i].fixed_weight, 1);
+	}
+
+	for (int32_t sum = 0; sum <= 13 * 255; sum++) {
+		assert_int_equal((sum * blur_filter.fixed_multiplier +
+						  blur_filter.fixed_offset) >>
+							 blur_filter.fixed_shift,
+						 sum / 13);
+	}
+
+	// A negative factor rounds its multiplier away from zero on one side, and the
+	// products still have to fit into `int32_t`
+	struct filter inverted_filter = create_filter(5, -1.0 / 13.0, 255.0, blur);
+	assert_non_null(inverted_filter.kernel);
+	assert_true(inverted_filter.fixed_point);
+
+	for (int64_t sum = 0; sum <= 13 * 255; sum++) {
+		int64_t product =
+			sum * inverted_filter.fixed_multiplier + inverted_filter.fixed_offset;
+		assert_true(product >= INT32_MIN && product <= INT32_MAX);
+		assert_int_equal(product >> inverted_filter.fixed_shift,
+						 (int)(-1.0 / 13.0 * (double)sum + 255.0));
+	}
+
+	struct filter fast_blur_filter = create_filter(3, 1.0, 0.0, fast_blur);
+	assert_non_null(fast_blur_filter.kernel);
+	assert_false(fast_blur_filter.fixed_point);
+
+	free_filter(&blur_filter);
+	free_filter(&inverted_filter);
+	free_filter(&fast_blur_filter);
+}
+
+/**
+ * Tests that every vectorized fixed-point row kernel supported by the CPU produces
+ * exactly the same output as the scalar reference kernel.
+ */
+void test_simd_fixed_point_rows(void **state) {
+	(void)state;
+
+	struct filter filters[] = {
+		create_filter(BLUR_SIZE, BLUR_FACTOR, BLUR_BIAS, blur),
+		create_filter(MOTION_BLUR_SIZE, MOTION_BLUR_FACTOR, MOTION_BLUR_BIAS,
+					  motion_blur),
+		create_filter(EDGE_DETECTION_SIZE, EDGE_DETECTION_FACTOR,
+					  EDGE_DETECTION_BIAS, edge_detection),
+		create_filter(EMBOSS_SIZE, EMBOSS_FACTOR, EMBOSS_BIAS, emboss),
+	};
+
+	unsigned char input[MOTION_BLUR_SIZE * SIMD_TEST_WIDTH];
+	for (size_t i = 0; i < sizeof(input); i++) {
+		input[i] = rand() % 256;
+	}
+
+	unsigned char expected[SIMD_TEST_WIDTH];
+	unsigned char actual[SIMD_TEST_WIDTH];
+
+	for (size_t i = 0; i < sizeof(filters) / sizeof(filters[0]); i++) {
+		assert_true(filters[i].fixed_point);
+		size_t count = SIMD_TEST_WIDTH - filters[i].size + 1;
+		const unsigned char *center =
+			input + (filters[i].size / 2) * (SIMD_TEST_WIDTH + 1);
+
+		get_fixed_point_row(SIMD_NONE)(center, SIMD_TEST_WIDTH, expected, count,
+									   &filters[i]);
+
+		for (int level = SIMD_SSE41; level <= (int)detect_simd_level(); level++) {
+			printf("Testing %s kernel of filter %zu\n", simd_level_name(level), i);
+			get_fixed_point_row(level)(center, SIMD_TEST_WIDTH, actual, count,
+									   &filters[i]);
+			assert_memory_equal(expected, actual, count);
+		}
+
+		free_filter(&filters[i]);
+	}
+}
+
+/**
+ * Tests that every vectorized line row kernel supported by the CPU continues the
+ * running sums exactly like the scalar reference kernel.
+ */
+void test_simd_line_rows(void **state) {
+	(void)state;
+
+	struct filter filter = create_motion_blur_filter(LINE_TEST_LENGTH, 30.0);
+	assert_true(filter.line);
+	const struct filter_slide *slide = &filter.slides[0];
+
+	unsigned char input[SIMD_TEST_WIDTH];
+	int32_t previous[SIMD_TEST_WIDTH];
+	for (size_t i = 0; i < SIMD_TEST_WIDTH; i++) {
+		input[i] = rand() % 256;
+		previous[i] = rand() % (LINE_TEST_LENGTH * 256);
+	}
+
+	const unsigned char *lines[slide->num_taps];
+	int32_t weights[slide->num_taps];
+	for (int i = 0; i < slide->num_taps; i++) {
+		lines[i] = input + rand() % (SIMD_TEST_WIDTH / 2);
+		weights[i] = slide->taps[i].fixed_weight;
+	}
+
+	size_t count = SIMD_TEST_WIDTH / 2;
+	int32_t expected_sums[SIMD_TEST_WIDTH], actual_sums[SIMD_TEST_WIDTH];
+	unsigned char expected[SIMD_TEST_WIDTH], actual[SIMD_TEST_WIDTH];
+
+	get_line_row(SIMD_NONE)(lines, weights, slide->num_taps, previous,
+							expected_sums, expected, count, &filter);
+
+	for (int level = SIMD_SSE41; level <= (int)detect_simd_level(); level++) {
+		printf("Testing %s line kernel\n", simd_level_name(level));
+		get_line_row(level)(lines, weights, slide->num_taps, previous, actual_sums,
+							actual, count, &filter);
+		assert_memory_equal(expected_sums, actual_sums, count * sizeof(int32_t));
+		assert_memory_equal(expected, actual, count);
+	}
+
+	free_filter(&filter);
+}
+
+/**
+ * Tests that the vectorized kernels splitting interleaved pixels into channels and
+ * combining them back give the same results as the scalar ones.
+ */
+void test_simd_channel_kernels(void **state) {
+	(void)state;
+
+	unsigned char pixels[3 * SIMD_TEST_WIDTH], actual_pixels[3 * SIMD_TEST_WIDTH];
+	for (size_t i = 0; i < 3 * SIMD_TEST_WIDTH; i++) {
+		pixels[i] = rand() % 256;
+	}
+
+	unsigned char expected[3][SIMD_TEST_WIDTH], actual[3][SIMD_TEST_WIDTH];
+	get_deinterleave(SIMD_NONE)(pixels, expected[0], expected[1], expected[2],
+								SIMD_TEST_WIDTH);
+
+	for (size_t i = 0; i < SIMD_TEST_WIDTH; i++) {
+		assert_int_equal(expected[1][i], pixels[3 * i + 1]);
+	}
+
+	for (int level = SIMD_NONE; level <= (int)detect_simd_level(); level++) {
+		printf("Testing %s channel kernels\n", simd_level_name(level));
+		get_deinterleave(level)(pixels, actual[0], actual[1], actual[2],
+								SIMD_TEST_WIDTH);
+		assert_memory_equal(expected, actual, sizeof(expected));
+
+		get_interleave(level)(actual[0], actual[1], actual[2], actual_pixels,
+							  SIMD_TEST_WIDTH);
+		assert_memory_equal(pixels, actual_pixels, sizeof(pixels));
+	}
+}
+
+/**
+ * Tests the computation of the interior range, where no kernel tap wraps around the
+ * image border.
+ */
+void test_interior_bounds(void **state) {
+	(void)state;
+
+	size_t begin, end;
+
+	interior_bounds(5, 100, &begin, &end);
+	assert_int_equal(begin, 2);
+	assert_int_equal(end, 98);
+
+	interior_bounds(4, 100, &begin, &end);
+	assert_int_equal(begin, 2);
+	assert_int_equal(end, 99);
+
+	interior_bounds(9, 3, &begin, &end);
+	assert_int_equal(begin, end);
+}
+
+/**
+ * Tests that the cost model chooses FFT-based convolution for large kernels over
+ * large regions only, and that the automatic choice only picks it for kernels of
+ * integer values, where it is exact.
+ */
+void test_fft_crossover(void **state) {
+	(void)state;
+
+	double kernel[LARGE_KERNEL_SIZE][LARGE_KERNEL_SIZE];
+	double integer_kernel[LARGE_KERNEL_SIZE][LARGE_KERNEL_SIZE];
+	for (int i = 0; i < LARGE_KERNEL_SIZE; i++) {
+		for (int j = 0; j < LARGE_KERNEL_SIZE; j++) {
+			kernel[i][j] = 1.0 / (1 + i + j);
+			integer_kernel[i][j] = (i * 7 + j * 3) % 5;
+		}
+	}
+
+	struct filter large_filter = create_filter(LARGE_KERNEL_SIZE, 1.0, 0.0, kernel);
+	assert_non_null(large_filter.kernel);
+	assert_true(fft_is_cheaper(&large_filter, 1000, 1000));
+	assert_false(fft_is_cheaper(&large_filter, 1000, 1));
+	assert_false(fft_is_cheaper(&large_filter, 1, 1));
+
+	assert_false(fft_is_exact(&large_filter));
+	assert_int_not_equal(choose_engine(&large_filter, 1000, 1000),
+						 FILTER_ENGINE_FFT);
+	large_filter.engine = FILTER_ENGINE_FFT;
+	assert_int_equal(choose_engine(&large_filter, 1000, 1000), FILTER_ENGINE_FFT);
+
+	struct filter integer_filter =
+		create_filter(LARGE_KERNEL_SIZE, 1.0 / 1860.0, 0.0, integer_kernel);
+	assert_non_null(integer_filter.kernel);
+	assert_true(fft_is_exact(&integer_filter));
+	assert_int_equal(choose_engine(&integer_filter, 1000, 1000),
+					 FILTER_ENGINE_FFT);
+
+	struct filter fast_blur_filter =
+		create_filter(FAST_BLUR_SIZE, FAST_BLUR_FACTOR, FAST_BLUR_BIAS, fast_blur);
+	assert_non_null(fast_blur_filter.kernel);
+	assert_false(fft_is_cheaper(&fast_blur_filter, 1000, 1000));
+
+	free_filter(&large_filter);
+	free_filter(&integer_filter);
+	free_filter(&fast_blur_filter);
+}
+
+/**
+ * Tests the classification of kernels with a single non-zero value and the rank of
+ * the kernels.
+ */
+void test_kernel_classification(void **state) {
+	(void)state;
+
+	struct filter id_filter = create_filter(ID_SIZE, ID_FACTOR, ID_BIAS, id);
+	assert_non_null(id_filter.kernel);
+	assert_true(id_filter.shift);
+	assert_true(id_filter.shift_copy);
+	assert_int_equal(id_filter.taps[0].dx, 0);
+	assert_int_equal(id_filter.taps[0].dy, 0);
+	assert_int_equal(id_filter.rank, 1);
+
+	// `2 * 0.5` copies the pixel up and to the right, a bias saturates
+	double shift_kernel[3][3] = {{0, 0, 2}, {0, 0, 0}, {0, 0, 0}};
+	struct filter shift_filter = create_filter(3, 0.5, 0.0, shift_kernel);
+	assert_non_null(shift_filter.kernel);
+	assert_true(shift_filter.shift);
+	assert_true(shift_filter.shift_copy);
+	assert_int_equal(shift_filter.taps[0].dx, 1);
+	assert_int_equal(shift_filter.taps[0].dy, -1);
+
+	struct filter bias_filter = create_filter(3, 0.5, 200.0, shift_kernel);
+	assert_non_null(bias_filter.kernel);
+	assert_true(bias_filter.shift);
+	assert_false(bias_filter.shift_copy);
+	assert_int_equal(bias_filter.shift_table[0], 200);
+	assert_int_equal(bias_filter.shift_table[55], 255);
+	assert_int_equal(bias_filter.shift_table[255], 255);
+
+	struct filter blur_filter =
+		create_filter(BLUR_SIZE, BLUR_FACTOR, BLUR_BIAS, blur);
+	assert_non_null(blur_filter.kernel);
+	assert_false(blur_filter.shift);
+	assert_null(blur_filter.shift_table);
+	assert_int_equal(blur_filter.rank, 3);
+
+	struct filter gaus_filter =
+		create_filter(GAUS_BLUR_SIZE, GAUS_BLUR_FACTOR, GAUS_BLUR_BIAS, gaus_blur);
+	assert_non_null(gaus_filter.kernel);
+	assert_int_equal(gaus_filter.rank, 1);
+
+	char description[128];
+	describe_filter(&id_filter, description, sizeof(description));
+	assert_string_equal(description, "3x3, 1 tap, rank 1, identity, shift, "
+									 "separable, sparse, symmetric, integer");
+
+	free_filter(&id_filter);
+	free_filter(&shift_filter);
+	free_filter(&bias_filter);
+	free_filter(&blur_filter);
+	free_filter(&gaus_filter);
+}
+
+/**
+ * Tests that each filter is routed to the engine expected to be the fastest, also
+ * for regions too small to amortize the setup of an engine, that forced engines are
+ * used if they apply the filter and that engine names round trip.
+ */
+void test_engine_choice(void **state) {
+	(void)state;
+
+	struct filter id_filter = create_filter(ID_SIZE, ID_FACTOR, ID_BIAS, id);
+	struct filter fast_blur_filter =
+		create_filter(FAST_BLUR_SIZE, FAST_BLUR_FACTOR, FAST_BLUR_BIAS, fast_blur);
+	struct filter gaus_filter =
+		create_filter(GAUS_BLUR_SIZE, GAUS_BLUR_FACTOR, GAUS_BLUR_BIAS, gaus_blur);
+	struct filter box_filter = create_box_filter(BOX_BLUR_RADIUS);
+	struct filter motion_filter =
+		create_motion_blur_filter(MOTION_BLUR_LENGTH, MOTION_BLUR_ANGLE);
+	assert_non_null(id_filter.kernel);
+	assert_non_null(fast_blur_filter.kernel);
+	assert_non_null(gaus_filter.kernel);
+	assert_non_null(box_filter.kernel);
+	assert_non_null(motion_filter.kernel);
+
+	assert_int_equal(choose_engine(&id_filter, 1000, 1000), FILTER_ENGINE_SHIFT);
+	assert_int_equal(choose_engine(&fast_blur_filter, 1000, 1000),
+					 FILTER_ENGINE_SPARSE);
+	assert_int_equal(choose_engine(&gaus_filter, 1000, 1000),
+					 FILTER_ENGINE_FIXED_POINT);
+	assert_int_equal(choose_engine(&box_filter, 1000, 1000), FILTER_ENGINE_BOX);
+	assert_int_equal(choose_engine(&motion_filter, 1000, 1000), FILTER_ENGINE_LINE);
+
+	// The column sums of a box filter are rebuilt for every region, which single
+	// pixels do not amortize
+	assert_int_not_equal(choose_engine(&box_filter, 1, 1), FILTER_ENGINE_BOX);
+	assert_true(engine_cost(&box_filter, FILTER_ENGINE_BOX, 1, 1000) >
+				engine_cost(&box_filter, FILTER_ENGINE_BOX, 1000, 1));
+
+	// Summed-area tables take over from the running sums for such regions only
+	assert_true(box_sums_are_cheaper(&box_filter, 1, 1));
+	assert_true(box_sums_are_cheaper(&box_filter, 1000, 1));
+	assert_false(box_sums_are_cheaper(&box_filter, 1000, 1000));
+	assert_false(box_sums_are_cheaper(&gaus_filter, 1000, 1));
+
+	gaus_filter.engine = FILTER_ENGINE_SEPARABLE;
+	assert_int_equal(choose_engine(&gaus_filter, 1000, 1000),
+					 FILTER_ENGINE_SEPARABLE);
+
+	// The box engine does not apply the Gaussian blur
+	gaus_filter.engine = FILTER_ENGINE_BOX;
+	assert_false(engine_applies(&gaus_filter, FILTER_ENGINE_BOX));
+	assert_int_equal(choose_engine(&gaus_filter, 1000, 1000),
+					 FILTER_ENGINE_FIXED_POINT);
+
+	for (int i = 0; i < NUM_FILTER_ENGINES; i++) {
+		enum filter_engine engine = FILTER_ENGINE_AUTO;
+		assert_true(parse_filter_engine(filter_engine_name(i), &engine));
+		assert_int_equal(engine, i);
+	}
+
+	enum filter_engine engine = FILTER_ENGINE_AUTO;
+	assert_false(parse_filter_engine("unknown", &engine));
+
+	free_filter(&id_filter);
+	free_filter(&fast_blur_filter);
+	free_filter(&gaus_filter);
+	free_filter(&box_filter);
+	free_filter(&motion_filter);
+}
+
+/**
+ * Tests the tile size of filter chains: the halos of the filters add up and the
+ * tiles with their halo fit in the budget of the tile buffers.
+ */
+void test_chain_tile_size(void **state) {
+	(void)state;
+
+	struct filter filters[] = {
+		create_filter(BLUR_SIZE, BLUR_FACTOR, BLUR_BIAS, blur),
+		create_filter(MOTION_BLUR_SIZE, MOTION_BLUR_FACTOR, MOTION_BLUR_BIAS,
+					  motion_blur),
+	};
+	assert_non_null(filters[0].kernel);
+	assert_non_null(filters[1].kernel);
+	assert_int_equal(chain_halo(filters, 2), BLUR_SIZE / 2 + MOTION_BLUR_SIZE / 2);
+
+	int tile_width, tile_height;
+	chain_tile_size(filters, 2, 4000, &tile_width, &tile_height);
+	assert_int_equal(tile_width, CHAIN_TILE_WIDTH);
+	assert_true(tile_height >= CHAIN_MIN_TILE_HEIGHT);
+	assert_true((size_t)(6 * (tile_width + 2 * chain_halo(filters, 2)) *
+						 (tile_height + 2 * chain_halo(filters, 2))) <=
+				chain_tile_budget());
+
+	// Narrow images are processed in full rows
+	chain_tile_size(filters, 2, 100, &tile_width, &tile_height);
+	assert_int_equal(tile_width, 100);
+
+	free_filter(&filters[0]);
+	free_filter(&filters[1]);
+}
+
+/**
+ * Tests the planner of filter chains: filters whose output may be clamped are never
+ * composed with the next one, the chosen plan is at most as expensive as separate
+ * passes and the reference plan only has separate passes.
+ */
+void test_chain_planner(void **state) {
+	(void)state;
+
+	struct filter filters[] = {
+		create_filter(ID_SIZE, ID_FACTOR, ID_BIAS, id),
+		create_filter(ID_SIZE, ID_FACTOR, ID_BIAS, id),
+		create_filter(EDGE_DETECTION_SIZE, EDGE_DETECTION_FACTOR,
+					  EDGE_DETECTION_BIAS, edge_detection),
+		create_filter(BLUR_SIZE, BLUR_FACTOR, BLUR_BIAS, blur),
+	};
+	for (int i = 0; i < 4; i++) {
+		assert_non_null(filters[i].kernel);
+	}
+
+	assert_true(filter_output_in_range(&filters[0]));
+	assert_false(filter_output_in_range(&filters[2]));
+	assert_true(filter_gain(&filters[3]) <= CHAIN_MAX_COMPOSED_GAIN);
+	assert_false(filter_gain(&filters[2]) <= CHAIN_MAX_COMPOSED_GAIN);
+
+	struct chain_plan passes, plan;
+	assert_int_equal(plan_chain(filters, 4, 1000, 1000, true, &passes), 0);
+	for (int i = 0; i < 3; i++) {
+		assert_int_equal(passes.links[i], CHAIN_LINK_PASS);
+	}
+
+	assert_int_equal(plan_chain(filters, 4, 1000, 1000, false, &plan), 0);
+	assert_true(plan.cost <= passes.cost);
+	assert_int_equal(plan.links[0], CHAIN_LINK_COMPOSE);
+	assert_true(plan.links[2] != CHAIN_LINK_COMPOSE);
+
+	assert_int_equal(plan_chain(filters, CHAIN_MAX_FILTERS + 1, 1000, 1000, false,
+								&plan),
+					 -1);
+
+	for (int i = 0; i < 4; i++) {
+		free_filter(&filters[i]);
+	}
+}
+
+/**
+ * Tests that the composition of filters spreads the bias of the first filter over
+ * the kernel of the second one.
+ */
+void test_compose_filters_bias(void **state) {
+	(void)state;
+
+	struct filter emboss_filter =
+		create_filter(EMBOSS_SIZE, EMBOSS_FACTOR, EMBOSS_BIAS, emboss);
+	struct filter blur_filter =
+		create_filter(BLUR_SIZE, BLUR_FACTOR, BLUR_BIAS, blur);
+	assert_non_null(emboss_filter.kernel);
+	assert_non_null(blur_filter.kernel);
+
+	struct filter composed = compose_filters(&emboss_filter, &blur_filter);
+	assert_non_null(composed.kernel);
+	assert_int_equal(composed.size, EMBOSS_SIZE + BLUR_SIZE - 1);
+	assert_double_equal(composed.bias, EMBOSS_BIAS, 1e-9);
+
+	free_filter(&composed);
+	free_filter(&emboss_filter);
+	free_filter(&blur_filter);
+}
+
+/**
+ * Tests that the autotuner stores the fastest configuration in a new profile under
+ * the key of the filter and image size, finds it there on the next call, and that
+ * the last configuration stored under a key wins.
+ */
+void test_autotune_profile(void **state) {
+	(void)state;
+
+	struct filter filter = create_filter(3, 1.0, 0.0, fast_blur);
+	assert_non_null(filter.kernel);
+
+	struct autotune_key key;
+	make_autotune_key(&filter, 100, 50, 2, &key);
+	assert_int_equal(key.size_bucket, 12);
+	assert_int_equal(key.max_threads, 2);
+	assert_non_null(strstr(key.kernel_class, "-3x3"));
+
+	struct autotune_config config, stored;
+	bool cached = true;
+	assert_false(load_autotune_config(AUTOTUNE_TEST_PROFILE, &key, &config));
+	assert_int_equal(autotune(AUTOTUNE_TEST_PROFILE, &filter, 100, 50, 2, &config,
+							  &cached),
+					 0);
+	assert_false(cached);
+	assert_non_null(config.mode);
+	assert_in_range(config.num_threads, 1, 2);
+	assert_true(config.seconds >= 0);
+
+	assert_int_equal(autotune(AUTOTUNE_TEST_PROFILE, &filter, 120, 60, 2, &stored,
+							  &cached),
+					 0);
+	assert_true(cached);
+	assert_string_equal(stored.mode, config.mode);
+	assert_int_equal(stored.num_threads, config.num_threads);
+	assert_int_equal(stored.block_width, config.block_width);
+	assert_int_equal(stored.block_height, config.block_height);
+
+	struct autotune_config block = {"block", 2, 64, 16, 0.5};
+	assert_int_equal(save_autotune_config(AUTOTUNE_TEST_PROFILE, &key, &block), 0);
+	assert_true(load_autotune_config(AUTOTUNE_TEST_PROFILE, &key, &stored));
+	assert_string_equal(stored.mode, "block");
+	assert_int_equal(stored.block_width, 64);
+	assert_int_equal(stored.block_height, 16);
+
+	key.size_bucket++;
+	assert_false(load_autotune_config(AUTOTUNE_TEST_PROFILE, &key, &stored));
+
+	remove(AUTOTUNE_TEST_PROFILE);
+	remove(AUTOTUNE_TEST_DIR);
+	free_filter(&filter);
+}
+
+/**
+ * Tests the layout of the channels of `initialize_padded_image_rgb()`: rows start on
+ * cache lines, and the whole halo of each channel can be written without reaching
+ * into the next channel.
+ */
+void test_padded_image_layout(void **state) {
+	(void)state;
+
+	int widths[] = {1, CACHE_LINE_SIZE - 1, CACHE_LINE_SIZE, SIMD_TEST_WIDTH};
+	int halos[] = {0, 1, LARGE_KERNEL_SIZE / 2};
+
+	for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++) {
+		for (size_t h = 0; h < sizeof(halos) / sizeof(halos[0]); h++) {
+			int width = widths[w], height = 3, halo = halos[h];
+			struct image_rgb image =
+				initialize_padded_image_rgb(width, height, halo);
+			assert_non_null(image.red);
+			assert_int_equal(image.stride % CACHE_LINE_SIZE, 0);
+			assert_true(image.stride >= (size_t)(width + 2 * halo));
+
+			unsigned char *channels[] = {image.red, image.green, image.blue};
+			for (int c = 0; c < 3; c++) {
+				for (int y = -halo; y < height + halo; y++) {
+					unsigned char *row = channels[c] + y * (ptrdiff_t)image.stride;
+
+					assert_int_equal((uintptr_t)row % CACHE_LINE_SIZE, 0);
+					memset(row - halo, c + 1, width + 2 * halo);
+				}
+			}
+
+			// Each channel still holds its own value after all were written
+			for (int c = 0; c < 3; c++) {
+				assert_int_equal(channels[c][-halo * (ptrdiff_t)image.stride - halo],
+								 c + 1);
+				assert_int_equal(channels[c][(height + halo - 1) * image.stride +
+											 width + halo - 1],
+								 c + 1);
+			}
+
+			free_image_rgb(&image);
+			assert_null(image.red);
+			assert_int_equal(image.stride, 0);
+		}
+	}
+}
+
+/**
+ * Tests the positions the border modes read outside the image and the halo
+ * `fill_border()` fills with them, also when the halo is wider than the image.
+ */
+void test_border_modes(void **state) {
+	(void)state;
+
+	// Positions -4 to 6 around a row of three pixels
+	const size_t expected[][11] = {
+		[BORDER_WRAP] = {2, 0, 1, 2, 0, 1, 2, 0, 1, 2, 0},
+		[BORDER_CLAMP] = {0, 0, 0, 0, 0, 1, 2, 2, 2, 2, 2},
+		[BORDER_MIRROR] = {2, 2, 1, 0, 0, 1, 2, 2, 1, 0, 0},
+	};
+	for (int border = BORDER_WRAP; border <= BORDER_MIRROR; border++) {
+		for (int i = 0; i < 11; i++) {
+			assert_int_equal(border_position(i - 4, 3, border), expected[border][i]);
+		}
+	}
+
+	enum border_mode border;
+	assert_true(parse_border_mode("mirror", &border));
+	assert_int_equal(border, BORDER_MIRROR);
+	assert_string_equal(border_mode_name(BORDER_CONSTANT), "constant");
+	assert_false(parse_border_mode("reflect", &border));
+
+	int width = 3, height = 2, halo = BORDER_TEST_HALO;
+	for (border = BORDER_WRAP; border < NUM_BORDER_MODES; border++) {
+		struct image_rgb image = initialize_padded_image_rgb(width, height, halo);
+		assert_non_null(image.red);
+
+		for (int y = 0; y < height; y++) {
+			for (int x = 0; x < width; x++) {
+				image.red[y * image.stride + x] = 1 + y * width + x;
+				image.green[y * image.stride + x] = 2 * (1 + y * width + x);
+				image.blue[y * image.stride + x] = 3 * (1 + y * width + x);
+			}
+		}
+
+		fill_border(&image, width, height, border);
+
+		for (int y = -halo; y < height + halo; y++) {
+			for (int x = -halo; x < width + halo; x++) {
+				int value = 0;
+				if (border != BORDER_CONSTANT) {
+					value = 1 + (int)border_position(y, height, border) * width +
+							(int)border_position(x, width, border);
+				} else if (x >= 0 && x < width && y >= 0 && y < height) {
+					value = 1 + y * width + x;
+				}
+
+				ptrdiff_t index = y * (ptrdiff_t)image.stride + x;
+				assert_int_equal(image.red[index], value);
+				assert_int_equal(image.green[index], 2 * value);
+				assert_int_equal(image.blue[index], 3 * value);
+			}
+		}
+
+		free_image_rgb(&image);
+	}
+}
+
 /**
  * Tests the splitting of an image into RGB channels
  * (`split_image_into_rgb_channels()`) and reassembling it back into a single image
@@ -49,11 +859,16 @@ void test_split_assemble_channels(void **state) {
 	unsigned char expected_green[] = {0, 255, 0, 255};
 	unsigned char expected_blue[] = {0, 0, 255, 255};
 
-	assert_memory_equal(channel_image.red, expected_red, IMAGE_WIDTH * IMAGE_HEIGHT);
-	assert_memory_equal(channel_image.green, expected_green,
-						IMAGE_WIDTH * IMAGE_HEIGHT);
-	assert_memory_equal(channel_image.blue, expected_blue,
-						IMAGE_WIDTH * IMAGE_HEIGHT);
+	for (size_t y = 0; y < IMAGE_HEIGHT; y++) {
+		size_t row = y * channel_image.stride;
+
+		assert_memory_equal(channel_image.red + row, expected_red + y * IMAGE_WIDTH,
+							IMAGE_WIDTH);
+		assert_memory_equal(channel_image.green + row,
+							expected_green + y * IMAGE_WIDTH, IMAGE_WIDTH);
+		assert_memory_equal(channel_image.blue + row,
+							expected_blue + y * IMAGE_WIDTH, IMAGE_WIDTH);
+	}
 
 	unsigned char *assembled_image = malloc(IMAGE_WIDTH * IMAGE_HEIGHT * 3);
 	assert_non_null(assembled_image);
@@ -87,24 +902,230 @@ void test_identity_filter(void **state) {
 	sequential_application(&channel_image, &result_channel_image, IMAGE_WIDTH,
 						   IMAGE_HEIGHT, filter);
 
-	assert_memory_equal(channel_image.red, result_channel_image.red,
-						IMAGE_WIDTH * IMAGE_HEIGHT);
-	assert_memory_equal(channel_image.green, result_channel_image.green,
-						IMAGE_WIDTH * IMAGE_HEIGHT);
-	assert_memory_equal(channel_image.blue, result_channel_image.blue,
-						IMAGE_WIDTH * IMAGE_HEIGHT);
+	assert_true(compare_channels(&channel_image, &result_channel_image, IMAGE_WIDTH,
+								 IMAGE_HEIGHT));
 
 	free_filter(&filter);
 	free_image_rgb(&channel_image);
 	free_image_rgb(&result_channel_image);
 }
 
+// Counts the runs of a pool task
+static void *count_run(void *arg) {
+	atomic_fetch_add((atomic_int *)arg, 1);
+	return NULL;
+}
+
+// Runs nested tasks on the pool from a pool task
+static void *run_nested(void *arg) {
+	atomic_int *counters = (atomic_int *)arg;
+	assert_int_equal(thread_pool_run(count_run, counters, sizeof(atomic_int),
+									 POOL_TEST_NESTED),
+					 0);
+	return NULL;
+}
+
+/**
+ * Tests that `thread_pool_run()` runs a function exactly once per argument, also
+ * for tasks that run tasks of their own, and after the pool has been shut down.
+ */
+void test_thread_pool(void **state) {
+	(void)state;
+
+	for (int round = 0; round < 2; round++) {
+		atomic_int counters[POOL_TEST_TASKS];
+		for (int i = 0; i < POOL_TEST_TASKS; i++) {
+			atomic_init(&counters[i], 0);
+		}
+
+		assert_int_equal(thread_pool_run(count_run, counters, sizeof(atomic_int),
+										 POOL_TEST_TASKS),
+						 0);
+		for (int i = 0; i < POOL_TEST_TASKS; i++) {
+			assert_int_equal(atomic_load(&counters[i]), 1);
+		}
+
+		// Every nested run counts its own block of counters
+		assert_int_equal(thread_pool_run(run_nested, counters,
+										 POOL_TEST_NESTED * sizeof(atomic_int),
+										 POOL_TEST_TASKS / POOL_TEST_NESTED),
+						 0);
+		for (int i = 0; i < POOL_TEST_TASKS; i++) {
+			assert_int_equal(atomic_load(&counters[i]), 2);
+		}
+
+		thread_pool_shutdown();
+	}
+}
+
+// Records the thread running a pool task
+static void *record_thread(void *arg) {
+	*(pthread_t *)arg = pthread_self();
+	return NULL;
+}
+
+/**
+ * Tests that pinned threads of the pool follow the CPU order of the affinity policy
+ * and run the same argument index in every run, and that unpinning them restores
+ * the default placement.
+ */
+void test_thread_pool_affinity(void **state) {
+	(void)state;
+
+	for (int policy = AFFINITY_COMPACT; policy < NUM_AFFINITY_POLICIES; policy++) {
+		int cpus[AFFINITY_MAX_CPUS];
+		int num_cpus = affinity_cpu_order(policy, cpus, AFFINITY_MAX_CPUS);
+		assert_true(num_cpus > 0);
+
+		assert_int_equal(thread_pool_set_affinity(policy), 0);
+		for (int i = 0; i < AFFINITY_TEST_THREADS; i++) {
+			assert_int_equal(thread_pool_cpu(i), cpus[i % num_cpus]);
+		}
+
+		pthread_t first[AFFINITY_TEST_THREADS], second[AFFINITY_TEST_THREADS];
+		assert_int_equal(thread_pool_run(record_thread, first, sizeof(pthread_t),
+										 AFFINITY_TEST_THREADS),
+						 0);
+		assert_int_equal(thread_pool_run(record_thread, second, sizeof(pthread_t),
+										 AFFINITY_TEST_THREADS),
+						 0);
+
+		assert_true(pthread_equal(first[0], pthread_self()));
+		for (int i = 0; i < AFFINITY_TEST_THREADS; i++) {
+			assert_true(pthread_equal(first[i], second[i]));
+		}
+	}
+
+	assert_int_equal(thread_pool_set_affinity(AFFINITY_NONE), 0);
+	assert_int_equal(thread_pool_cpu(0), -1);
+	thread_pool_shutdown();
+}
+
+/**
+ * Tests that the owner of a `work_deque` takes the newest items while thieves steal
+ * the oldest ones, and that the deque is empty once all items are gone.
+ */
+void test_work_deque(void **state) {
+	(void)state;
+
+	struct work_deque deque;
+	assert_int_equal(work_deque_init(&deque, 4), 0);
+
+	assert_int_equal(work_deque_take(&deque), WORK_DEQUE_EMPTY);
+	assert_int_equal(work_deque_steal(&deque), WORK_DEQUE_EMPTY);
+
+	for (int item = 0; item < 4; item++) {
+		work_deque_push(&deque, item);
+	}
+
+	assert_int_equal(work_deque_take(&deque), 3);
+	assert_int_equal(work_deque_steal(&deque), 0);
+	assert_int_equal(work_deque_steal(&deque), 1);
+	assert_int_equal(work_deque_take(&deque), 2);
+	assert_int_equal(work_deque_take(&deque), WORK_DEQUE_EMPTY);
+	assert_int_equal(work_deque_steal(&deque), WORK_DEQUE_EMPTY);
+
+	// The buffer is circular, so the deque is reused past its capacity
+	for (int item = 4; item < 8; item++) {
+		work_deque_push(&deque, item);
+	}
+	assert_int_equal(work_deque_steal(&deque), 4);
+	assert_int_equal(work_deque_take(&deque), 7);
+
+	work_deque_free(&deque);
+}
+
+struct deque_test_data {
+	struct work_deque *deque;
+	atomic_int *taken; // Number of times each item was taken or stolen
+	bool owner;
+};
+
+// Empties the deque, taking items as its owner or stealing them
+static void *drain_deque(void *arg) {
+	struct deque_test_data *data = (struct deque_test_data *)arg;
+
+	while (1) {
+		int item = data->owner ? work_deque_take(data->deque)
+							   : work_deque_steal(data->deque);
+		if (item == WORK_DEQUE_EMPTY) {
+			break;
+		}
+		if (item >= 0) {
+			atomic_fetch_add(&data->taken[item], 1);
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Tests that items taken by the owner of a `work_deque` while other threads steal
+ * from it are each handed out exactly once.
+ */
+void test_work_deque_concurrent_steals(void **state) {
+	(void)state;
+
+	struct work_deque deque;
+	assert_int_equal(work_deque_init(&deque, DEQUE_TEST_ITEMS), 0);
+
+	atomic_int *taken = malloc(DEQUE_TEST_ITEMS * sizeof(atomic_int));
+	assert_non_null(taken);
+
+	for (int item = 0; item < DEQUE_TEST_ITEMS; item++) {
+		atomic_init(&taken[item], 0);
+		work_deque_push(&deque, item);
+	}
+
+	// The owner runs on the calling thread, the thieves on the pool
+	struct deque_test_data data[DEQUE_TEST_THREADS];
+	for (int i = 0; i < DEQUE_TEST_THREADS; i++) {
+		data[i] = (struct deque_test_data){
+			.deque = &deque, .taken = taken, .owner = i == 0};
+	}
+
+	assert_int_equal(thread_pool_run(drain_deque, data,
+									 sizeof(struct deque_test_data),
+									 DEQUE_TEST_THREADS),
+					 0);
+
+	for (int item = 0; item < DEQUE_TEST_ITEMS; item++) {
+		assert_int_equal(atomic_load(&taken[item]), 1);
+	}
+
+	free(taken);
+	work_deque_free(&deque);
+}
+
 int main(void) {
 	// Initialize random number generator with current time
 	srand((unsigned int)time(NULL));
 
 	const struct CMUnitTest core_tests[] = {
 		cmocka_unit_test(test_create_filter),
+		cmocka_unit_test(test_filter_storage),
+		cmocka_unit_test(test_box_filter_detection),
+		cmocka_unit_test(test_motion_blur_filter),
+		cmocka_unit_test(test_separable_filter_detection),
+		cmocka_unit_test(test_sparse_filter_taps),
+		cmocka_unit_test(test_fixed_point_filter_detection),
+		cmocka_unit_test(test_interior_bounds),
+		cmocka_unit_test(test_fft_crossover),
+		cmocka_unit_test(test_kernel_classification),
+		cmocka_unit_test(test_engine_choice),
+		cmocka_unit_test(test_chain_tile_size),
+		cmocka_unit_test(test_chain_planner),
+		cmocka_unit_test(test_compose_filters_bias),
+		cmocka_unit_test(test_simd_fixed_point_rows),
+		cmocka_unit_test(test_simd_line_rows),
+		cmocka_unit_test(test_simd_channel_kernels),
+		cmocka_unit_test(test_thread_pool),
+		cmocka_unit_test(test_thread_pool_affinity),
+		cmocka_unit_test(test_work_deque),
+		cmocka_unit_test(test_work_deque_concurrent_steals),
+		cmocka_unit_test(test_autotune_profile),
+		cmocka_unit_test(test_padded_image_layout),
+		cmocka_unit_test(test_border_modes),
 		cmocka_unit_test(test_split_assemble_channels),
 		cmocka_unit_test(test_identity_filter),
 	};
@@ -16,44 +16,40 @@ struct image_rgb initialize_and_check_image_rgb(int width, int height) {
 
 struct image_rgb create_test_image(int width, int height) {
 	struct image_rgb image = initialize_and_check_image_rgb(width, height);
-	for (size_t i = 0; i < (size_t)width * (size_t)height; i++) {
-		image.red[i] = rand() % 256;
-		image.green[i] = rand() % 256;
-		image.blue[i] = rand() % 256;
+	for (size_t y = 0; y < (size_t)height; y++) {
+		for (size_t i = y * image.stride; i < y * image.stride + width; i++) {
+			image.red[i] = rand() % 256;
+			image.green[i] = rand() % 256;
+			image.blue[i] = rand() % 256;
+		}
 	}
 	return image;
 }
 
 struct filter generate_random_filter(int size, double kernel[size][size]) {
-	struct filter random_filter;
-	random_filter.size = size;
-
-	random_filter.kernel = (double **)malloc(size * sizeof(double *));
-	assert_non_null(random_filter.kernel);
-
 	for (int i = 0; i < size; i++) {
-		random_filter.kernel[i] = (double *)malloc(size * sizeof(double));
-		assert_non_null(random_filter.kernel[i]);
-
 		for (int j = 0; j < size; j++) {
 			kernel[i][j] = (double)rand();
-			random_filter.kernel[i][j] = kernel[i][j];
 		}
 	}
 
-	random_filter.factor =
+	double factor =
 		MIN_FACTOR + ((double)rand() / RAND_MAX) * (MAX_FACTOR - MIN_FACTOR);
-	random_filter.bias = 0;
+
+	struct filter random_filter = create_filter(size, factor, 0, kernel);
+	assert_non_null(random_filter.kernel);
 
 	return random_filter;
 }
 
 bool compare_channels(struct image_rgb *expected, struct image_rgb *actual,
 					  int width, int height) {
-	for (size_t i = 0; i < (size_t)width * (size_t)height; i++) {
-		if (expected->red[i] != actual->red[i] ||
-			expected->green[i] != actual->green[i] ||
-			expected->blue[i] != actual->blue[i]) {
+	for (size_t y = 0; y < (size_t)height; y++) {
+		size_t e = y * expected->stride, a = y * actual->stride;
+
+		if (memcmp(expected->red + e, actual->red + a, width) != 0 ||
+			memcmp(expected->green + e, actual->green + a, width) != 0 ||
+			memcmp(expected->blue + e, actual->blue + a, width) != 0) {
 			return false;
 		}
 	}
@@ -62,11 +58,15 @@ bool compare_channels(struct image_rgb *expected, struct image_rgb *actual,
 
 bool compare_channels_with_epsilon(struct image_rgb *expected,
 								   struct image_rgb *actual, int width, int height) {
-	for (size_t i = 0; i < (size_t)width * (size_t)height; i++) {
-		if (expected->red[i] - actual->red[i] > 1 ||
-			expected->green[i] - actual->green[i] > 1 ||
-			expected->blue[i] - actual->blue[i] > 1) {
-			return false;
+	for (size_t y = 0; y < (size_t)height; y++) {
+		for (size_t x = 0; x < (size_t)width; x++) {
+			size_t e = y * expected->stride + x, a = y * actual->stride + x;
+
+			if (expected->red[e] - actual->red[a] > 1 ||
+				expected->green[e] - actual->green[a] > 1 ||
+				expected->blue[e] - actual->blue[a] > 1) {
+				return false;
+			}
 		}
 	}
 	return true;
@@ -78,7 +78,7 @@ void print_filter(const struct filter *filter, const char *name) {
 	for (int i = 0; i < filter->size; i++) {
 		printf("  {");
 		for (int j = 0; j < filter->size; j++) {
-			printf("%.1f", filter->kernel[i][j]);
+			printf("%.1f", filter->kernel[i * filter->size + j]);
 			if (j != filter->size - 1) {
 				printf(", ");
 			}
@@ -98,20 +98,20 @@ void print_filter(const struct filter *filter, const char *name) {
 void apply_zero_padding(struct filter *padded_filter,
 						struct filter *original_filter) {
 	// Filling the extended filter kernel with zeros
-	for (int i = 0; i < padded_filter->size; i++) {
-		for (int j = 0; j < padded_filter->size; j++) {
-			padded_filter->kernel[i][j] = 0.0;
-		}
+	for (int i = 0; i < padded_filter->size * padded_filter->size; i++) {
+		padded_filter->kernel[i] = 0.0;
 	}
 
 	// Copying the original filter to the center of the advanced filter
 	int offset = (padded_filter->size - original_filter->size) / 2;
 	for (int i = 0; i < original_filter->size; i++) {
 		for (int j = 0; j < original_filter->size; j++) {
-			padded_filter->kernel[i + offset][j + offset] =
-				original_filter->kernel[i][j];
+			padded_filter->kernel[(i + offset) * padded_filter->size + j + offset] =
+				original_filter->kernel[i * original_filter->size + j];
 		}
 	}
+
+	assert_int_equal(prepare_filter(padded_filter), 0);
 }
 
 void save_image(struct image_rgb image, int width, int height, char *test_name) {